@@ -43,6 +43,8 @@ devcall etherClose(device *devptr)
 
     etherControl(devptr, ETH_CTRL_RESET, 0, 0);
 
+    ethptr->rxPool = SYSERR;
+    ethptr->txwake = SYSERR;
     bfpfree(ethptr->inPool);
     bfpfree(ethptr->outPool);
 
@@ -12,6 +12,7 @@
 #include <ether.h>
 #include <ethernet.h>
 #include <network.h>
+#include <bufpool.h>
 
 /**
  * Control function for ethernet devices.
@@ -172,6 +173,45 @@ devcall etherControl(device *devptr, int func, long arg1, long arg2)
         addr->addr[5] = 0xFF;
         break;
 
+/* Attach (or with SYSERR, detach) a packet pool for recv handoff */
+    case NET_SET_RXPOOL:
+        if (SYSERR == arg1)
+        {
+            ethptr->rxPool = SYSERR;
+            break;
+        }
+        if (isbadpool(arg1)
+            || (bfptab[arg1].bufsize <
+                sizeof(struct packet) + ETH_RX_PKT_MAX))
+        {
+            return SYSERR;
+        }
+        ethptr->rxPool = arg1;
+        break;
+
+/* Hand a batch of received packets over to the caller */
+    case NET_RECV_POLL:
+        if ((SYSERR == ethptr->rxPool) || (ETH_STATE_UP != ethptr->state)
+            || (NULL == (struct packet **)arg1) || (arg2 <= 0))
+        {
+            return SYSERR;
+        }
+        return etherPoll(ethptr, (struct packet **)arg1, arg2);
+
+/* Set (or with SYSERR, clear) the semaphore to signal on Tx space */
+    case NET_SET_TXWAKE:
+        ethptr->txwake = arg1;
+        ethptr->txstall = FALSE;
+        break;
+
+/* Place a batch of frames on the Tx ring */
+    case NET_SEND_BATCH:
+        if ((NULL == (struct packet **)arg1) || (arg2 <= 0))
+        {
+            return SYSERR;
+        }
+        return etherSendBatch(ethptr, (struct packet **)arg1, arg2);
+
     default:
         return SYSERR;
     }
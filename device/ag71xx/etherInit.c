@@ -94,6 +94,9 @@ devcall etherInit(device *devptr)
     ethptr->istart = 0;
     ethptr->icount = 0;
     ethptr->ovrrun = 0;
+    ethptr->rxPool = SYSERR;
+    ethptr->txwake = SYSERR;
+    ethptr->txstall = FALSE;
     ethptr->rxOffset = ETH_PKT_RESERVE;
 
     // FIXME: Actual MAC lookup in nvram.
@@ -21,51 +21,21 @@
 extern int resdefer;
 
 /**
- * Receive packet interrupt handler.
+ * Receive packet interrupt handler.  Masks further receive interrupts
+ * and wakes a single poller, which drains the ring and unmasks them once
+ * it is empty (see etherPoll.c).
  */
 void rxPackets(struct ether *ethptr, struct ag71xx *nicptr)
 {
-    struct dmaDescriptor *dmaptr;
-    struct ethPktBuffer *pkt = NULL;
-    int head = 0;
-
-    while (1)
-    {
-        head = ethptr->rxHead % ETH_RX_RING_ENTRIES;
-        dmaptr = &ethptr->rxRing[head];
-        if (dmaptr->control & ETH_DESC_CTRL_EMPTY)
-        {
-            nicptr->rxStatus = RX_STAT_RECVD;
-            break;
-        }
-
-        pkt = ethptr->rxBufs[head];
-        pkt->length = dmaptr->control & ETH_DESC_CTRL_LEN;
-
-        if (ethptr->icount < ETH_IBLEN)
-        {
-            allocRxBuffer(ethptr, head);
-            ethptr->in[(ethptr->istart + ethptr->icount) % ETH_IBLEN] =
-                pkt;
-            ethptr->icount++;
-            signaln(ethptr->isema, 1);
-        }
-        else
-        {
-            ethptr->ovrrun++;
-            bzero(pkt->buf, pkt->length);
-        }
-
-        ethptr->rxHead++;
-        // Clear Rx interrupt.
-        nicptr->rxStatus = RX_STAT_RECVD;
-        // FIXME
-        break;
-    }
+    ethptr->interruptMask &= ~IRQ_RX_PKTRECV;
+    nicptr->interruptMask = ethptr->interruptMask;
+    signaln(ethptr->isema, 1);
 }
 
 /**
- * Transmit packet interrupt handler
+ * Transmit packet interrupt handler.  Reclaims every completed descriptor
+ * in one pass and, if a batch was cut short by a full ring, wakes the
+ * sender waiting for space.
  */
 void txPackets(struct ether *ethptr, struct ag71xx *nicptr)
 {
@@ -73,6 +43,7 @@ void txPackets(struct ether *ethptr, struct ag71xx *nicptr)
     struct ethPktBuffer **epb = NULL;
     struct ethPktBuffer *pkt = NULL;
     ulong head = 0;
+    int reclaimed = 0;
 
     // kprintf("txS=0x%08X\r\n", nicptr->txStatus);
     if (ethptr->txHead == ethptr->txTail)
@@ -96,6 +67,7 @@ void txPackets(struct ether *ethptr, struct ag71xx *nicptr)
         nicptr->txStatus = TX_STAT_SENT;
 
         ethptr->txHead++;
+        reclaimed++;
         pkt = *epb;
         if (NULL == pkt)
         {
@@ -104,6 +76,15 @@ void txPackets(struct ether *ethptr, struct ag71xx *nicptr)
         buffree((void *)((ulong)pkt & (PMEM_MASK | KSEG0_BASE)));
         *epb = NULL;
     }
+
+    if ((reclaimed > 0) && ethptr->txstall)
+    {
+        ethptr->txstall = FALSE;
+        if (SYSERR != ethptr->txwake)
+        {
+            signaln(ethptr->txwake, 1);
+        }
+    }
 }
 
 /**
@@ -65,8 +65,7 @@ devcall etherOpen(device *devptr)
     /* Allocate buffer pool for Rx DMA engine */
     ethptr->inPool =
         bfpalloc(ETH_RX_BUF_SIZE + ETH_PKT_RESERVE
-                 + sizeof(struct ethPktBuffer),
-                 ETH_RX_RING_ENTRIES + ETH_IBLEN);
+                 + sizeof(struct ethPktBuffer), ETH_RX_RING_ENTRIES);
     if (SYSERR == ethptr->inPool)
     {
         ETH_TRACE("eth%d inPool buffer error.\r\n", devptr->minor);
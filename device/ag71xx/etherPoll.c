@@ -0,0 +1,140 @@
+/**
+ * @file etherPoll.c
+ * @provides etherPoll, etherRxFrame, etherRxRearm.
+ *
+ * Receive is interrupt mitigated: the receive interrupt masks itself and
+ * signals isema once, and whichever thread takes that signal owns the Rx
+ * ring until it calls etherRxRearm().  Frames are copied out of their DMA
+ * buffers and the descriptors are reposted in place, so the ring never
+ * waits on the rest of the stack to return a buffer.
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <device.h>
+#include <mips.h>
+#include "ag71xx.h"
+#include <ether.h>
+#include <string.h>
+#include <interrupt.h>
+#include <bufpool.h>
+#include <network.h>
+
+/**
+ * Copy the frame at the head of the Rx ring and give its descriptor back
+ * to the DMA engine.  Caller must own the Rx ring.
+ * @param ethptr ethernet table entry
+ * @param buf buffer for the frame, or NULL to drop it
+ * @param len size of buf
+ * @return number of bytes copied, or SYSERR if the ring is empty
+ */
+int etherRxFrame(struct ether *ethptr, void *buf, uint len)
+{
+    struct ag71xx *nicptr = ethptr->csr;
+    struct dmaDescriptor *dmaptr;
+    struct ethPktBuffer *epb;
+    uint length;
+    int head;
+
+    head = ethptr->rxHead % ETH_RX_RING_ENTRIES;
+    dmaptr = &ethptr->rxRing[head];
+    if (dmaptr->control & ETH_DESC_CTRL_EMPTY)
+    {
+        return SYSERR;
+    }
+
+    epb = ethptr->rxBufs[head];
+    length = dmaptr->control & ETH_DESC_CTRL_LEN;
+    if (length > len)
+    {
+        length = len;
+    }
+    if (NULL != buf)
+    {
+        memcpy(buf, (uchar *)(((ulong)epb->buf) | KSEG1_BASE), length);
+    }
+
+    /* Repost the same DMA buffer and acknowledge the frame */
+    dmaptr->control = ETH_DESC_CTRL_EMPTY;
+    ethptr->rxHead++;
+    nicptr->rxStatus = RX_STAT_RECVD;
+
+    return length;
+}
+
+/**
+ * Give up ownership of the Rx ring.  If frames arrived while it was owned
+ * another poll is signalled straight away; otherwise the receive
+ * interrupt is unmasked.
+ * @param ethptr ethernet table entry
+ */
+void etherRxRearm(struct ether *ethptr)
+{
+    struct ag71xx *nicptr = ethptr->csr;
+    struct dmaDescriptor *dmaptr;
+    irqmask im;
+
+    im = disable();
+    dmaptr = &ethptr->rxRing[ethptr->rxHead % ETH_RX_RING_ENTRIES];
+    if (!(dmaptr->control & ETH_DESC_CTRL_EMPTY))
+    {
+        signaln(ethptr->isema, 1);
+    }
+    else if (ETH_STATE_UP == ethptr->state)
+    {
+        ethptr->interruptMask |= IRQ_RX_PKTRECV;
+        nicptr->interruptMask = ethptr->interruptMask;
+    }
+    restore(im);
+}
+
+/**
+ * Wait for received frames and hand up to budget of them off as packets
+ * from the attached receive pool.  Frames that arrive while the pool is
+ * exhausted are dropped at the ring and counted as overruns.
+ * @param ethptr ethernet table entry
+ * @param pkts array to fill with received packets
+ * @param budget maximum number of frames to take this pass
+ * @return number of packets placed in pkts
+ */
+int etherPoll(struct ether *ethptr, struct packet **pkts, int budget)
+{
+    struct packet *pkt;
+    int work, npkts, len;
+
+    wait(ethptr->isema);
+
+    npkts = 0;
+    for (work = 0; work < budget; work++)
+    {
+        if (semcount(bfptab[ethptr->rxPool].freebuf) <= 0)
+        {
+            if (SYSERR == etherRxFrame(ethptr, NULL, 0))
+            {
+                break;
+            }
+            ethptr->ovrrun++;
+            continue;
+        }
+
+        pkt = bufget(ethptr->rxPool);
+        if (SYSERR == (int)pkt)
+        {
+            break;
+        }
+        len = etherRxFrame(ethptr, pkt->data, ETH_RX_PKT_MAX);
+        if (SYSERR == len)
+        {
+            buffree(pkt);
+            break;
+        }
+        pkt->len = len;
+        pkts[npkts++] = pkt;
+    }
+
+    etherRxRearm(ethptr);
+
+    return npkts;
+}
@@ -1,6 +1,6 @@
 /**
  * @file etherWrite.c
- * @provides etherWrite.
+ * @provides etherWrite, etherSendBatch.
  *
  * $Id: etherWrite.c 2147 2009-12-19 07:23:03Z svn $
  */
@@ -18,32 +18,22 @@
 #include <network.h>
 
 /**
- * Write a packet to the ethernet device
- * @param devptr device table entry
- * @param buf packet buffer
- * @param len size of the buffer
- * @return number of bytes sent from input buffer
+ * Copy a frame onto the next free Tx descriptor without starting the DMA
+ * engine.  Must be called with interrupts disabled.
+ * @param ethptr ethernet table entry
+ * @param buf frame to send
+ * @param len length of the frame
+ * @return OK if the frame was placed on the ring, SYSERR if it is full
  */
-devcall etherWrite(device *devptr, void *buf, uint len)
+static int etherTxFrame(struct ether *ethptr, void *buf, uint len)
 {
-    struct ether *ethptr = NULL;
-    struct ag71xx *nicptr = NULL;
     struct ethPktBuffer *pkt = NULL;
     struct dmaDescriptor *dmaptr = NULL;
-    irqmask im;
     ulong tail = 0;
-    uchar *buffer = buf;
-/* 	ulong *flushControl = (ulong *)0xB800007C; */
-
-    ethptr = &ethertab[devptr->minor];
-    nicptr = ethptr->csr;
 
-    im = disable();
-    if ((ETH_STATE_UP != ethptr->state)
-        || (len < ETH_HEADER_LEN)
-        || (len > (ETH_TX_BUF_SIZE - ETH_VLAN_LEN)))
+    /* Slots are reused only once txPackets() has reclaimed them */
+    if (ethptr->txTail - ethptr->txHead >= ETH_TX_RING_ENTRIES)
     {
-        restore(im);
         return SYSERR;
     }
 
@@ -53,8 +43,6 @@ devcall etherWrite(device *devptr, void *buf, uint len)
     if (!(dmaptr->control & ETH_DESC_CTRL_EMPTY))
     {
         ETH_TRACE("dmaptr 0x%08X not empty.\r\n", dmaptr);
-        ethptr->errors++;
-        restore(im);
         return SYSERR;
     }
 
@@ -62,8 +50,6 @@ devcall etherWrite(device *devptr, void *buf, uint len)
     if (SYSERR == (ulong)pkt)
     {
         ETH_TRACE("etherWrite() couldn't get a buffer!\r\n");
-        ethptr->errors++;
-        restore(im);
         return SYSERR;
     }
 
@@ -71,26 +57,123 @@ devcall etherWrite(device *devptr, void *buf, uint len)
     pkt = (struct ethPktBuffer *)((int)pkt | KSEG1_BASE);
     pkt->buf = (uchar *)(pkt + 1);
     pkt->data = pkt->buf;
-    memcpy(pkt->data, buffer, len);
+    memcpy(pkt->data, buf, len);
 
     /* Place filled buffer in outgoing queue */
     ethptr->txBufs[tail] = pkt;
 
     /* Add this buffer to the Tx ring. */
     /* Address on ring should be physical (USEG) for DMA engine */
-    ethptr->txRing[tail].address = (ulong)pkt->data & PMEM_MASK;
+    dmaptr->address = (ulong)pkt->data & PMEM_MASK;
     /* Clear empty flag and write the length */
-    ethptr->txRing[tail].control = len & ETH_DESC_CTRL_LEN;
+    dmaptr->control = len & ETH_DESC_CTRL_LEN;
 
     ethptr->txTail++;
 
+    return OK;
+}
+
+/**
+ * Ring the Tx doorbell once for every descriptor filled since first.
+ * Must be called with interrupts disabled.
+ * @param ethptr ethernet table entry
+ * @param first Tx ring index of the first newly filled descriptor
+ */
+static void etherTxKick(struct ether *ethptr, ulong first)
+{
+    struct ag71xx *nicptr = ethptr->csr;
+
     if (nicptr->txStatus & TX_STAT_UNDER)
     {
-        nicptr->txDMA = ((ulong)(ethptr->txRing + tail)) & PMEM_MASK;
+        nicptr->txDMA = ((ulong)(ethptr->txRing + first)) & PMEM_MASK;
         nicptr->txStatus = TX_STAT_UNDER;
     }
     nicptr->txControl = TX_CTRL_ENABLE;
+    ethptr->txkicks++;
+}
+
+/**
+ * Write a packet to the ethernet device
+ * @param devptr device table entry
+ * @param buf packet buffer
+ * @param len size of the buffer
+ * @return number of bytes sent from input buffer
+ */
+devcall etherWrite(device *devptr, void *buf, uint len)
+{
+    struct ether *ethptr = NULL;
+    irqmask im;
+    ulong first = 0;
+
+    ethptr = &ethertab[devptr->minor];
+
+    im = disable();
+    if ((ETH_STATE_UP != ethptr->state)
+        || (len < ETH_HEADER_LEN)
+        || (len > (ETH_TX_BUF_SIZE - ETH_VLAN_LEN)))
+    {
+        restore(im);
+        return SYSERR;
+    }
+
+    first = ethptr->txTail % ETH_TX_RING_ENTRIES;
+    if (SYSERR == etherTxFrame(ethptr, buf, len))
+    {
+        ethptr->errors++;
+        restore(im);
+        return SYSERR;
+    }
+    etherTxKick(ethptr, first);
     restore(im);
 
     return len;
 }
+
+/**
+ * Place a batch of frames on the Tx ring and start the DMA engine once.
+ * Frames of invalid length are consumed and counted as errors.  If the
+ * ring fills before the batch is done, the Tx wake semaphore is signalled
+ * when completions free space.
+ * @param ethptr ethernet table entry
+ * @param pkts frames to send, each from curr for len bytes
+ * @param npkts number of frames in pkts
+ * @return number of frames consumed from the front of pkts
+ */
+int etherSendBatch(struct ether *ethptr, struct packet **pkts, int npkts)
+{
+    irqmask im;
+    ulong first = 0;
+    int i, placed = 0;
+
+    im = disable();
+    if (ETH_STATE_UP != ethptr->state)
+    {
+        restore(im);
+        return SYSERR;
+    }
+
+    first = ethptr->txTail % ETH_TX_RING_ENTRIES;
+    for (i = 0; i < npkts; i++)
+    {
+        if ((pkts[i]->len < ETH_HEADER_LEN)
+            || (pkts[i]->len > (ETH_TX_BUF_SIZE - ETH_VLAN_LEN)))
+        {
+            ethptr->errors++;
+            continue;
+        }
+        if (SYSERR == etherTxFrame(ethptr, pkts[i]->curr, pkts[i]->len))
+        {
+            ethptr->txstall = TRUE;
+            break;
+        }
+        placed++;
+    }
+
+    if (placed > 0)
+    {
+        etherTxKick(ethptr, first);
+    }
+    restore(im);
+
+    return i;
+}
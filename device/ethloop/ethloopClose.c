@@ -10,6 +10,7 @@
 #include <bufpool.h>
 #include <device.h>
 #include <ethloop.h>
+#include <network.h>
 #include <semaphore.h>
 #include <interrupt.h>
 
@@ -34,6 +35,12 @@ devcall ethloopClose(device *devptr)
         return SYSERR;
     }
 
+    /* return frames queued for recv handoff to their pool */
+    if (SYSERR != elpptr->rxpool)
+    {
+        ethloopControl(devptr, NET_SET_RXPOOL, SYSERR, 0);
+    }
+
     /* free the semaphore */
     semfree(elpptr->sem);
 
@@ -32,6 +32,9 @@ devcall ethloopControl(device *devptr, int func, long arg1, long arg2)
     char *buf;
     char *hold;
     int holdlen;
+    struct packet *pkt;
+    struct packet **pkts;
+    int npkts;
 
     elpptr = &elooptab[devptr->minor];
 
@@ -82,6 +85,98 @@ devcall ethloopControl(device *devptr, int func, long arg1, long arg2)
         restore(im);
         return ELOOP_MTU;
 
+/* Attach (or with SYSERR, detach) a packet pool for recv handoff */
+    case NET_SET_RXPOOL:
+        if (SYSERR == arg1)
+        {
+            /* Queued frames belong to the old pool; discard them */
+            while (elpptr->count > 0)
+            {
+                buffree(elpptr->buffer[elpptr->index]);
+                elpptr->buffer[elpptr->index] = NULL;
+                elpptr->pktlen[elpptr->index] = 0;
+                elpptr->count--;
+                elpptr->index = (elpptr->index + 1) % ELOOP_NBUF;
+            }
+            while (semcount(elpptr->sem) > 0)
+            {
+                wait(elpptr->sem);
+            }
+            elpptr->rxpool = SYSERR;
+            break;
+        }
+        /* Pool must hold a full frame and the queue must not be mixed */
+        if (isbadpool(arg1)
+            || (bfptab[arg1].bufsize < sizeof(struct packet) + ELOOP_BUFSIZE)
+            || (elpptr->count > 0))
+        {
+            restore(im);
+            return SYSERR;
+        }
+        elpptr->rxpool = arg1;
+        break;
+
+/* Hand a batch of received packets over to the caller */
+    case NET_RECV_POLL:
+        pkts = (struct packet **)arg1;
+        if ((SYSERR == elpptr->rxpool) || (NULL == pkts) || (arg2 <= 0))
+        {
+            restore(im);
+            return SYSERR;
+        }
+        /* Block for the first frame, then take what is already queued */
+        wait(elpptr->sem);
+        npkts = 0;
+        do
+        {
+            pkt = (struct packet *)elpptr->buffer[elpptr->index];
+            elpptr->buffer[elpptr->index] = NULL;
+            elpptr->pktlen[elpptr->index] = 0;
+            elpptr->count--;
+            elpptr->index = (elpptr->index + 1) % ELOOP_NBUF;
+            if (NULL != pkt)
+            {
+                pkts[npkts++] = pkt;
+            }
+        }
+        while ((npkts < arg2) && (semcount(elpptr->sem) > 0)
+               && (OK == wait(elpptr->sem)));
+        /* Wake a batch sender that found the queue full */
+        if (elpptr->txstall && (SYSERR != elpptr->txwake))
+        {
+            elpptr->txstall = FALSE;
+            signal(elpptr->txwake);
+        }
+        restore(im);
+        return npkts;
+
+/* Set (or with SYSERR, clear) the semaphore to signal on queue space */
+    case NET_SET_TXWAKE:
+        elpptr->txwake = arg1;
+        elpptr->txstall = FALSE;
+        break;
+
+/* Queue a batch of frames, stopping when the queue is full */
+    case NET_SEND_BATCH:
+        pkts = (struct packet **)arg1;
+        if ((NULL == pkts) || (arg2 <= 0))
+        {
+            restore(im);
+            return SYSERR;
+        }
+        for (npkts = 0; npkts < arg2; npkts++)
+        {
+            if (elpptr->count >= ELOOP_NBUF)
+            {
+                elpptr->txstall = TRUE;
+                break;
+            }
+            /* Frames write() refuses for other reasons are dropped */
+            ethloopWrite(devptr, pkts[npkts]->curr, pkts[npkts]->len);
+        }
+        restore(im);
+        return npkts;
+
 /* Get next packet off hold queue */
     case ELOOP_CTRL_GETHOLD:
         buf = (char *)arg1;
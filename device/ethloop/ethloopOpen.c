@@ -57,6 +57,11 @@ devcall ethloopOpen(device *devptr)
     elpptr->holdlen = 0;
     elpptr->count = 0;
 
+    /* Packets are copied out by read until a pool is handed over */
+    elpptr->rxpool = SYSERR;
+    elpptr->txwake = SYSERR;
+    elpptr->txstall = FALSE;
+
     /* Allocate a buffer pool */
     elpptr->poolid = bfpalloc(ELOOP_BUFSIZE, ELOOP_NBUF);
     if (SYSERR == elpptr->poolid)
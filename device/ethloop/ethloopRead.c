@@ -11,6 +11,7 @@
 #include <device.h>
 #include <ethloop.h>
 #include <interrupt.h>
+#include <network.h>
 #include <string.h>
 
 /**
@@ -25,6 +26,7 @@ devcall ethloopRead(device *devptr, void *buf, uint len)
     struct ethloop *elpptr;
     irqmask im;
     char *pkt;
+    char *data;
     int pktlen;
 
     elpptr = &elooptab[devptr->minor];
@@ -45,6 +47,20 @@ devcall ethloopRead(device *devptr, void *buf, uint len)
     elpptr->pktlen[elpptr->index] = 0;
     elpptr->count--;
     elpptr->index = (elpptr->index + 1) % ELOOP_NBUF;
+
+    /* With a recv pool attached, queued frames live in packet buffers */
+    data = pkt;
+    if (SYSERR != elpptr->rxpool)
+    {
+        data = (char *)((struct packet *)pkt)->data;
+    }
+
+    /* Wake a batch sender that found the queue full */
+    if (elpptr->txstall && (SYSERR != elpptr->txwake))
+    {
+        elpptr->txstall = FALSE;
+        signal(elpptr->txwake);
+    }
     restore(im);
 
     if (len < pktlen)
@@ -52,7 +68,7 @@ devcall ethloopRead(device *devptr, void *buf, uint len)
         pktlen = len;
     }
 
-    memcpy(buf, pkt, pktlen);
+    memcpy(buf, data, pktlen);
     buffree(pkt);
 
     return pktlen;
@@ -11,6 +11,7 @@
 #include <device.h>
 #include <ethloop.h>
 #include <interrupt.h>
+#include <network.h>
 #include <string.h>
 
 /**
@@ -23,6 +24,7 @@
 devcall ethloopWrite(device *devptr, void *buf, uint len)
 {
     struct ethloop *elpptr;
+    struct packet *rxpkt;
     irqmask im;
     int index;
     char *pkt;
@@ -41,16 +43,6 @@ devcall ethloopWrite(device *devptr, void *buf, uint len)
         return SYSERR;
     }
 
-    /* Allocate buffer space */
-    pkt = (char *)bufget(elpptr->poolid);
-    if (SYSERR == (int)pkt)
-    {
-        return SYSERR;
-    }
-
-    /* Copy supplied buffer into allocated buffer */
-    memcpy(pkt, buf, len);
-
     /* Drop packet if drop flags(s) are set */
     if ((elpptr->flags & ELOOP_FLAG_DROPNXT)
         || (elpptr->flags & ELOOP_FLAG_DROPALL))
@@ -63,6 +55,14 @@ devcall ethloopWrite(device *devptr, void *buf, uint len)
     /* Hold next packet if flags is set */
     if (elpptr->flags & ELOOP_FLAG_HOLDNXT)
     {
+        pkt = (char *)bufget(elpptr->poolid);
+        if (SYSERR == (int)pkt)
+        {
+            restore(im);
+            return SYSERR;
+        }
+        memcpy(pkt, buf, len);
+
         elpptr->flags &= ~ELOOP_FLAG_HOLDNXT;
         if (elpptr->hold != NULL)
         {
@@ -82,6 +82,35 @@ devcall ethloopWrite(device *devptr, void *buf, uint len)
         return SYSERR;
     }
 
+    if (SYSERR != elpptr->rxpool)
+    {
+        /* Receive straight into a packet buffer that will be handed to
+         * the network stack.  Like a NIC with no posted buffers, drop
+         * the frame rather than wait when the pool is exhausted. */
+        if (semcount(bfptab[elpptr->rxpool].freebuf) <= 0)
+        {
+            restore(im);
+            return SYSERR;
+        }
+        rxpkt = (struct packet *)bufget(elpptr->rxpool);
+        memcpy(rxpkt->data, buf, len);
+        rxpkt->len = len;
+        pkt = (char *)rxpkt;
+    }
+    else
+    {
+        /* Allocate buffer space */
+        pkt = (char *)bufget(elpptr->poolid);
+        if (SYSERR == (int)pkt)
+        {
+            restore(im);
+            return SYSERR;
+        }
+
+        /* Copy supplied buffer into allocated buffer */
+        memcpy(pkt, buf, len);
+    }
+
     index = (elpptr->count + elpptr->index) % ELOOP_NBUF;
 
     /* Add to buffer */
@@ -15,6 +15,7 @@
 struct http httptab[NHTTP];
 semaphore maxhttp = -1;
 semaphore activeXWeb = -1;
+int httplisten = SYSERR;
 
 /* Shell command and its length */
 const struct httpcmd httpcmdtab[] = {
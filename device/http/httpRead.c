@@ -12,6 +12,7 @@
 #include <http.h>
 #include <shell.h>
 #include <string.h>
+#include <tcp.h>
 
 /* TODO: ensure all headers that need to be parsed are */
 
@@ -261,6 +262,9 @@ devcall httpRead(device *devptr, void *buf, uint len)
         }
     }
 
+    /* Hold the headers and top of page until they fill segments */
+    control(phw->num, TCP_CTRL_CORK, NULL, NULL);
+
     /* Write headers */
     httpControl(devptr, HTTP_CTRL_CLR_FLAG, HTTP_FLAG_CHUNKED, NULL);
     httpControl(devptr, HTTP_CTRL_SET_FLAG, HTTP_FLAG_CONCLOSE, NULL);
@@ -304,6 +308,7 @@ devcall httpRead(device *devptr, void *buf, uint len)
 
     /* Flush write buffer, transmitting webpage topping parts */
     httpFlushWBuffer(devptr);
+    control(phw->num, TCP_CTRL_UNCORK, NULL, NULL);
 
     /* Clear write buffer */
     httpControl(devptr, HTTP_CTRL_SET_FLAG, HTTP_FLAG_CLEARWOUT, NULL);
@@ -17,7 +17,7 @@
 
 
 thread killHttpServer(uint, tid_typ, uint);
-thread httpServer(int, int);
+thread httpServer(int);
 
 /**
  * HTTP server kick start thread
@@ -25,7 +25,7 @@ thread httpServer(int, int);
  */
 thread httpServerKickStart(int netDescrp)
 {
-    int tcpdev;
+    struct netif *nif;
     char thrname[TNMLEN];
     int tid;
     int cursem;
@@ -41,17 +41,40 @@ thread httpServerKickStart(int netDescrp)
         return SYSERR;
     }
 
+    /* Look up the network descriptor */
+    nif = netLookup(netDescrp);
+    if (SYSERR == (int)nif)
+    {
+        fprintf(stderr, "%s is not associated with an active network",
+                devtab[netDescrp].name);
+        fprintf(stderr, " interface.\n");
+        return SYSERR;
+    }
+
     /* Allocate TCP device */
-    tcpdev = tcpAlloc();
-    if (isbadtcp(tcpdev))
+    httplisten = tcpAlloc();
+    if (isbadtcp(httplisten))
     {
+        httplisten = SYSERR;
         fprintf(stderr, "No TCP devices available for initialization.\n");
         return SYSERR;
     }
 
-    sprintf(thrname, "XWeb_%d\0", (devtab[tcpdev].minor));
+    /* Listen once; connections arriving while every server thread is
+     * busy wait to be accepted rather than being reset */
+    if ((SYSERR == control(httplisten, TCP_CTRL_LISTEN, NHTTP, 0))
+        || (SYSERR == (long)open(httplisten, &nif->ip, NULL,
+                                 HTTP_LOCAL_PORT, NULL, TCP_PASSIVE)))
+    {
+        fprintf(stderr, "tcpOpen SYSERR, devnum: %d\n", httplisten);
+        close(httplisten);
+        httplisten = SYSERR;
+        return SYSERR;
+    }
+
+    sprintf(thrname, "XWeb_%d\0", (devtab[httplisten].minor));
     tid = create((void *)httpServer, INITSTK, INITPRIO, thrname,
-                 2, netDescrp, tcpdev);
+                 1, httplisten);
     ready(tid, RESCHED_NO);
 
     return tid;
@@ -59,24 +82,35 @@ thread httpServerKickStart(int netDescrp)
 
 /**
  * HTTP server thread
- * @param host IP address of interface on which to listen
- * @param gentcpdev the allocated tcp device for general listening
+ * @param lsndev listening TCP device to accept a connection from
  * @return OK or SYSERR
  */
-thread httpServer(int netDescrp, int gentcpdev)
+thread httpServer(int lsndev)
 {
     tid_typ shelltid, killtid;
     int tcpdev, httpdev;
     char thrname[TNMLEN];
-    bool noGenHTTP;
-    struct netaddr *host;
-    struct netif *nif;
 
     enable();
 
-    noGenHTTP = FALSE;
     wait(maxhttp);              /* Make sure max HTTP threads not reached */
 
+    /* Wait for a connection */
+    tcpdev = control(lsndev, TCP_CTRL_ACCEPT, 0, 0);
+    if (isbadtcp(tcpdev))
+    {
+        signal(maxhttp);
+        return SYSERR;
+    }
+
+    /* Spawn the thread that serves the next connection */
+    if (semcount(activeXWeb) <= 0)
+    {
+        sprintf(thrname, "XWeb_%d\0", (devtab[tcpdev].minor));
+        ready(create((void *)httpServer, INITSTK, INITPRIO,
+                     thrname, 1, lsndev), RESCHED_NO);
+    }
+
     /* Allocate HTTP device */
     httpdev = httpAlloc();
 
@@ -84,24 +118,11 @@ thread httpServer(int netDescrp, int gentcpdev)
     if (isbadhttp(httpdev))
     {
         printf("failed to allocate proper HTTP device\n");
+        close(tcpdev);
         signal(maxhttp);
         return SYSERR;
     }
 
-    /* Back up the general tcpdev number */
-    tcpdev = gentcpdev;
-
-    /* Look up the network descriptor */
-    nif = netLookup(netDescrp);
-    if (SYSERR == (int)nif)
-    {
-        fprintf(stderr, "%s is not associated with an active network",
-                devtab[netDescrp].name);
-        fprintf(stderr, " interface.\n");
-        return SYSERR;
-    }
-    host = &(nif->ip);
-
     /* Open HTTP device */
     if (SYSERR == (long)open(httpdev, tcpdev))
     {
@@ -132,59 +153,6 @@ thread httpServer(int netDescrp, int gentcpdev)
     ready(shelltid, RESCHED_NO);
     ready(killtid, RESCHED_NO);
 
-    /* Open TCP device */
-    if (SYSERR ==
-        (long)open(tcpdev, host, NULL, HTTP_LOCAL_PORT, NULL,
-                   TCP_PASSIVE))
-    {
-        int temp;
-        sleep(TCP_TWOMSL + 500);
-        if (SYSERR ==
-            (temp = (long)open(tcpdev, host, NULL, HTTP_LOCAL_PORT, NULL,
-                               TCP_PASSIVE)))
-        {
-            fprintf(CONSOLE, "open returns: %d\n", temp);
-            fprintf(stderr, "tcpOpen SYSERR, devnum: %d\n", tcpdev);
-            kill(shelltid);
-            close(tcpdev);
-            close(httpdev);
-            return SYSERR;
-        }
-        fprintf(CONSOLE, "open returns: %d\n", temp);
-    }
-
-    /* Allocate TCP device */
-    gentcpdev = tcpAlloc();
-    if (isbadtcp(gentcpdev))
-    {
-        /* Wait for a free http device */
-        wait(maxhttp);
-
-        /* Acquire a TCP device through allocation */
-        while ((ushort)SYSERR == (gentcpdev = tcpAlloc()))
-        {
-            /* Do nothing, yield processor */
-            yield();
-        }
-
-        /* Everything acquired, spawn general http device listener */
-        if (semcount(activeXWeb) <= 0)
-        {
-            sprintf(thrname, "XWeb_%d\0", (devtab[gentcpdev].minor));
-            ready(create((void *)httpServer, INITSTK, INITPRIO,
-                         thrname, 2, netDescrp, gentcpdev), RESCHED_NO);
-        }
-
-        /* Did not consume http device, just waited for availability */
-        signal(maxhttp);
-    }
-    else
-    {
-        sprintf(thrname, "XWeb_%d\0", (devtab[gentcpdev].minor));
-        ready(create((void *)httpServer, INITSTK, INITPRIO,
-                     thrname, 2, netDescrp, gentcpdev), RESCHED_NO);
-    }
-
     return OK;
 }
 
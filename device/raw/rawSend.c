@@ -94,7 +94,7 @@ syscall rawSend(struct raw *rawptr, void *buf, uint len)
         case NETADDR_IPv4:
             RAW_TRACE("Send via IPv4");
             result = ipv4Send(pkt, &rawptr->localip, &rawptr->remoteip,
-                              rawptr->proto);
+                              rawptr->proto, NULL);
             break;
         default:
             result = SYSERR;
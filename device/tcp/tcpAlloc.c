@@ -14,7 +14,7 @@
  * Allocate an available tcp device.
  * @return device number for a tcp device, SYSERR if none are free
  */
-ushort tcpAlloc(void)
+int tcpAlloc(void)
 {
     int i;
 
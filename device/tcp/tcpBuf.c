@@ -0,0 +1,251 @@
+/**
+ * @file tcpBuf.c
+ * @provides tcpBufAlloc, tcpBufFree, tcpBufGrowIn, tcpBufGrowOut,
+ *           tcpBufTrim
+ *
+ * Input and output buffers start small and double, up to the limit set
+ * for the connection, when they are what holds a transfer back.  They
+ * shrink again when their limit is lowered or free memory runs low.
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <memory.h>
+#include <string.h>
+#include <tcp.h>
+
+/**
+ * Move a circular buffer into one of a new size, starting at index 0.
+ * Octets past the end of the new buffer are lost.
+ */
+static int ringResize(uchar **buf, uint *len, uint start, uint newlen)
+{
+    uchar *fresh;
+    uint keep, first;
+
+    fresh = memget(newlen);
+    if (SYSERR == (int)fresh)
+    {
+        return SYSERR;
+    }
+
+    keep = (newlen < *len) ? newlen : *len;
+    first = *len - start;
+    if (first > keep)
+    {
+        first = keep;
+    }
+    memcpy(fresh, *buf + start, first);
+    memcpy(fresh + first, *buf, keep - first);
+
+    memfree(*buf, *len);
+    *buf = fresh;
+    *len = newlen;
+    return OK;
+}
+
+/**
+ * Smallest size that holds need octets and the size a buffer is kept to,
+ * or 0 if the buffer is no bigger than that or halving it would not.
+ */
+static uint trimLen(uint len, uint need, uint target)
+{
+    uint newlen;
+
+    newlen = (need + 0x7) & ~0x7;
+    if (newlen < target)
+    {
+        newlen = target;
+    }
+    if ((newlen >= len) || ((newlen > (len >> 1)) && (newlen != target)))
+    {
+        return 0;
+    }
+    return newlen;
+}
+
+/**
+ * Allocate the input and output buffers for a connection at their
+ * initial sizes, replacing any it already has.
+ * @param tcbptr pointer to transmission control block for connection
+ * @return OK if both buffers are allocated, otherwise SYSERR
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+int tcpBufAlloc(struct tcb *tcbptr)
+{
+    tcpBufFree(tcbptr);
+
+    if (0 == tcbptr->ilimit)
+    {
+        tcbptr->ilimit = TCP_BUFLIM;
+    }
+    if (0 == tcbptr->olimit)
+    {
+        tcbptr->olimit = TCP_BUFLIM;
+    }
+    tcbptr->ilen = (TCP_IBLEN < tcbptr->ilimit) ? TCP_IBLEN : tcbptr->ilimit;
+    tcbptr->olen = (TCP_OBLEN < tcbptr->olimit) ? TCP_OBLEN : tcbptr->olimit;
+
+    tcbptr->in = memget(tcbptr->ilen);
+    tcbptr->out = memget(tcbptr->olen);
+    if ((SYSERR == (int)tcbptr->in) || (SYSERR == (int)tcbptr->out))
+    {
+        if (SYSERR == (int)tcbptr->in)
+        {
+            tcbptr->in = NULL;
+        }
+        if (SYSERR == (int)tcbptr->out)
+        {
+            tcbptr->out = NULL;
+        }
+        tcpBufFree(tcbptr);
+        return SYSERR;
+    }
+
+    return OK;
+}
+
+/**
+ * Free the input and output buffers of a connection.
+ * @param tcbptr pointer to transmission control block for connection
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+void tcpBufFree(struct tcb *tcbptr)
+{
+    if (NULL != tcbptr->in)
+    {
+        memfree(tcbptr->in, tcbptr->ilen);
+        tcbptr->in = NULL;
+    }
+    tcbptr->ilen = 0;
+    if (NULL != tcbptr->out)
+    {
+        memfree(tcbptr->out, tcbptr->olen);
+        tcbptr->out = NULL;
+    }
+    tcbptr->olen = 0;
+}
+
+/**
+ * Double the input buffer of a connection, up to its limit and to the
+ * largest window the agreed window scale can advertise.  Data held past
+ * a gap keeps its place.
+ * @param tcbptr pointer to transmission control block for connection
+ * @return OK if the buffer grew, otherwise SYSERR
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+int tcpBufGrowIn(struct tcb *tcbptr)
+{
+    uint limit, len;
+
+    limit = (TCP_MAX_WND << tcbptr->rcvwsc) & ~0x7;
+    if (limit > tcbptr->ilimit)
+    {
+        limit = tcbptr->ilimit;
+    }
+    if ((NULL == tcbptr->in) || (tcbptr->ilen >= limit))
+    {
+        return SYSERR;
+    }
+
+    len = tcbptr->ilen << 1;
+    if (len > limit)
+    {
+        len = limit;
+    }
+    if (memlist.length < TCP_BUFLOWMEM + len)
+    {
+        return SYSERR;
+    }
+
+    if (SYSERR == ringResize(&tcbptr->in, &tcbptr->ilen, tcbptr->istart,
+                             len))
+    {
+        return SYSERR;
+    }
+    tcbptr->istart = 0;
+    TCP_TRACE("Input buffer grew to %u", len);
+    return OK;
+}
+
+/**
+ * Double the output buffer of a connection, up to its limit.
+ * @param tcbptr pointer to transmission control block for connection
+ * @return OK if the buffer grew, otherwise SYSERR
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+int tcpBufGrowOut(struct tcb *tcbptr)
+{
+    uint len;
+
+    if ((NULL == tcbptr->out) || (tcbptr->olen >= tcbptr->olimit))
+    {
+        return SYSERR;
+    }
+
+    len = tcbptr->olen << 1;
+    if (len > tcbptr->olimit)
+    {
+        len = tcbptr->olimit;
+    }
+    if (memlist.length < TCP_BUFLOWMEM + len)
+    {
+        return SYSERR;
+    }
+
+    if (SYSERR == ringResize(&tcbptr->out, &tcbptr->olen, tcbptr->ostart,
+                             len))
+    {
+        return SYSERR;
+    }
+    tcbptr->ostart = 0;
+    TCP_TRACE("Output buffer grew to %u", len);
+    return OK;
+}
+
+/**
+ * Shrink the buffers of a connection that are bigger than they are being
+ * kept to, as far as the data they hold allows.  The input buffer keeps
+ * room for all of the window already advertised.
+ * @param tcbptr pointer to transmission control block for connection
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+void tcpBufTrim(struct tcb *tcbptr)
+{
+    uint need, len;
+
+    if (NULL != tcbptr->in)
+    {
+        need = tcbptr->icount;
+        if (seqlt(tcbptr->rcvnxt, tcbptr->rcvwnd))
+        {
+            need += tcpSeqdiff(tcbptr->rcvwnd, tcbptr->rcvnxt);
+        }
+        len = trimLen(tcbptr->ilen, need, tcpBufTarget(tcbptr->ilimit));
+        if ((len > 0) && (OK == ringResize(&tcbptr->in, &tcbptr->ilen,
+                                           tcbptr->istart, len)))
+        {
+            tcbptr->istart = 0;
+            TCP_TRACE("Input buffer shrank to %u", len);
+        }
+    }
+
+    if (NULL != tcbptr->out)
+    {
+        len = trimLen(tcbptr->olen, tcbptr->ocount,
+                      tcpBufTarget(tcbptr->olimit));
+        if ((len > 0) && (OK == ringResize(&tcbptr->out, &tcbptr->olen,
+                                           tcbptr->ostart, len)))
+        {
+            tcbptr->ostart = 0;
+            TCP_TRACE("Output buffer shrank to %u", len);
+        }
+    }
+}
@@ -43,25 +43,31 @@ devcall tcpClose(device *devptr)
         {
             signaln(tcbptr->readers, semcount(tcbptr->readers) * -1);
         }
+        /* Reset connections a listening socket has not handed out */
+        if (tcbptr->backlog > 0)
+        {
+            tcpListenClose(tcbptr);
+        }
+        /* Freeing releases the mutex and there is nothing to wait for */
         tcpFree(tcbptr);
-        break;
+        return OK;
     case TCP_SYNRECV:
-        tcbptr->sndfin = seqadd(tcbptr->snduna, tcbptr->ocount);
+        tcbptr->sndfin = seqadd(tcbptr->snduna, tcpOutPending(tcbptr));
         tcbptr->sndflg |= TCP_FLG_FIN;
-        if (0 == tcbptr->ocount)
+        if (0 == tcpOutPending(tcbptr))
         {
             tcbptr->sndflg |= TCP_FLG_SNDDATA;
             tcbptr->state = TCP_FINWT1;
         }
         break;
     case TCP_ESTAB:
-        tcbptr->sndfin = seqadd(tcbptr->snduna, tcbptr->ocount);
+        tcbptr->sndfin = seqadd(tcbptr->snduna, tcpOutPending(tcbptr));
         tcbptr->sndflg |= TCP_FLG_FIN;
         tcbptr->sndflg |= TCP_FLG_SNDDATA;
         tcbptr->state = TCP_FINWT1;
         break;
     case TCP_CLOSEWT:
-        tcbptr->sndfin = seqadd(tcbptr->snduna, tcbptr->ocount);
+        tcbptr->sndfin = seqadd(tcbptr->snduna, tcpOutPending(tcbptr));
         tcbptr->sndflg |= TCP_FLG_FIN;
         tcbptr->sndflg |= TCP_FLG_SNDDATA;
         tcbptr->state = TCP_LASTACK;
@@ -2,8 +2,14 @@
 
 #include <device.h>
 #include <stddef.h>
+#include <string.h>
+#include <tar.h>
 #include <tcp.h>
 
+static uint bufLimit(long);
+static void flush(struct tcb *);
+static ushort synLimit(ushort, long);
+
 /**
  * Control function for TCP devices.
  * @param devptr ethernet device table entry
@@ -34,6 +40,129 @@ devcall tcpControl(device *devptr, int func, long arg1, long arg2)
         signal(tcbptr->mutex);
         return bytes;
 
+        /* Set most octets input buffer grows to; set before opening, it
+         * also picks the window scale offered to the remote side */
+    case TCP_CTRL_RCVBUF:
+        tcbptr->ilimit = bufLimit(arg1);
+        tcpBufTrim(tcbptr);
+        signal(tcbptr->mutex);
+        return OK;
+
+        /* Set most octets output buffer grows to */
+    case TCP_CTRL_SNDBUF:
+        tcbptr->olimit = bufLimit(arg1);
+        tcpBufTrim(tcbptr);
+        signal(tcbptr->mutex);
+        return OK;
+
+        /* Set ms to delay ACKs of in-order data, 0 to ACK each segment */
+    case TCP_CTRL_DELACK:
+        if (arg1 <= 0)
+        {
+            tcbptr->delack = 0;
+        }
+        else if (arg1 < TCP_DELACK_MIN)
+        {
+            tcbptr->delack = TCP_DELACK_MIN;
+        }
+        else if (arg1 > TCP_DELACK_MAX)
+        {
+            tcbptr->delack = TCP_DELACK_MAX;
+        }
+        else
+        {
+            tcbptr->delack = arg1;
+        }
+        signal(tcbptr->mutex);
+        return OK;
+
+        /* Send small segments at once (TRUE) rather than coalesce them
+         * while data is unacknowledged */
+    case TCP_CTRL_NODELAY:
+        if (arg1)
+        {
+            tcbptr->sndflg |= TCP_FLG_NODELAY;
+            flush(tcbptr);
+        }
+        else
+        {
+            tcbptr->sndflg &= ~TCP_FLG_NODELAY;
+        }
+        signal(tcbptr->mutex);
+        return OK;
+
+        /* Hold data back until it fills a segment, or until uncorked */
+    case TCP_CTRL_CORK:
+        tcbptr->sndflg |= TCP_FLG_CORK;
+        signal(tcbptr->mutex);
+        return OK;
+
+        /* Send what was held back while corked, even a small segment
+         * Nagle would hold */
+    case TCP_CTRL_UNCORK:
+        tcbptr->sndflg &= ~TCP_FLG_CORK;
+        tcbptr->sndflg |= TCP_FLG_PUSH;
+        flush(tcbptr);
+        signal(tcbptr->mutex);
+        return OK;
+
+        /* Return from read and write with what is available (TRUE)
+         * rather than wait for all of the buffer */
+    case TCP_CTRL_NONBLOCK:
+        if (arg1)
+        {
+            tcbptr->sndflg |= TCP_FLG_NONBLOCK;
+        }
+        else
+        {
+            tcbptr->sndflg &= ~TCP_FLG_NONBLOCK;
+        }
+        signal(tcbptr->mutex);
+        return OK;
+
+        /* Before a passive open, make it a listening socket that queues
+         * up to arg1 connections for accept and arg2 half-open ones (0
+         * for twice arg1) */
+    case TCP_CTRL_LISTEN:
+        if ((TCP_CLOSED != tcbptr->state) || (arg1 <= 0))
+        {
+            signal(tcbptr->mutex);
+            return SYSERR;
+        }
+        tcbptr->backlog = (arg1 < TCP_BACKLOG_MAX) ? arg1 : TCP_BACKLOG_MAX;
+        tcbptr->synmax = synLimit(tcbptr->backlog, arg2);
+        signal(tcbptr->mutex);
+        return OK;
+
+        /* Wait for a connection on a listening socket, get its device */
+    case TCP_CTRL_ACCEPT:
+        signal(tcbptr->mutex);
+        return tcpAccept(tcbptr);
+
+        /* Copy round trip and congestion instrumentation to the struct
+         * tcpInstr arg1 points to */
+    case TCP_CTRL_INSTR:
+        if (NULL == (void *)arg1)
+        {
+            signal(tcbptr->mutex);
+            return SYSERR;
+        }
+        memcpy((void *)arg1, &tcbptr->instr, sizeof(struct tcpInstr));
+        signal(tcbptr->mutex);
+        return sizeof(struct tcpInstr);
+
+        /* Send a file of the tar archive straight from the archive, arg1
+         * its header as tarGetFile finds it */
+    case TCP_CTRL_SENDFILE:
+        signal(tcbptr->mutex);
+        if (NULL == (struct tar *)arg1)
+        {
+            return SYSERR;
+        }
+        return tcpSendfile(tcbptr,
+                           (uchar *)tarGetDataAddr((struct tar *)arg1),
+                           tarGetFilesize((struct tar *)arg1));
+
         /* Unrecongnized control function */
     default:
         signal(tcbptr->mutex);
@@ -43,3 +172,53 @@ devcall tcpControl(device *devptr, int func, long arg1, long arg2)
     signal(tcbptr->mutex);
     return SYSERR;
 }
+
+/**
+ * Fit a requested buffer limit between the smallest and largest allowed,
+ * as a multiple of 8.
+ */
+static uint bufLimit(long limit)
+{
+    if (limit < TCP_BUFMIN)
+    {
+        return TCP_BUFMIN;
+    }
+    if (limit > TCP_BUFMAX)
+    {
+        return TCP_BUFMAX;
+    }
+    return limit & ~0x7;
+}
+
+/**
+ * Send data held back by the sending mode just changed, if the
+ * connection is sending data.
+ */
+static void flush(struct tcb *tcbptr)
+{
+    if ((TCP_ESTAB == tcbptr->state) || (TCP_CLOSEWT == tcbptr->state))
+    {
+        tcpSendData(tcbptr);
+    }
+}
+
+/**
+ * Fit a requested SYN queue length between 1 and the most allowed, which
+ * leaves at least half of the TCBs out of reach of half-open connections
+ * to one listener.
+ */
+static ushort synLimit(ushort backlog, long len)
+{
+    long max;
+
+    max = (NTCP / 2 < TCP_SYNQ_MAX) ? NTCP / 2 : TCP_SYNQ_MAX;
+    if (len <= 0)
+    {
+        len = backlog * 2;
+    }
+    if (len > max)
+    {
+        len = max;
+    }
+    return (len < 1) ? 1 : len;
+}
@@ -14,54 +14,14 @@
 struct tcb *tcpDemux(ushort dstpt, ushort srcpt, struct netaddr *dstip,
                      struct netaddr *srcip)
 {
-    struct tcb *tcbptr = NULL;
-    uint i;
-    uint level = 0;
+    struct tcpHashEnt *ent;
 
-    /* Cycle through all tcp devices to find the best match */
-    for (i = 0; i < NTCP; i++)
+    /* Every open TCB is filed in the hash, so no TCB needs locking */
+    ent = tcpHashLookup(&tcphash, dstpt, srcpt, dstip, srcip);
+    if (NULL == ent)
     {
-        wait(tcptab[i].mutex);
-        if (tcptab[i].state != TCP_CLOSED)
-        {
-            /* Full match is the best */
-            if (level < 3
-                && (tcptab[i].localpt == dstpt)
-                && (tcptab[i].remotept == srcpt)
-                && (netaddrequal(&tcptab[i].localip, dstip))
-                && (netaddrequal(&tcptab[i].remoteip, srcip)))
-            {
-                tcbptr = &tcptab[i];
-                level = 3;
-                TCP_TRACE("Level 3 match, socket %d", i);
-            }
-
-            /* Src and dst ports match */
-            if (level < 2
-                && (tcptab[i].localpt == dstpt)
-                && (tcptab[i].remotept == srcpt)
-                && (netaddrequal(&tcptab[i].localip, dstip))
-                && (tcptab[i].remoteip.type == NULL))
-            {
-                tcbptr = &tcptab[i];
-                level = 2;
-                TCP_TRACE("Level 2 match, socket %d", i);
-            }
-
-            /* Dst ports match is last */
-            if (level < 1
-                && (tcptab[i].localpt == dstpt)
-                && (tcptab[i].remotept == NULL)
-                && (netaddrequal(&tcptab[i].localip, dstip))
-                && (tcptab[i].remoteip.type == NULL))
-            {
-                tcbptr = &tcptab[i];
-                level = 1;
-                TCP_TRACE("Level 1 match, socket %d", i);
-            }
-        }
-        signal(tcptab[i].mutex);
+        return NULL;
     }
-
-    return tcbptr;
+    TCP_TRACE("Matched socket %d", ent->tcbptr - tcptab);
+    return ent->tcbptr;
 }
@@ -33,7 +33,17 @@ devcall tcpFree(struct tcb *tcbptr)
     semfree(tcbptr->openclose);
     semfree(tcbptr->readers);
     semfree(tcbptr->writers);
+    if (tcbptr->backlog > 0)
+    {
+        semfree(tcbptr->accepts);   /* Wakes any accept with SYSERR */
+    }
+    if (NULL != tcbptr->listener)
+    {
+        tcpListenRemove(tcbptr);
+    }
     tcpTimerPurge(tcbptr, NULL);
+    tcpHashRemove(&tcphash, &tcbptr->hash);
+    tcpBufFree(tcbptr);
     bzero(tcbptr, sizeof(struct tcb));  /* Clear tcp structure. */
     tcbptr->state = TCP_CLOSED;
     tcbptr->devstate = TCP_FREE;
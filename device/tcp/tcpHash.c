@@ -0,0 +1,173 @@
+/**
+ * @file tcpHash.c
+ * @provides tcpHashInsert, tcpHashRemove, tcpHashLookup, tcpHashUpdate
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <interrupt.h>
+#include <network.h>
+#include <tcp.h>
+
+struct tcpHashTab tcphash;
+
+#define isconn(ent) \
+    ((NULL != (ent)->remotept) && (NULL != (ent)->remoteip.type))
+#define listenhash(pt)  ((pt) & (TCP_NLHASH - 1))
+
+/**
+ * Compute the connection bucket for a 4-tuple.  The local IP is left
+ * out; a host rarely has more than one and it is checked on lookup.
+ */
+static uint connhash(ushort localpt, ushort remotept,
+                     struct netaddr *remoteip)
+{
+    uint h;
+    int i;
+
+    h = ((uint)localpt << 16) | remotept;
+    for (i = 0; i < remoteip->len; i++)
+    {
+        h = (h * 31) + remoteip->addr[i];
+    }
+    h ^= h >> 16;
+    h ^= h >> 8;
+    return h & (TCP_NHASH - 1);
+}
+
+/**
+ * Return the head of the bucket an entry belongs in.
+ */
+static struct tcpHashEnt **bucket(struct tcpHashTab *tab,
+                                  struct tcpHashEnt *ent)
+{
+    if (isconn(ent))
+    {
+        return &tab->conn[connhash(ent->localpt, ent->remotept,
+                                   &ent->remoteip)];
+    }
+    return &tab->listen[listenhash(ent->localpt)];
+}
+
+/**
+ * Add an entry to a demultiplexing hash.  The entry's keys must not
+ * change until it is removed.
+ * @param tab hash tables to add to
+ * @param ent entry, with keys and tcbptr filled in
+ */
+void tcpHashInsert(struct tcpHashTab *tab, struct tcpHashEnt *ent)
+{
+    struct tcpHashEnt **head;
+    irqmask im;
+
+    im = disable();
+    head = bucket(tab, ent);
+    ent->next = *head;
+    *head = ent;
+    restore(im);
+}
+
+/**
+ * Remove an entry from a demultiplexing hash, if it is present.
+ * @param tab hash tables to remove from
+ * @param ent entry to remove
+ */
+void tcpHashRemove(struct tcpHashTab *tab, struct tcpHashEnt *ent)
+{
+    struct tcpHashEnt **link;
+    irqmask im;
+
+    im = disable();
+    for (link = bucket(tab, ent); NULL != *link; link = &(*link)->next)
+    {
+        if (*link == ent)
+        {
+            *link = ent->next;
+            ent->next = NULL;
+            break;
+        }
+    }
+    restore(im);
+}
+
+/**
+ * Find the entry that best matches an incoming segment.  An exact
+ * 4-tuple match wins, then a listener bound to the remote port, then a
+ * listener on the local port alone.
+ * @param tab hash tables to search
+ * @param dstpt destination port of the segment
+ * @param srcpt source port of the segment
+ * @param dstip destination IP of the segment
+ * @param srcip source IP of the segment
+ * @return most completely matched entry, NULL if no match
+ */
+struct tcpHashEnt *tcpHashLookup(struct tcpHashTab *tab, ushort dstpt,
+                                 ushort srcpt, struct netaddr *dstip,
+                                 struct netaddr *srcip)
+{
+    struct tcpHashEnt *ent;
+    struct tcpHashEnt *any = NULL;
+    irqmask im;
+
+    im = disable();
+
+    /* Full match is the best */
+    ent = tab->conn[connhash(dstpt, srcpt, srcip)];
+    for (; NULL != ent; ent = ent->next)
+    {
+        if ((ent->localpt == dstpt) && (ent->remotept == srcpt)
+            && netaddrequal(&ent->remoteip, srcip)
+            && netaddrequal(&ent->localip, dstip))
+        {
+            restore(im);
+            return ent;
+        }
+    }
+
+    /* Then a listener bound to the source port, then any listener */
+    ent = tab->listen[listenhash(dstpt)];
+    for (; NULL != ent; ent = ent->next)
+    {
+        if ((ent->localpt != dstpt) || (NULL != ent->remoteip.type)
+            || !netaddrequal(&ent->localip, dstip))
+        {
+            continue;
+        }
+        if (ent->remotept == srcpt)
+        {
+            restore(im);
+            return ent;
+        }
+        if (NULL == ent->remotept)
+        {
+            any = ent;
+        }
+    }
+
+    restore(im);
+    return any;
+}
+
+/**
+ * File a TCB in the demultiplexing hash under its current connection
+ * details, moving it if it was already filed.
+ * @param tcbptr pointer to transmission control block for connection
+ * @pre-condition TCB mutex is already held
+ */
+void tcpHashUpdate(struct tcb *tcbptr)
+{
+    struct tcpHashEnt *ent = &tcbptr->hash;
+    irqmask im;
+
+    im = disable();
+    tcpHashRemove(&tcphash, ent);
+    ent->tcbptr = tcbptr;
+    ent->localpt = tcbptr->localpt;
+    ent->remotept = tcbptr->remotept;
+    netaddrcpy(&ent->localip, &tcbptr->localip);
+    netaddrcpy(&ent->remoteip, &tcbptr->remoteip);
+    tcpHashInsert(&tcphash, ent);
+    restore(im);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file tcpInstr.c
+ * @provides tcpInstrRtt, tcpInstrTrace
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <tcp.h>
+
+/**
+ * Count a round trip measurement in the histogram, and take a sample of
+ * the estimate it gives.
+ * @param tcbptr pointer to transmission control block for connection
+ * @param rtt round trip time in microseconds
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+void tcpInstrRtt(struct tcb *tcbptr, int rtt)
+{
+    struct tcpInstr *instr = &tcbptr->instr;
+    int bucket, limit;
+
+    /* Each bucket holds round trips four times as long as the last */
+    limit = 1000;
+    for (bucket = 0; bucket < TCP_NRTTHIST - 1; bucket++)
+    {
+        if (rtt < limit)
+        {
+            break;
+        }
+        limit <<= 2;
+    }
+    instr->rtthist[bucket]++;
+
+    if ((0 == instr->rttsamples) || (rtt < instr->rttmin))
+    {
+        instr->rttmin = rtt;
+    }
+    if (rtt > instr->rttmax)
+    {
+        instr->rttmax = rtt;
+    }
+    instr->rttsamples++;
+
+    tcpInstrTrace(tcbptr, TCP_TRC_RTT);
+}
+
+/**
+ * Take a sample of the congestion window and round trip estimate,
+ * overwriting the oldest sample kept.
+ * @param tcbptr pointer to transmission control block for connection
+ * @param event what the sample is taken on, TCP_TRC_*
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+void tcpInstrTrace(struct tcb *tcbptr, uint event)
+{
+    struct tcpTrace *trc;
+
+    trc = &tcbptr->instr.trace[tcbptr->instr.ntrace % TCP_NTRACE];
+    trc->tick = tcpTimerNow();
+    trc->event = event;
+    trc->cwnd = tcbptr->sndcwn;
+    trc->ssthresh = tcbptr->sndsst;
+    trc->srtt = tcbptr->sndrtt >> 3;
+    trc->rttvar = tcbptr->sndrtd >> 2;
+    tcbptr->instr.ntrace++;
+}
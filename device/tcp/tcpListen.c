@@ -0,0 +1,309 @@
+/**
+ * @file tcpListen.c
+ * @provides tcpListenSyn, tcpListenEstab, tcpListenRemove, tcpListenClose,
+ *           tcpAccept
+ *
+ * A listening socket stays in the LISTEN state and gives each SYN it
+ * takes a TCB of its own.  Half-open connections wait in the SYN queue,
+ * which is kept short so a flood of SYNs cannot take every TCB; when it
+ * is full the oldest is pushed out.  Established connections wait in the
+ * accept queue until tcpAccept hands out their devices.
+ *
+ * Locks are taken listener first, then connection: functions here wait
+ * for a queued connection's mutex while holding the listener's.  No path
+ * holding a connection's mutex takes its listener's; the queues are only
+ * changed with interrupts disabled.
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <interrupt.h>
+#include <network.h>
+#include <semaphore.h>
+#include <tcp.h>
+
+/**
+ * Add a TCB to the end of a listener's queue.
+ * @pre-condition interrupts are disabled
+ */
+static void qadd(struct tcb **head, struct tcb *tcbptr)
+{
+    while (NULL != *head)
+    {
+        head = &(*head)->qnext;
+    }
+    tcbptr->qnext = NULL;
+    *head = tcbptr;
+}
+
+/**
+ * Take a TCB out of a listener's queue.
+ * @return TRUE if the TCB was in the queue, otherwise FALSE
+ * @pre-condition interrupts are disabled
+ */
+static bool qremove(struct tcb **head, struct tcb *tcbptr)
+{
+    for (; NULL != *head; head = &(*head)->qnext)
+    {
+        if (*head == tcbptr)
+        {
+            *head = tcbptr->qnext;
+            tcbptr->qnext = NULL;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * Take a free TCB, with its mutex held on return.  A free TCB whose mutex
+ * is held, as tcpAlloc or tcpFree are at work on it, is passed over
+ * rather than waited for.
+ * @return pointer to the TCB, NULL if none are free
+ */
+static struct tcb *tcbTake(void)
+{
+    struct tcb *tcbptr;
+    irqmask im;
+    int i;
+
+    im = disable();
+    for (i = 0; i < NTCP; i++)
+    {
+        tcbptr = &tcptab[i];
+        if ((TCP_FREE == tcbptr->devstate)
+            && (semcount(tcbptr->mutex) > 0))
+        {
+            wait(tcbptr->mutex);
+            tcbptr->devstate = TCP_ALLOC;
+            tcbptr->dev = i + TCP0;
+            restore(im);
+            return tcbptr;
+        }
+    }
+    restore(im);
+    return NULL;
+}
+
+/**
+ * Push the oldest half-open connection out of a listener's SYN queue.
+ * @param lsnptr pointer to transmission control block for listener
+ * @pre-condition listener mutex is already held
+ * @post-condition listener mutex is still held
+ */
+static void synPushOut(struct tcb *lsnptr)
+{
+    struct tcb *tcbptr;
+    irqmask im;
+
+    im = disable();
+    tcbptr = lsnptr->synq;
+    restore(im);
+    if (NULL == tcbptr)
+    {
+        return;
+    }
+
+    wait(tcbptr->mutex);
+    if ((lsnptr == tcbptr->listener) && (TCP_SYNRECV == tcbptr->state))
+    {
+        TCP_TRACE("SYN queue full, dropping oldest");
+        lsnptr->syndrops++;
+        tcpFree(tcbptr);
+        return;
+    }
+    signal(tcbptr->mutex);
+}
+
+/**
+ * Give a SYN arriving at a listening socket a TCB of its own, in the
+ * LISTEN state and connected to the sender.  The SYN is dropped, and the
+ * sender left to try again, while the accept queue is full or no TCB is
+ * free.
+ * @param lsnptr pointer to transmission control block for listener
+ * @param src source IP address of the SYN
+ * @param srcpt source port of the SYN
+ * @return pointer to the new TCB with its mutex held, NULL if dropped
+ * @pre-condition listener mutex is already held
+ * @post-condition listener mutex is still held
+ */
+struct tcb *tcpListenSyn(struct tcb *lsnptr, struct netaddr *src,
+                         ushort srcpt)
+{
+    struct tcb *tcbptr;
+    irqmask im;
+
+    if (lsnptr->acceptlen >= lsnptr->backlog)
+    {
+        TCP_TRACE("Accept queue full");
+        lsnptr->syndrops++;
+        return NULL;
+    }
+    if (lsnptr->synlen >= lsnptr->synmax)
+    {
+        synPushOut(lsnptr);
+    }
+
+    tcbptr = tcbTake();
+    if (NULL == tcbptr)
+    {
+        TCP_TRACE("No TCB free for SYN");
+        lsnptr->syndrops++;
+        return NULL;
+    }
+
+    /* Connect it to the sender, sending the way the listener does */
+    tcbptr->localpt = lsnptr->localpt;
+    netaddrcpy(&tcbptr->localip, &lsnptr->localip);
+    tcbptr->remotept = srcpt;
+    netaddrcpy(&tcbptr->remoteip, src);
+    tcbptr->opentype = TCP_PASSIVE;
+    tcbptr->state = TCP_LISTEN;
+    tcbptr->ilimit = lsnptr->ilimit;
+    tcbptr->olimit = lsnptr->olimit;
+    tcbptr->sndflg = lsnptr->sndflg & (TCP_FLG_NODELAY | TCP_FLG_CORK);
+    if (SYSERR == tcpSetup(tcbptr))
+    {
+        tcpFree(tcbptr);
+        lsnptr->syndrops++;
+        return NULL;
+    }
+    tcbptr->delack = lsnptr->delack;
+
+    im = disable();
+    tcbptr->listener = lsnptr;
+    qadd(&lsnptr->synq, tcbptr);
+    lsnptr->synlen++;
+    restore(im);
+
+    tcpHashUpdate(tcbptr);
+    return tcbptr;
+}
+
+/**
+ * Move a connection that was just established from its listener's SYN
+ * queue to the accept queue.
+ * @param tcbptr pointer to transmission control block for connection
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+void tcpListenEstab(struct tcb *tcbptr)
+{
+    struct tcb *lsnptr;
+    irqmask im;
+
+    im = disable();
+    lsnptr = tcbptr->listener;
+    if (qremove(&lsnptr->synq, tcbptr))
+    {
+        lsnptr->synlen--;
+    }
+    qadd(&lsnptr->acceptq, tcbptr);
+    lsnptr->acceptlen++;
+    restore(im);
+
+    signal(lsnptr->accepts);
+}
+
+/**
+ * Take a connection that has not been accepted out of its listener's
+ * queues, as it is freed.
+ * @param tcbptr pointer to transmission control block for connection
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+void tcpListenRemove(struct tcb *tcbptr)
+{
+    struct tcb *lsnptr;
+    irqmask im;
+
+    im = disable();
+    lsnptr = tcbptr->listener;
+    if (qremove(&lsnptr->synq, tcbptr))
+    {
+        lsnptr->synlen--;
+    }
+    else if (qremove(&lsnptr->acceptq, tcbptr))
+    {
+        lsnptr->acceptlen--;
+    }
+    tcbptr->listener = NULL;
+    restore(im);
+}
+
+/**
+ * Reset and free every connection still queued on a listener, as it is
+ * closed.
+ * @param lsnptr pointer to transmission control block for listener
+ * @pre-condition listener mutex is already held
+ * @post-condition listener mutex is still held
+ */
+void tcpListenClose(struct tcb *lsnptr)
+{
+    struct tcb *tcbptr;
+    irqmask im;
+
+    while (TRUE)
+    {
+        im = disable();
+        tcbptr = (NULL != lsnptr->synq) ? lsnptr->synq : lsnptr->acceptq;
+        restore(im);
+        if (NULL == tcbptr)
+        {
+            return;
+        }
+
+        wait(tcbptr->mutex);
+        if (lsnptr == tcbptr->listener)
+        {
+            tcpSend(tcbptr, TCP_CTRL_RST, tcbptr->sndnxt, 0, 0, 0);
+            tcpFree(tcbptr);
+        }
+        else
+        {
+            signal(tcbptr->mutex);
+        }
+    }
+}
+
+/**
+ * Wait for a listening socket to establish a connection and hand it
+ * out.  Connections reset while waiting to be accepted are skipped.
+ * @param lsnptr pointer to transmission control block for listener
+ * @return device of the connection, SYSERR if not listening
+ * @pre-condition listener mutex is not held
+ */
+int tcpAccept(struct tcb *lsnptr)
+{
+    struct tcb *tcbptr;
+    irqmask im;
+
+    while (TRUE)
+    {
+        if ((0 == lsnptr->backlog) || (SYSERR == wait(lsnptr->accepts)))
+        {
+            return SYSERR;
+        }
+
+        im = disable();
+        if ((TCP_LISTEN != lsnptr->state) || (0 == lsnptr->backlog))
+        {
+            restore(im);
+            return SYSERR;
+        }
+        tcbptr = lsnptr->acceptq;
+        if (NULL != tcbptr)
+        {
+            lsnptr->acceptq = tcbptr->qnext;
+            lsnptr->acceptlen--;
+            tcbptr->qnext = NULL;
+            tcbptr->listener = NULL;
+            restore(im);
+            TCP_TRACE("Accepted TCP%d", tcbptr->dev - TCP0);
+            return tcbptr->dev;
+        }
+        restore(im);
+    }
+}
@@ -24,6 +24,8 @@ static ushort allocPort(void);
  *           4th argument is the local port (auto-assigned if zero)
  *           5th argument is the remote port (ignored if zero)
  *           6th argument is the mode (TCP_ACTIVE or TCP_PASSIVE)
+ * A passive open after TCP_CTRL_LISTEN returns at once; connections are
+ * then taken with TCP_CTRL_ACCEPT.
  * @return OK if TCP is opened properly, otherwise SYSERR
  */
 devcall tcpOpen(device *devptr, va_list ap)
@@ -98,11 +100,29 @@ devcall tcpOpen(device *devptr, va_list ap)
         return SYSERR;
     }
 
+    /* Make the TCB visible to incoming segments */
+    tcpHashUpdate(tcbptr);
+
     /* Perform appropriate action and change state */
     switch (mode)
     {
     case TCP_PASSIVE:
         tcbptr->state = TCP_LISTEN;
+        /* A listening socket hands connections out through accept */
+        if (tcbptr->backlog > 0)
+        {
+            tcbptr->accepts = semcreate(0);
+            if (SYSERR == (int)tcbptr->accepts)
+            {
+                tcbptr->backlog = 0;
+                tcpFree(tcbptr);
+                TCP_TRACE("Failed to create accept semaphore");
+                return SYSERR;
+            }
+            signal(tcbptr->mutex);
+            TCP_TRACE("Listening");
+            return OK;
+        }
         break;
     case TCP_ACTIVE:
         if (SYSERR == tcpOpenActive(tcbptr))
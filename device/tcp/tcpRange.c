@@ -0,0 +1,114 @@
+/**
+ * @file tcpRange.c
+ * @provides tcpRangeAdd, tcpRangeTrim
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <tcp.h>
+
+/**
+ * Add a range of sequence numbers to a sorted list of ranges, joining it
+ * with the ranges it overlaps or touches.  When the list is full the
+ * range farthest along is dropped to make room, or the new range if it
+ * would be the one farthest along.
+ * @param ranges sorted list of ranges
+ * @param count count of ranges in the list, updated
+ * @param max most ranges the list holds
+ * @param start first sequence number of the range
+ * @param end sequence number after the last of the range
+ * @return index of the range that now holds start, SYSERR if dropped
+ */
+int tcpRangeAdd(struct tcpRange *ranges, uint *count, uint max,
+                tcpseq start, tcpseq end)
+{
+    uint i, j, k;
+
+    /* Skip ranges that end before this one starts */
+    for (i = 0; i < *count; i++)
+    {
+        if (seqlte(start, ranges[i].end))
+        {
+            break;
+        }
+    }
+
+    /* Swallow ranges that start before this one ends */
+    for (j = i; j < *count; j++)
+    {
+        if (seqlt(end, ranges[j].start))
+        {
+            break;
+        }
+        if (seqlt(ranges[j].start, start))
+        {
+            start = ranges[j].start;
+        }
+        if (seqlt(end, ranges[j].end))
+        {
+            end = ranges[j].end;
+        }
+    }
+
+    if (i == j)
+    {
+        /* Nothing to join, so the range needs a slot of its own */
+        if (max == *count)
+        {
+            if (i == *count)
+            {
+                return SYSERR;
+            }
+            (*count)--;
+        }
+        for (k = *count; k > i; k--)
+        {
+            ranges[k] = ranges[k - 1];
+        }
+        (*count)++;
+    }
+    else
+    {
+        /* Close up behind the joined range */
+        for (k = j; k < *count; k++)
+        {
+            ranges[k - (j - i - 1)] = ranges[k];
+        }
+        *count -= j - i - 1;
+    }
+    ranges[i].start = start;
+    ranges[i].end = end;
+
+    return i;
+}
+
+/**
+ * Drop the sequence numbers before seq from a sorted list of ranges.
+ * @param ranges sorted list of ranges
+ * @param count count of ranges in the list, updated
+ * @param seq first sequence number to keep
+ */
+void tcpRangeTrim(struct tcpRange *ranges, uint *count, tcpseq seq)
+{
+    uint i, k;
+
+    for (i = 0; i < *count; i++)
+    {
+        if (seqlt(seq, ranges[i].end))
+        {
+            break;
+        }
+    }
+    for (k = i; k < *count; k++)
+    {
+        ranges[k - i] = ranges[k];
+    }
+    *count -= i;
+
+    if ((*count > 0) && seqlt(ranges[0].start, seq))
+    {
+        ranges[0].start = seq;
+    }
+}
@@ -8,23 +8,28 @@
 
 #include <device.h>
 #include <stddef.h>
+#include <string.h>
 #include <tcp.h>
 
 static int stateCheck(struct tcb *);
+static uint incopyout(struct tcb *, uchar *, uint);
+static bool windowOpened(struct tcb *);
 
 /**
- * Read into a buffer from TCP.
+ * Read into a buffer from TCP.  Blocks until the buffer is full, unless
+ * the connection is non-blocking, when it takes only what has arrived.
  * @param devptr TCP device table entry
  * @param buf buffer to read octets into
  * @param len size of the buffer
- * @return count of octets read
+ * @return count of octets read, or SYSERR if none will ever arrive
  */
 devcall tcpRead(device *devptr, void *buf, uint len)
 {
-    int count = 0;
+    uint count = 0;
     struct tcb *tcbptr;
     int check;
-    char *buffer = buf;
+    bool nonblock;
+    uchar *buffer = buf;
 
     tcbptr = &tcptab[devptr->minor];
 
@@ -34,36 +39,44 @@ devcall tcpRead(device *devptr, void *buf, uint len)
     check = stateCheck(tcbptr);
     if (check != OK)
     {
+        signal(tcbptr->mutex);
         return SYSERR;
 //        return check; 
     }
+    nonblock = (0 != (tcbptr->sndflg & TCP_FLG_NONBLOCK));
 
     signal(tcbptr->mutex);
 
-    /* Put each octet into the buffer from the input buffer */
+    /* Take the input buffer a block at a time */
     while (count < len)
     {
         /* Wait for input or FIN */
-        wait(tcbptr->readers);
+        if (!nonblock)
+        {
+            wait(tcbptr->readers);
+        }
         wait(tcbptr->mutex);
 
-        /* Return if changed to a state where no data will ever be recvd */
+        /* Return if changed to a state where no data will ever be recvd,
+         * keeping what was read before */
         check = stateCheck(tcbptr);
         if (check != OK)
         {
-            return SYSERR;
+            signal(tcbptr->mutex);
+            return (count > 0) ? count : SYSERR;
 //            return check; 
         }
 
-        /* Read as much as possible from the input buffer 
-         * Preserve the circular buffer  */
-        while ((tcbptr->icount > 0) && (count < len))
+        count += incopyout(tcbptr, buffer + count, len - count);
+
+        /* Give back buffer space that is no longer wanted */
+        tcpBufTrim(tcbptr);
+
+        /* Send a delayed ACK now if the window it would carry has opened
+         * by two segments since last advertised */
+        if ((tcbptr->sndflg & TCP_FLG_DELACK) && windowOpened(tcbptr))
         {
-            *buffer++ = tcbptr->in[tcbptr->istart];
-            tcbptr->imark[tcbptr->istart] = FALSE;
-            tcbptr->istart = (tcbptr->istart + 1) % TCP_IBLEN;
-            tcbptr->icount--;
-            count++;
+            tcpSendAck(tcbptr);
         }
 
 #ifdef TCP_GRACIOUSACK
@@ -77,25 +90,41 @@ devcall tcpRead(device *devptr, void *buf, uint len)
         }
 #endif
 
-        /* If data remains, another reader can read */
+        /* If data remains, another reader can read; if not, a wakeup
+         * left for data a non-blocking read took is used up */
         if ((tcbptr->icount > 0) && (semcount(tcbptr->readers) < 1))
         {
             signal(tcbptr->readers);
         }
+        else if ((0 == tcbptr->icount) && (semcount(tcbptr->readers) > 0))
+        {
+            wait(tcbptr->readers);
+        }
 
         signal(tcbptr->mutex);
+
+        if (nonblock)
+        {
+            break;
+        }
     }
 
     return count;
 }
 
+/*
+ * Verifys the connection is in a state data may still be read in
+ * @param tcbptr TCB for connection
+ * @return OK if data may still be read, otherwise error
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
 static int stateCheck(struct tcb *tcbptr)
 {
     switch (tcbptr->state)
     {
     case TCP_CLOSED:
         /* No connection exists */
-        signal(tcbptr->mutex);
         return TCP_ERR_NOCONN;
     case TCP_CLOSEWT:
         /* No more data will come, but satisfy with already recvd data */
@@ -108,8 +137,58 @@ static int stateCheck(struct tcb *tcbptr)
     case TCP_LASTACK:
     case TCP_TIMEWT:
         /* Connection closing */
-        signal(tcbptr->mutex);
         return TCP_ERR_CLOSING;
     }
     return OK;
 }
+
+/**
+ * Copy octets ready for the user out of the input buffer, at most two
+ * blocks either side of the end of the buffer.
+ * @return count of octets copied
+ */
+static uint incopyout(struct tcb *tcbptr, uchar *buf, uint len)
+{
+    uint first;
+
+    if (len > tcbptr->icount)
+    {
+        len = tcbptr->icount;
+    }
+    first = tcbptr->ilen - tcbptr->istart;
+    if (first > len)
+    {
+        first = len;
+    }
+    memcpy(buf, &tcbptr->in[tcbptr->istart], first);
+    memcpy(buf + first, tcbptr->in, len - first);
+
+    tcbptr->istart = (tcbptr->istart + len) % tcbptr->ilen;
+    tcbptr->icount -= len;
+    return len;
+}
+
+/*
+ * Checks if the receive window has room for two more segments than were
+ * last advertised.
+ * @param tcbptr TCB for connection
+ * @return TRUE if a window update is worth sending
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+static bool windowOpened(struct tcb *tcbptr)
+{
+    uint size, unused;
+
+    size = tcpBufTarget(tcbptr->ilimit);
+    if (size > tcbptr->ilen)
+    {
+        size = tcbptr->ilen;
+    }
+    unused = 0;
+    if (seqlt(tcbptr->rcvnxt, tcbptr->rcvwnd))
+    {
+        unused = tcpSeqdiff(tcbptr->rcvwnd, tcbptr->rcvnxt);
+    }
+    return (tcbptr->icount + unused + (tcbptr->rcvmss << 1) <= size);
+}
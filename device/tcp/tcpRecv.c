@@ -49,6 +49,12 @@ int tcpRecv(struct packet *pkt, struct netaddr *src, struct netaddr *dst)
               tcp->seqnum, tcp->acknum, tcpSeglen(tcp, tcplen),
               tcp->window);
 
+    /* A connection in TIME-WAIT is answered from its table entry */
+    if (tcpTimewaitRecv(pkt, src, dst))
+    {
+        return netFreebuf(pkt);
+    }
+
     /* Locate the TCP socket for the TCP packet */
     tcbptr = tcpDemux(tcp->dstpt, tcp->srcpt, dst, src);
 
@@ -96,6 +102,7 @@ int tcpRecv(struct packet *pkt, struct netaddr *src, struct netaddr *dst)
     /* Send a reset if necessary */
     if (tcbptr->sndflg & TCP_FLG_SNDRST)
     {
+        tcbptr->sndflg &= ~TCP_FLG_SNDRST;
         tcpSendRst(pkt, src, dst);
     }
 
@@ -9,6 +9,127 @@
 #include <stddef.h>
 #include <tcp.h>
 
+/**
+ * Grow the congestion window for newly acknowledged data, or when in
+ * fast recovery, handle a partial or full acknowledgement (RFC 6582).
+ * @param acked sequence numbers newly acknowledged
+ */
+static void ackNew(struct tcb *tcbptr, uint acked)
+{
+    uint flight;
+
+    if (tcbptr->sndflg & TCP_FLG_RECOVER)
+    {
+        if (seqlte(tcbptr->recover, tcbptr->snduna))
+        {
+            /* Full ACK, so leave recovery with the window deflated */
+            flight = tcpSeqdiff(tcbptr->sndnxt, tcbptr->snduna);
+            if (flight < tcbptr->sndmss)
+            {
+                flight = tcbptr->sndmss;
+            }
+            tcbptr->sndcwn = tcbptr->sndsst;
+            if (flight + tcbptr->sndmss < tcbptr->sndcwn)
+            {
+                tcbptr->sndcwn = flight + tcbptr->sndmss;
+            }
+            tcbptr->sndflg &= ~TCP_FLG_RECOVER;
+            tcbptr->dupacks = 0;
+            tcpInstrTrace(tcbptr, TCP_TRC_RECOVER);
+            return;
+        }
+
+        /* Partial ACK, so the next segment was lost too; resend it now,
+         * or the next hole if it was already resent, and deflate the
+         * window by what left the network */
+        if (!seqlt(tcbptr->snduna, tcbptr->rxtnxt))
+        {
+            tcpSendUna(tcbptr);
+        }
+        else
+        {
+            tcpSendSack(tcbptr);
+        }
+        if (acked < tcbptr->sndcwn)
+        {
+            tcbptr->sndcwn -= acked;
+        }
+        else
+        {
+            tcbptr->sndcwn = 0;
+        }
+        if (acked >= tcbptr->sndmss)
+        {
+            tcbptr->sndcwn += tcbptr->sndmss;
+        }
+        return;
+    }
+
+    tcbptr->dupacks = 0;
+
+    /* Slow start grows the window by at most a segment per ACK */
+    if (tcbptr->sndcwn < tcbptr->sndsst)
+    {
+        if (acked > tcbptr->sndmss)
+        {
+            acked = tcbptr->sndmss;
+        }
+        tcbptr->sndcwn += acked;
+    }
+    /* Congestion avoidance grows it by about a segment per round trip */
+    else
+    {
+        tcbptr->sndcwn +=
+            ((tcbptr->sndmss * tcbptr->sndmss) / tcbptr->sndcwn) + 1;
+    }
+}
+
+/**
+ * Count a duplicate ACK; the third in a row starts fast retransmit and
+ * fast recovery, and more during recovery each let a segment go out.
+ */
+static void ackDup(struct tcb *tcbptr)
+{
+    uint flight;
+
+    tcbptr->dupacks++;
+    tcbptr->instr.dupacks++;
+
+    /* A segment has left the network, so another may go in; fill a
+     * hole SACK shows before sending new data */
+    if (tcbptr->sndflg & TCP_FLG_RECOVER)
+    {
+        if (0 == tcpSendSack(tcbptr))
+        {
+            tcbptr->sndcwn += tcbptr->sndmss;
+            tcbptr->sndflg |= TCP_FLG_SNDDATA;
+        }
+        return;
+    }
+
+    /* Recover at most once for each window of data (RFC 6582) */
+    if ((TCP_DUPACK_THRESH != tcbptr->dupacks)
+        || !seqlte(tcbptr->recover, tcbptr->snduna))
+    {
+        return;
+    }
+
+    flight = tcpSeqdiff(tcbptr->sndnxt, tcbptr->snduna);
+    tcbptr->sndsst = flight >> 1;
+    if (tcbptr->sndsst < (tcbptr->sndmss << 1))
+    {
+        tcbptr->sndsst = tcbptr->sndmss << 1;
+    }
+    tcbptr->recover = tcbptr->sndnxt;
+    tcbptr->sndflg |= TCP_FLG_RECOVER;
+    TCP_TRACE("Fast retransmit at %u", tcbptr->snduna);
+    tcpSendUna(tcbptr);
+    tcbptr->sndcwn = tcbptr->sndsst + (TCP_DUPACK_THRESH * tcbptr->sndmss);
+    tcbptr->instr.fastrxts++;
+    tcpInstrTrace(tcbptr, TCP_TRC_FASTRXT);
+    tcbptr->sndflg |= TCP_FLG_SNDDATA;
+}
+
 /**
  * Process an ackowledgement of data in an incoming TCP segment for a
  * connection which has been fully established.
@@ -20,17 +141,39 @@
 int tcpRecvAck(struct packet *pkt, struct tcb *tcbptr)
 {
     uint amt = 0;
+    uint ringamt;
+    uint acked;
+    uint window;
     tcpseq oldend, newend;
     struct tcpPkt *tcp;
+    ushort tcplen;
+    bool dup;
 
     /* Setup packet pointers */
     tcp = (struct tcpPkt *)pkt->curr;
+    tcplen = pkt->len - (pkt->curr - pkt->linkhdr);
+
+    /* Windows are scaled in all but SYN segments (RFC 7323) */
+    window = tcp->window;
+    if (!(tcp->control & TCP_CTRL_SYN))
+    {
+        window <<= tcbptr->sndwsc;
+    }
+
+    /* A duplicate ACK acknowledges nothing new while data is outstanding,
+     * and carries no data and no window update (RFC 5681) */
+    dup = ((tcp->acknum == tcbptr->snduna)
+           && seqlt(tcbptr->snduna, tcbptr->sndnxt)
+           && (0 == tcpSeglen(tcp, tcplen))
+           && !(tcp->control & (TCP_CTRL_SYN | TCP_CTRL_FIN))
+           && (window == tcbptr->sndwnd));
 
     if (seqlt(tcbptr->snduna, tcp->acknum)
         && seqlte(tcp->acknum, tcbptr->sndnxt))
     {
         /* Calculate the amount of acknowledged data */
-        amt = tcpSeqdiff(tcp->acknum, tcbptr->snduna);
+        acked = tcpSeqdiff(tcp->acknum, tcbptr->snduna);
+        amt = acked;
 
         /* If the SYN is part of the ACK, don't include in data count */
         if ((tcbptr->sndflg & TCP_FLG_SYN)
@@ -46,20 +189,29 @@ int tcpRecvAck(struct packet *pkt, struct tcb *tcbptr)
             amt--;
         }
 
-        /* Adjust send buffer */
-        tcbptr->ostart = (tcbptr->ostart + amt) % TCP_OBLEN;
-        tcbptr->ocount -= amt;
+        /* Adjust send buffer, then any file sent after it */
+        ringamt = (amt < tcbptr->ocount) ? amt : tcbptr->ocount;
+        tcbptr->ostart = (tcbptr->ostart + ringamt) % tcbptr->olen;
+        tcbptr->ocount -= ringamt;
+        tcbptr->sfdata += amt - ringamt;
+        tcbptr->sfcount -= amt - ringamt;
         tcbptr->obytes += amt;
-        if (tcbptr->ocount < TCP_OBLEN)
+        /* Writers wait for a file being sent, as their data follows it */
+        if ((tcbptr->ocount < tcbptr->olen) && (0 == tcbptr->sfcount)
+            && (semcount(tcbptr->writers) < 1))
         {
             signal(tcbptr->writers);
         }
+        tcpBufTrim(tcbptr);
 
         tcbptr->snduna = tcp->acknum;
+        tcpRangeTrim(tcbptr->sacked, &tcbptr->nsacked, tcbptr->snduna);
 
-        /* Remove any segments from retransmission queue which are ACKed */
-        tcbptr->rxtcount = 0;
+        /* Remove any segments from retransmission queue which are ACKed,
+         * timing the round trip only if nothing was resent (Karn) */
         tcpRecvRtt(tcbptr);
+        tcbptr->rxtcount = 0;
+        ackNew(tcbptr, acked);
         /* If unacknowledged data remains, reschedule retransmit timer */
         if (seqlt(tcbptr->snduna, tcbptr->sndnxt))
         {
@@ -76,9 +228,9 @@ int tcpRecvAck(struct packet *pkt, struct tcb *tcbptr)
     {
         /* Calculate sequence number for end of old and new send window */
         oldend = seqadd(tcbptr->sndwl2, tcbptr->sndwnd);
-        newend = seqadd(tcp->acknum, tcp->window);
+        newend = seqadd(tcp->acknum, window);
 
-        tcbptr->sndwnd = tcp->window;
+        tcbptr->sndwnd = window;
         tcbptr->sndwl1 = tcp->seqnum;
         tcbptr->sndwl2 = tcp->acknum;
 
@@ -98,6 +250,9 @@ int tcpRecvAck(struct packet *pkt, struct tcb *tcbptr)
         return OK;
     }
 
-    /* Ignore duplicate ACK */
+    if (dup)
+    {
+        ackDup(tcbptr);
+    }
     return OK;
 }
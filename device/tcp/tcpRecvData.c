@@ -10,6 +10,8 @@
 #include <network.h>
 #include <tcp.h>
 
+static bool windowUpdate(struct tcb *);
+
 /**
  * Processes the data in an incoming packet for a TCP connection.
  * Function based on RFC 763, pg 73-76.
@@ -23,13 +25,8 @@ int tcpRecvData(struct packet *pkt, struct tcb *tcbptr)
     struct tcpPkt *tcp;
     ushort tcplen;
     ushort seglen;
-
-    uint start;
-    uint i;
-    uint index;
-    tcpseq offset;
     uchar *data;
-    uint window;
+    uint ready;
 
     /* Setup packet pointers */
     tcp = (struct tcpPkt *)pkt->curr;
@@ -47,65 +44,30 @@ int tcpRecvData(struct packet *pkt, struct tcb *tcbptr)
         case TCP_ESTAB:
         case TCP_FINWT1:
         case TCP_FINWT2:
-            /* Initialize pointer to data within TCP packet */
-            data = (uchar *)tcp + offset2octets(tcp->offset);
-
-            /* Calculate where to start in segment and buffer */
-            if (seqlt(tcp->seqnum, tcbptr->rcvnxt))
-            {
-                offset = tcpSeqdiff(tcbptr->rcvnxt, tcp->seqnum);
-                data += offset;
-                seglen -= offset;
-                start = tcbptr->inxt;
-            }
-            else
-            {
-                offset = tcpSeqdiff(tcp->seqnum, tcbptr->rcvnxt);
-                start = (tcbptr->inxt + offset) % TCP_IBLEN;
-            }
-
-            /* Copy only part of data if not enough buffer space */
-            window = tcpSeqdiff(tcbptr->rcvwnd, tcbptr->rcvnxt);
-            window -= offset;
-            if (seglen > window)
+            /* A FIN past the window cannot be accepted yet */
+            if (seqlt(tcbptr->rcvwnd, seqadd(tcp->seqnum, seglen)))
             {
-                seglen = window;
                 tcp->control &= ~TCP_CTRL_FIN;
             }
 
-            /* Copy data into buffer */
-            for (i = 0; i < seglen; i++)
+            /* Initialize pointer to data within TCP packet */
+            data = (uchar *)tcp + offset2octets(tcp->offset);
+            tcbptr->rcvsegs++;
+            ready = tcpRecvQueue(tcbptr, tcp->seqnum, data, seglen);
+            if (ready > 0)
             {
-                index = (start + i) % TCP_IBLEN;
-                tcbptr->in[index] = data[i];
-                tcbptr->imark[index] = TRUE;
-            }
+                /* If FIN has been seen, it may now be next */
+                if ((tcbptr->rcvflg & TCP_FLG_FIN)
+                    && (tcbptr->rcvnxt == tcbptr->rcvfin))
+                {
+                    tcp->control |= TCP_CTRL_FIN;
+                }
 
-            /* If started at begnning of window, we can ACK */
-            if (start == tcbptr->inxt)
-            {
-                /* ACK at least current data */
-                tcbptr->icount += seglen;
-                tcbptr->ibytes += seglen;
-                tcbptr->inxt = (tcbptr->inxt + seglen) % TCP_IBLEN;
-                tcbptr->rcvnxt = seqadd(tcbptr->rcvnxt, seglen);
-
-                /* Keep going until data is missing */
-                while ((tcbptr->icount < TCP_IBLEN)
-                       && (tcbptr->imark[tcbptr->inxt]))
+                /* The remote side filled the window, which the size of
+                 * the input buffer may be what limits */
+                if (seqlte(tcbptr->rcvwnd, tcbptr->rcvnxt))
                 {
-                    tcbptr->icount++;
-                    tcbptr->ibytes++;
-                    tcbptr->inxt = (tcbptr->inxt + 1) % TCP_IBLEN;
-                    tcbptr->rcvnxt = seqadd(tcbptr->rcvnxt, 1);
-
-                    /* If FIN has been seen, stop when we reach it */
-                    if ((tcbptr->rcvflg & TCP_FLG_FIN)
-                        && (tcbptr->rcvnxt == tcbptr->rcvfin))
-                    {
-                        tcp->control |= TCP_CTRL_FIN;
-                        break;
-                    }
+                    tcpBufGrowIn(tcbptr);
                 }
 
                 /* Signal readers */
@@ -113,10 +75,20 @@ int tcpRecvData(struct packet *pkt, struct tcb *tcbptr)
                 {
                     signal(tcbptr->readers);
                 }
+            }
 
+            /* Repeat the ACK for a gap at once, and ACK data that fills
+             * one, or was pushed while the window has opened, at once;
+             * delay the ACK for the rest */
+            if ((ready != seglen) || (tcbptr->nooo > 0)
+                || ((tcp->control & TCP_CTRL_PSH) && windowUpdate(tcbptr)))
+            {
                 tcbptr->sndflg |= TCP_FLG_SNDACK;
             }
-
+            else
+            {
+                tcpDelack(tcbptr);
+            }
             break;
 
             /* Data should not be recevied in CLOSEWT, CLOSING, LASTACK, and TIMEWT
@@ -156,8 +128,6 @@ int tcpRecvData(struct packet *pkt, struct tcb *tcbptr)
                 tcbptr->rcvnxt = seqadd(tcbptr->rcvnxt, 1);
                 if (seqlt(tcbptr->sndfin, tcbptr->snduna))
                 {
-                    tcpTimerSched(TCP_TWOMSL, tcbptr, TCP_EVT_TIMEWT);
-                    tcpTimerPurge(tcbptr, NULL);
                     tcbptr->state = TCP_TIMEWT;
                 }
                 else
@@ -167,14 +137,11 @@ int tcpRecvData(struct packet *pkt, struct tcb *tcbptr)
                 break;
             case TCP_FINWT2:
                 tcbptr->rcvnxt = seqadd(tcbptr->rcvnxt, 1);
-                tcpTimerPurge(tcbptr, NULL);
-                tcpTimerSched(TCP_TWOMSL, tcbptr, TCP_EVT_TIMEWT);
+                tcbptr->state = TCP_TIMEWT;
                 break;
                 /* If in TIMEWT, CLOSEWT, CLOSING, or LASTACK states, then 
                  * FIN has already been received; send an ACK */
             case TCP_TIMEWT:
-                tcpTimerPurge(tcbptr, NULL);
-                tcpTimerSched(TCP_TWOMSL, tcbptr, TCP_EVT_TIMEWT);
             case TCP_CLOSEWT:
             case TCP_CLOSING:
             case TCP_LASTACK:
@@ -198,5 +165,45 @@ int tcpRecvData(struct packet *pkt, struct tcb *tcbptr)
         tcpSendAck(tcbptr);
     }
 
+    /* The final ACK is sent, so TIME-WAIT needs no more than an entry
+     * in the TIME-WAIT table and the TCB can be freed */
+    if (TCP_TIMEWT == tcbptr->state)
+    {
+        tcpTimewaitAdd(tcbptr);
+        return TCP_ERR_RESET;
+    }
+
     return OK;
 }
+
+/*
+ * Checks if the receive window would open by a segment past what was last
+ * advertised, so an ACK sent now would carry a window update.
+ * @param tcbptr TCB for connection
+ * @return TRUE if an ACK would update the window
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+static bool windowUpdate(struct tcb *tcbptr)
+{
+    uint size, unused, window;
+
+    size = tcpBufTarget(tcbptr->ilimit);
+    if (size > tcbptr->ilen)
+    {
+        size = tcbptr->ilen;
+    }
+    if (tcbptr->icount >= size)
+    {
+        return FALSE;
+    }
+    window = size - tcbptr->icount;
+    unused = 0;
+    if (seqlt(tcbptr->rcvnxt, tcbptr->rcvwnd))
+    {
+        unused = tcpSeqdiff(tcbptr->rcvwnd, tcbptr->rcvnxt);
+    }
+
+    /* Silly window avoidance holds back smaller windows (tcpSendWindow) */
+    return (((window * 4) >= size) && (window >= unused + tcbptr->rcvmss));
+}
@@ -10,6 +10,33 @@
 #include <network.h>
 #include <tcp.h>
 
+/**
+ * Hand a SYN arriving at a listening socket to a TCB of its own, which
+ * goes on from the LISTEN state as a single passive open would.
+ */
+static int listenSyn(struct packet *pkt, struct tcb *lsnptr,
+                     struct netaddr *src)
+{
+    struct tcpPkt *tcp;
+    struct tcb *tcbptr;
+
+    tcp = (struct tcpPkt *)pkt->curr;
+    tcbptr = tcpListenSyn(lsnptr, src, tcp->srcpt);
+    if (NULL == tcbptr)
+    {
+        return OK;
+    }
+
+    tcpRecvOpts(pkt, tcbptr);
+    if (TCP_ERR_RESET == tcpRecvListen(pkt, tcbptr, src))
+    {
+        tcpFree(tcbptr);
+        return OK;
+    }
+    signal(tcbptr->mutex);
+    return OK;
+}
+
 /**
  * Processes an incoming packet for a TCP connection in the LISTEN state.
  * @param pkt incoming packet
@@ -42,6 +69,11 @@ int tcpRecvListen(struct packet *pkt, struct tcb *tcbptr,
     /* Should receive a SYN */
     if (tcp->control & TCP_CTRL_SYN)
     {
+        if (tcbptr->backlog > 0)
+        {
+            return listenSyn(pkt, tcbptr, src);
+        }
+
         /* Update receive information */
         tcbptr->rcvnxt = seqadd(tcp->seqnum, 1);
         tcbptr->rcvwnd = seqadd(tcp->seqnum, TCP_INIT_WND);
@@ -57,6 +89,7 @@ int tcpRecvListen(struct packet *pkt, struct tcb *tcbptr,
         {
             netaddrcpy(&tcbptr->remoteip, src);
         }
+        tcpHashUpdate(tcbptr);
 
         /* Update send information */
         tcbptr->sndwnd = tcp->window;
@@ -10,6 +10,45 @@
 #include <network.h>
 #include <tcp.h>
 
+/**
+ * Read a sequence number from an option in network order.
+ */
+static tcpseq getseq(uchar *data)
+{
+    return ((tcpseq)data[0] << 24) | ((tcpseq)data[1] << 16)
+        | ((tcpseq)data[2] << 8) | data[3];
+}
+
+/**
+ * Record the ranges the remote side reports holding past a gap, keeping
+ * only those within the data sent but not acknowledged.
+ */
+static void sackRecv(struct tcb *tcbptr, uchar *blocks, uint len)
+{
+    tcpseq start, end;
+
+    for (; len >= TCP_OPT_SACK_BLK; len -= TCP_OPT_SACK_BLK)
+    {
+        start = getseq(blocks);
+        end = getseq(blocks + 4);
+        blocks += TCP_OPT_SACK_BLK;
+
+        if (seqlt(start, tcbptr->snduna))
+        {
+            start = tcbptr->snduna;
+        }
+        if (seqlt(tcbptr->sndnxt, end))
+        {
+            end = tcbptr->sndnxt;
+        }
+        if (seqlt(start, end))
+        {
+            tcpRangeAdd(tcbptr->sacked, &tcbptr->nsacked, TCP_NSACKED,
+                        start, end);
+        }
+    }
+}
+
 /**
  * Processes the options in an incoming packet for a TCP connection.
  * @param pkt incoming packet
@@ -23,43 +62,90 @@ int tcpRecvOpts(struct packet *pkt, struct tcb *tcbptr)
     uchar *options;
     uchar *endopt;
     struct tcpPkt *tcp;
+    uint len;
 
     tcp = (struct tcpPkt *)pkt->curr;
 
-    /* Check if the header contains options */
-    if (offset2octets(tcp->offset) == TCP_HDR_LEN)
+    /* SACK and window scaling are used only if both SYNs say so */
+    if (tcp->control & TCP_CTRL_SYN)
     {
-        /* No options */
-        return OK;
+        tcbptr->rcvflg &= ~(TCP_FLG_SACK | TCP_FLG_WSCALE);
+        tcbptr->sndwsc = 0;
     }
 
     options = tcp->data;
     endopt = options + (offset2octets(tcp->offset) - TCP_HDR_LEN);
 
     /* Keep handling options until end of otpion list is encountered */
-    while ((*options != TCP_OPT_END) && (options < endopt))
+    while ((options < endopt) && (*options != TCP_OPT_END))
     {
+        /* Skip over NOP */
+        if (TCP_OPT_NOP == *options)
+        {
+            options++;
+            continue;
+        }
+
+        /* Every other option has a length, which must fit */
+        if ((options + 1 >= endopt) || (options[1] < 2)
+            || (options + options[1] > endopt))
+        {
+            break;
+        }
+        len = options[1];
+
         switch (*options)
         {
             /* Maximum segment size */
         case TCP_OPT_MSS:
-            options += 2;
-            /*
-             * BUG: The options may not be word aligned to deference as
-             * a short.  Discovered by RB on 7/2.
-             * FIXED by AG on 8/10.
-             * TODO: add test case with non-word aligned opts
-             */
-            tcbptr->sndmss = *options++;
-            tcbptr->sndmss += *options++ << 8;
-            tcbptr->sndmss -= TCP_HDR_LEN;
+            if (TCP_OPT_MSS_LEN == len)
+            {
+                tcbptr->peermss = options[2] << 8;
+                tcbptr->peermss += options[3];
+                tcbptr->peermss -= TCP_HDR_LEN;
+                tcpSendMss(tcbptr);
+            }
+            break;
+            /* Window scale */
+        case TCP_OPT_WSCALE:
+            if ((tcp->control & TCP_CTRL_SYN)
+                && (TCP_OPT_WSCALE_LEN == len))
+            {
+                tcbptr->rcvflg |= TCP_FLG_WSCALE;
+                tcbptr->sndwsc = options[2];
+                if (tcbptr->sndwsc > TCP_WSC_MAX)
+                {
+                    tcbptr->sndwsc = TCP_WSC_MAX;
+                }
+            }
+            break;
+            /* Selective acknowledgement permitted */
+        case TCP_OPT_SACKOK:
+            if (tcp->control & TCP_CTRL_SYN)
+            {
+                tcbptr->rcvflg |= TCP_FLG_SACK;
+            }
+            break;
+            /* Selective acknowledgement */
+        case TCP_OPT_SACK:
+            if ((tcbptr->rcvflg & TCP_FLG_SACK)
+                && (tcp->control & TCP_CTRL_ACK))
+            {
+                sackRecv(tcbptr, options + 2, len - 2);
+            }
             break;
-            /* Skip over NOP and unknown options */
-        case TCP_OPT_NOP:
+            /* Skip over unknown options */
         default:
-            options++;
             break;
         }
+        options += len;
+    }
+
+    /* Our side's windows go unscaled if the remote side did not offer */
+    if ((tcp->control & TCP_CTRL_SYN)
+        && !(tcbptr->rcvflg & TCP_FLG_WSCALE))
+    {
+        tcbptr->rcvwsc = 0;
     }
 
     return OK;
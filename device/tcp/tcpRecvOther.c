@@ -54,7 +54,8 @@ int tcpRecvOther(struct packet *pkt, struct tcb *tcbptr)
         case TCP_SYNRECV:
             tcbptr->rxtcount = 0;
             tcpTimerPurge(tcbptr, TCP_EVT_RXT);
-            if (TCP_PASSIVE == tcbptr->opentype)
+            if ((TCP_PASSIVE == tcbptr->opentype)
+                && (NULL == tcbptr->listener))
             {
                 tcbptr->state = TCP_LISTEN;
                 return OK;
@@ -96,7 +97,14 @@ int tcpRecvOther(struct packet *pkt, struct tcb *tcbptr)
             && seqlte(tcp->acknum, tcbptr->sndnxt))
         {
             tcbptr->state = TCP_ESTAB;
-            signal(tcbptr->openclose);  /* Signal connection open */
+            if (NULL == tcbptr->listener)
+            {
+                signal(tcbptr->openclose);  /* Signal connection open */
+            }
+            else
+            {
+                tcpListenEstab(tcbptr);
+            }
         }
         else
         {
@@ -130,8 +138,7 @@ int tcpRecvOther(struct packet *pkt, struct tcb *tcbptr)
         if (seqlte(tcbptr->sndfin, tcbptr->snduna))
         {
             signal(tcbptr->openclose);
-            tcbptr->state = TCP_FINWT2;
-            tcpTimerSched(TCP_TWOMSL, tcbptr, TCP_EVT_TIMEWT);
+            tcbptr->state = TCP_TIMEWT;
         }
         break;
     case TCP_LASTACK:
@@ -143,8 +150,6 @@ int tcpRecvOther(struct packet *pkt, struct tcb *tcbptr)
         }
         break;
     case TCP_TIMEWT:
-        tcpTimerPurge(tcbptr, NULL);
-        tcpTimerSched(TCP_TWOMSL, tcbptr, TCP_EVT_TIMEWT);
         break;
     }
     return tcpRecvData(pkt, tcbptr);
@@ -0,0 +1,126 @@
+/**
+ * @file tcpRecvQueue.c
+ * @provides tcpRecvQueue
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <string.h>
+#include <tcp.h>
+
+/**
+ * Copy data into the input buffer, offset octets past the last octet
+ * ready for the user, wrapping around the end of the buffer.
+ */
+static void incopy(struct tcb *tcbptr, uint offset, uchar *data, uint len)
+{
+    uint index, first;
+
+    index = (tcbptr->istart + tcbptr->icount + offset) % tcbptr->ilen;
+    first = tcbptr->ilen - index;
+    if (first > len)
+    {
+        first = len;
+    }
+    memcpy(&tcbptr->in[index], data, first);
+    memcpy(tcbptr->in, data + first, len - first);
+}
+
+/**
+ * Make octets ready for the user and advance the next expected sequence
+ * number past them.
+ */
+static void inready(struct tcb *tcbptr, uint len)
+{
+    tcbptr->icount += len;
+    tcbptr->ibytes += len;
+    tcbptr->rcvnxt = seqadd(tcbptr->rcvnxt, len);
+}
+
+/**
+ * Put the data of an incoming segment into the input buffer.  Data that
+ * continues the stream is made ready for the user, along with any data
+ * held past a gap that it fills.  Data past a gap is held where it
+ * belongs until the gap is filled.  Data already received or outside
+ * the receive window is dropped.
+ * @param tcbptr pointer to transmission control block for connection
+ * @param seq sequence number of the first octet of data
+ * @param data segment data
+ * @param len count of octets of data
+ * @return count of octets made ready for the user
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+uint tcpRecvQueue(struct tcb *tcbptr, tcpseq seq, uchar *data, uint len)
+{
+    uint offset, window, ready;
+    int i;
+
+    /* Trim data that was already received */
+    if (seqlt(seq, tcbptr->rcvnxt))
+    {
+        offset = tcpSeqdiff(tcbptr->rcvnxt, seq);
+        if (offset >= len)
+        {
+            return 0;
+        }
+        data += offset;
+        len -= offset;
+        seq = tcbptr->rcvnxt;
+    }
+
+    /* Trim data past the window, which must not overrun unread data */
+    window = 0;
+    if (seqlt(tcbptr->rcvnxt, tcbptr->rcvwnd))
+    {
+        window = tcpSeqdiff(tcbptr->rcvwnd, tcbptr->rcvnxt);
+    }
+    if (window > tcbptr->ilen - tcbptr->icount)
+    {
+        window = tcbptr->ilen - tcbptr->icount;
+    }
+    offset = tcpSeqdiff(seq, tcbptr->rcvnxt);
+    if (offset >= window)
+    {
+        return 0;
+    }
+    if (len > window - offset)
+    {
+        len = window - offset;
+    }
+
+    incopy(tcbptr, offset, data, len);
+
+    /* Remember data past a gap; if every slot is taken the range
+     * farthest from the gap is forgotten and will be sent again */
+    if (offset > 0)
+    {
+        tcbptr->instr.ooosegs++;
+        i = tcpRangeAdd(tcbptr->ooo, &tcbptr->nooo, TCP_NOOO,
+                        seq, seqadd(seq, len));
+        if (SYSERR != i)
+        {
+            tcbptr->ooorecent = tcbptr->ooo[i].start;
+        }
+        return 0;
+    }
+
+    /* Continue through any held ranges the data reaches */
+    inready(tcbptr, len);
+    ready = len;
+    while ((tcbptr->nooo > 0)
+           && seqlte(tcbptr->ooo[0].start, tcbptr->rcvnxt))
+    {
+        if (seqlt(tcbptr->rcvnxt, tcbptr->ooo[0].end))
+        {
+            len = tcpSeqdiff(tcbptr->ooo[0].end, tcbptr->rcvnxt);
+            inready(tcbptr, len);
+            ready += len;
+        }
+        tcpRangeTrim(tcbptr->ooo, &tcbptr->nooo, tcbptr->rcvnxt);
+    }
+
+    return ready;
+}
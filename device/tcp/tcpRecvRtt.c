@@ -12,6 +12,8 @@
 
 /**
  * Handle round trip time estimates based on an incoming acknowledgement.
+ * The round trip is timed in microseconds from the retransmission event,
+ * as the timer wheel only counts clock ticks.
  * @param tcbptr pointer to transmission control block for connection
  * @return OK
  * @precondition TCB mutex is already held 
@@ -21,8 +23,13 @@ int tcpRecvRtt(struct tcb *tcbptr)
 {
     int rtt, delta;
 
-    rtt = tcpTimerPurge(tcbptr, TCP_EVT_RXT);
-    if ((rtt != SYSERR) && (0 == tcbptr->rxtcount))
+    rtt = tcpTimerUsec(tcbptr, TCP_EVT_RXT);
+    if (SYSERR == tcpTimerPurge(tcbptr, TCP_EVT_RXT))
+    {
+        rtt = SYSERR;
+    }
+    if ((rtt != SYSERR) && (0 == tcbptr->rxtcount)
+        && !(tcbptr->sndflg & TCP_FLG_RECOVER))
     {
         if (0 == tcbptr->sndrtt)
         {
@@ -33,25 +40,17 @@ int tcpRecvRtt(struct tcb *tcbptr)
         delta = abs(delta);
         tcbptr->sndrtd += delta - (tcbptr->sndrtd >> 2);
         tcbptr->rxttime = ((tcbptr->sndrtt >> 2) + tcbptr->sndrtd) >> 1;
+        tcbptr->rxttime = (tcbptr->rxttime + 999) / 1000;
         if (tcbptr->rxttime < TCP_RXT_MINTIME)
         {
             tcbptr->rxttime = TCP_RXT_MINTIME;
         }
+        if (tcbptr->rxttime > TCP_RXT_MAXTIME)
+        {
+            tcbptr->rxttime = TCP_RXT_MAXTIME;
+        }
+        tcpInstrRtt(tcbptr, rtt);
     }
 
-    /* Handle slow start/congestion window increase */
-    /* If the congestion window is less than the slow start threshold, increase
-     * congestion window by MSS */
-    if (tcbptr->sndcwn < tcbptr->sndsst)
-    {
-        tcbptr->sndcwn += tcbptr->sndmss;
-    }
-    /* Otherwise, increase congestion window by MSS for each round trip time
-     * using percentage of current congestion window */
-    else
-    {
-        tcbptr->sndcwn +=
-            (tcbptr->sndmss * tcbptr->sndmss) / tcbptr->sndcwn;
-    }
     return OK;
 }
@@ -12,35 +12,179 @@
 #include <string.h>
 #include <tcp.h>
 
+/**
+ * Put a sequence number into an option in network order.
+ */
+static uchar *putseq(uchar *data, tcpseq seq)
+{
+    *data++ = seq >> 24;
+    *data++ = seq >> 16;
+    *data++ = seq >> 8;
+    *data++ = seq;
+    return data;
+}
+
+/**
+ * Smallest window scale shift that lets the whole of an input buffer as
+ * big as limit be advertised.
+ */
+static uchar wscale(uint limit)
+{
+    uchar shift = 0;
+
+    while (((limit >> shift) > TCP_MAX_WND) && (shift < TCP_WSC_MAX))
+    {
+        shift++;
+    }
+    return shift;
+}
+
+/**
+ * Histogram bucket for a data segment of len octets; the last bucket
+ * holds full-sized segments.
+ */
+static uint segBucket(struct tcb *tcbptr, uint len)
+{
+    static const ushort bounds[TCP_NSEGHIST - 2] = { 64, 256, 512, 1024 };
+    uint i;
+
+    if (len >= tcbptr->sndmss)
+    {
+        return TCP_NSEGHIST - 1;
+    }
+    for (i = 0; i < TCP_NSEGHIST - 2; i++)
+    {
+        if (len < bounds[i])
+        {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * Write SACK blocks for the data held past a gap, the block holding the
+ * most recently received segment first (RFC 2018).
+ */
+static uchar *sackBlocks(struct tcb *tcbptr, uchar *data, uint nblk)
+{
+    struct tcpRange *range;
+    uint i, first;
+
+    first = 0;
+    for (i = 0; i < tcbptr->nooo; i++)
+    {
+        range = &tcbptr->ooo[i];
+        if (seqlte(range->start, tcbptr->ooorecent)
+            && seqlt(tcbptr->ooorecent, range->end))
+        {
+            first = i;
+            break;
+        }
+    }
+
+    data = putseq(data, tcbptr->ooo[first].start);
+    data = putseq(data, tcbptr->ooo[first].end);
+    nblk--;
+    for (i = 0; (i < tcbptr->nooo) && (nblk > 0); i++)
+    {
+        if (i != first)
+        {
+            data = putseq(data, tcbptr->ooo[i].start);
+            data = putseq(data, tcbptr->ooo[i].end);
+            nblk--;
+        }
+    }
+    return data;
+}
+
+/**
+ * Copy octets of pending output into a segment, offset octets past the
+ * first unacknowledged one.  The send buffer holds the first octets, and
+ * a file being sent follows them, copied from where it lies.
+ */
+static void outcopy(struct tcb *tcbptr, uchar *data, uint offset,
+                    uint len)
+{
+    uint index, first, part;
+
+    if (offset < tcbptr->ocount)
+    {
+        first = tcbptr->ocount - offset;
+        if (first > len)
+        {
+            first = len;
+        }
+        index = (tcbptr->ostart + offset) % tcbptr->olen;
+        part = tcbptr->olen - index;
+        if (part > first)
+        {
+            part = first;
+        }
+        memcpy(data, &tcbptr->out[index], part);
+        memcpy(data + part, tcbptr->out, first - part);
+        data += first;
+        len -= first;
+        offset = 0;
+    }
+    else
+    {
+        offset -= tcbptr->ocount;
+    }
+
+    if (len > 0)
+    {
+        memcpy(data, tcbptr->sfdata + offset, len);
+    }
+}
+
 /**
  * Sends a TCP packet for a TCP connection.
  * @param tcbptr pointer to the transmission control block for connection
  * @param ctrl control flags to be set
  * @param seqnum sequence number for the packet
  * @param acknum acknowledgement number for the packet
- * @param data data to be included in the packet, NULL if no data
+ * @param dataoff offset of data past the first unacknowledged octet
  * @param datalen length of the data, 0 if no data
  * @pre-condition TCB mutex is already held
  * @post-condition TCB mutex is still held
  */
 int tcpSend(struct tcb *tcbptr, uchar ctrl, uint seqnum,
-            uint acknum, uint datastart, ushort datalen)
+            uint acknum, uint dataoff, ushort datalen)
 {
     struct packet *pkt = NULL;
     struct tcpPkt *tcp = NULL;
     int result;
     uchar *data;
-    uint i = 0;
     ushort window = 0;
-    ushort msslen = 0;
+    ushort optlen = 0;
     ushort tcplen;
+    bool sackok = FALSE;
+    bool wsok = FALSE;
+    uint nblk = 0;
 
     /* If SYN is set, then don't include in datalen, but include MSS */
     if (ctrl & TCP_CTRL_SYN)
     {
         datalen--;
-        msslen = ((3 + TCP_OPT_MSS_SIZE) & ~0x03);
+        optlen = TCP_OPT_MSS_LEN;
         TCP_TRACE("No SYN in datalen, include MSS");
+
+        /* Offer SACK, or accept the remote side's offer */
+        if (!(ctrl & TCP_CTRL_ACK) || (tcbptr->rcvflg & TCP_FLG_SACK))
+        {
+            sackok = TRUE;
+            optlen += 2 + TCP_OPT_SACKOK_LEN;
+        }
+
+        /* Likewise for window scaling, fixing the shift for our side */
+        tcbptr->rcvwsc = 0;
+        if (!(ctrl & TCP_CTRL_ACK) || (tcbptr->rcvflg & TCP_FLG_WSCALE))
+        {
+            wsok = TRUE;
+            tcbptr->rcvwsc = wscale(tcbptr->ilimit);
+            optlen += 1 + TCP_OPT_WSCALE_LEN;
+        }
     }
     /* If FIN is set, then don't include in datalen */
     if (ctrl & TCP_CTRL_FIN)
@@ -49,8 +193,27 @@ int tcpSend(struct tcb *tcbptr, uchar ctrl, uint seqnum,
         TCP_TRACE("No FIN in datalen");
     }
 
+    /* Report data held past a gap, in what room the segment has left */
+    if (!(ctrl & TCP_CTRL_SYN) && (tcbptr->rcvflg & TCP_FLG_SACK))
+    {
+        nblk = tcbptr->nooo;
+        if (nblk > TCP_SACK_MAXBLK)
+        {
+            nblk = TCP_SACK_MAXBLK;
+        }
+        while ((nblk > 0) && (datalen + 4 + (nblk * TCP_OPT_SACK_BLK)
+                              > tcbptr->sndmss))
+        {
+            nblk--;
+        }
+        if (nblk > 0)
+        {
+            optlen = 4 + (nblk * TCP_OPT_SACK_BLK);
+        }
+    }
+
     /* Get space to construct packet */
-    tcplen = TCP_HDR_LEN + datalen + msslen;
+    tcplen = TCP_HDR_LEN + datalen + optlen;
     if (tcplen > NET_MAX_PKTLEN)
     {
         TCP_TRACE("Packet too large");
@@ -73,34 +236,50 @@ int tcpSend(struct tcb *tcbptr, uchar ctrl, uint seqnum,
     tcp->dstpt = tcbptr->remotept;
     tcp->seqnum = seqnum;
     tcp->acknum = acknum;
-    tcp->offset = octets2offset(TCP_HDR_LEN + msslen);
+    tcp->offset = octets2offset(TCP_HDR_LEN + optlen);
     tcp->control = ctrl;
     tcp->window = tcpSendWindow(tcbptr);
+    tcp->chksum = 0;
+    tcp->urgent = 0;
     window = tcp->window;
     data = tcp->data;
 
-    /* Add options */
-    if (msslen)
+    /* Add options, each a multiple of 4 octets with NOP padding */
+    if (ctrl & TCP_CTRL_SYN)
     {
         *data++ = TCP_OPT_MSS;
         *data++ = TCP_OPT_MSS_LEN;
-        *((ushort *)data) = hs2net((tcbptr->rcvmss + TCP_HDR_LEN));
-        data += TCP_OPT_MSS_LEN;
-        for (i = (TCP_OPT_MSS_LEN % 4); i > 1; i--)
-        {
-            *data++ = TCP_OPT_NOP;
-        }
-        *data++ = TCP_OPT_END;
+        *data++ = (tcbptr->rcvmss + TCP_HDR_LEN) >> 8;
+        *data++ = (tcbptr->rcvmss + TCP_HDR_LEN) & 0xFF;
         TCP_TRACE("Added MSS");
     }
+    if (sackok)
+    {
+        *data++ = TCP_OPT_NOP;
+        *data++ = TCP_OPT_NOP;
+        *data++ = TCP_OPT_SACKOK;
+        *data++ = TCP_OPT_SACKOK_LEN;
+    }
+    if (wsok)
+    {
+        *data++ = TCP_OPT_NOP;
+        *data++ = TCP_OPT_WSCALE;
+        *data++ = TCP_OPT_WSCALE_LEN;
+        *data++ = tcbptr->rcvwsc;
+    }
+    if (nblk > 0)
+    {
+        *data++ = TCP_OPT_NOP;
+        *data++ = TCP_OPT_NOP;
+        *data++ = TCP_OPT_SACK;
+        *data++ = 2 + (nblk * TCP_OPT_SACK_BLK);
+        data = sackBlocks(tcbptr, data, nblk);
+    }
 
     /* Copy data into packet */
     if (datalen > 0)
     {
-        for (i = 0; i < datalen; i++)
-        {
-            *data++ = tcbptr->out[(datastart + i) % TCP_OBLEN];
-        }
+        outcopy(tcbptr, data, dataoff, datalen);
     }
 
     /* Convert TCP header fields to net order */
@@ -117,7 +296,25 @@ int tcpSend(struct tcb *tcbptr, uchar ctrl, uint seqnum,
 
     /* Send TCP packet */
     result = ipv4Send(pkt, &tcbptr->localip, &tcbptr->remoteip,
-                      IPv4_PROTO_TCP);
+                      IPv4_PROTO_TCP, &tcbptr->rtcache);
+
+    /* Any ACK sent takes the place of one being delayed */
+    if (ctrl & TCP_CTRL_ACK)
+    {
+        if (tcbptr->sndflg & TCP_FLG_DELACK)
+        {
+            tcbptr->sndflg &= ~TCP_FLG_DELACK;
+            tcpTimerPurge(tcbptr, TCP_EVT_DELACK);
+        }
+        if ((0 == datalen) && !(ctrl & (TCP_CTRL_SYN | TCP_CTRL_FIN)))
+        {
+            tcbptr->acksent++;
+        }
+    }
+    if (datalen > 0)
+    {
+        tcbptr->seghist[segBucket(tcbptr, datalen)]++;
+    }
 
     if (SYSERR == netFreebuf(pkt))
     {
@@ -9,6 +9,31 @@
 #include <stddef.h>
 #include <tcp.h>
 
+/**
+ * Whether a segment smaller than the MSS should wait for more data.
+ * While corked it always waits; otherwise it waits while earlier data is
+ * unacknowledged (Nagle, RFC 896), unless coalescing is turned off.  A
+ * segment carrying FIN, or the end of what was held until uncorked, is
+ * never held.
+ */
+static bool holdSmall(struct tcb *tcbptr, uint len, uint wndused,
+                      uchar ctrl)
+{
+    if ((len >= tcbptr->sndmss) || (ctrl & TCP_CTRL_FIN))
+    {
+        return FALSE;
+    }
+    if (tcbptr->sndflg & TCP_FLG_CORK)
+    {
+        return TRUE;
+    }
+    if (tcbptr->sndflg & TCP_FLG_PUSH)
+    {
+        return FALSE;
+    }
+    return ((wndused > 0) && !(tcbptr->sndflg & TCP_FLG_NODELAY));
+}
+
 /**
  * Sends pending outbound data (including SYN and FIN) for a TCP connection, 
  * if new data is ready for transmission.
@@ -19,13 +44,15 @@
  */
 int tcpSendData(struct tcb *tcbptr)
 {
+    uint window;       /**< amount the receiver and network will take */
     uint wndused;      /**< amount of window filled with data pending ACK */
     uint pending;      /**< amount of data pending ACK or transmission */
     uint tosend;
     uint sent;
     uchar ctrl;
 
-    /* Verify sender MSS is greater than 0 */
+    /* Verify sender MSS, fitted to the path, is greater than 0 */
+    tcpSendMss(tcbptr);
     if (tcbptr->sndmss == 0)
     {
         return SYSERR;
@@ -53,15 +80,22 @@ int tcpSendData(struct tcb *tcbptr)
         return 0;
     }
 
+    /* Send no more than the congestion window allows */
+    window = tcbptr->sndwnd;
+    if (window > tcbptr->sndcwn)
+    {
+        window = tcbptr->sndcwn;
+    }
+
     /* Check if new transmssion is allowed */
-    /* If (SNDNXT >= SNDUNA + SNDWND), then can't send data */
-    if (seqlte(seqadd(tcbptr->snduna, tcbptr->sndwnd), tcbptr->sndnxt))
+    /* If (SNDNXT >= SNDUNA + WINDOW), then can't send data */
+    if (seqlte(seqadd(tcbptr->snduna, window), tcbptr->sndnxt))
     {
         return 0;
     }
 
     /* Check if there is data to send */
-    pending = tcbptr->ocount;
+    pending = tcpOutPending(tcbptr);
     if (tcbptr->sndflg & TCP_FLG_FIN)
     {
         pending++;
@@ -80,9 +114,9 @@ int tcpSendData(struct tcb *tcbptr)
     /* There is data to send and space in the window to send it */
     ctrl = TCP_CTRL_ACK;
     /* Determine how much data to send */
-    if (pending > tcbptr->sndwnd)
+    if (pending > window)
     {
-        tosend = tcbptr->sndwnd - wndused;
+        tosend = window - wndused;
     }
     else
     {
@@ -98,22 +132,32 @@ int tcpSendData(struct tcb *tcbptr)
     while (tosend > tcbptr->sndmss)
     {
         tcpSend(tcbptr, TCP_CTRL_ACK, tcbptr->sndnxt, tcbptr->rcvnxt,
-                (tcbptr->ostart + wndused) % TCP_OBLEN, tcbptr->sndmss);
+                wndused, tcbptr->sndmss);
         tosend -= tcbptr->sndmss;
         sent += tcbptr->sndmss;
         wndused += tcbptr->sndmss;
         tcbptr->sndnxt = seqadd(tcbptr->sndnxt, tcbptr->sndmss);
     }
 
-    /* Send the remainder of the sendable data */
-    tcpSend(tcbptr, ctrl, tcbptr->sndnxt, tcbptr->rcvnxt,
-            (tcbptr->ostart + wndused) % TCP_OBLEN, tosend);
-    sent += tosend;
-    wndused += tosend;
-    tcbptr->sndnxt = seqadd(tcbptr->sndnxt, tosend);
+    /* Send the remainder of the sendable data, unless it is too small
+     * to be worth a segment yet */
+    if (!holdSmall(tcbptr, tosend, wndused, ctrl))
+    {
+        tcpSend(tcbptr, ctrl, tcbptr->sndnxt, tcbptr->rcvnxt, wndused,
+                tosend);
+        sent += tosend;
+        wndused += tosend;
+        tcbptr->sndnxt = seqadd(tcbptr->sndnxt, tosend);
+
+        /* Once all that was held is out, small segments wait again */
+        if (wndused == pending)
+        {
+            tcbptr->sndflg &= ~TCP_FLG_PUSH;
+        }
+    }
 
     /* If one does not already exist, schedule a retransmission event */
-    if (tcpTimerRemain(tcbptr, TCP_EVT_RXT) <= 0)
+    if ((wndused > 0) && (tcpTimerRemain(tcbptr, TCP_EVT_RXT) <= 0))
     {
         tcpTimerSched(tcbptr->rxttime, tcbptr, TCP_EVT_RXT);
     }
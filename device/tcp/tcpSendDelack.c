@@ -0,0 +1,53 @@
+/**
+ * @file tcpSendDelack.c
+ * @provides tcpDelack, tcpSendDelack
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <tcp.h>
+
+/**
+ * Acknowledge in-order data, holding the ACK back in the hope that data
+ * going the other way or the ACK for the next segment carries it.  Every
+ * second segment is acknowledged at once, and none waits longer than the
+ * connection's delay (RFC 1122).
+ * @param tcbptr pointer to transmission control block for connection
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+void tcpDelack(struct tcb *tcbptr)
+{
+    if ((0 == tcbptr->delack) || (tcbptr->sndflg & TCP_FLG_DELACK))
+    {
+        tcbptr->sndflg |= TCP_FLG_SNDACK;
+        return;
+    }
+
+    tcbptr->sndflg |= TCP_FLG_DELACK;
+    if (SYSERR == tcpTimerSched(tcbptr->delack, tcbptr, TCP_EVT_DELACK))
+    {
+        tcbptr->sndflg |= TCP_FLG_SNDACK;
+    }
+}
+
+/**
+ * Send an ACK that was delayed, if nothing has sent one since.
+ * @param tcbptr pointer to transmission control block for connection
+ * @return OK if no ACK was needed or it was sent, otherwise SYSERR
+ */
+int tcpSendDelack(struct tcb *tcbptr)
+{
+    int result = OK;
+
+    wait(tcbptr->mutex);
+    if (tcbptr->sndflg & TCP_FLG_DELACK)
+    {
+        TCP_TRACE("Delayed ACK");
+        result = tcpSendAck(tcbptr);
+    }
+    signal(tcbptr->mutex);
+    return result;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file tcpSendMss.c
+ * @provides tcpSendMss
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <ipv4.h>
+#include <route.h>
+#include <tcp.h>
+
+/**
+ * Fit the send MSS to both what the remote host accepts and the path MTU
+ * to it.  Segments are sent with DF set, so a router reports where they
+ * are too big and the path MTU drops until that report ages out.
+ * @param tcbptr pointer to transmission control block for connection
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+void tcpSendMss(struct tcb *tcbptr)
+{
+    ushort mss;
+
+    mss = tcbptr->peermss;
+    if ((OK == rtCacheLookup(&tcbptr->rtcache, &tcbptr->remoteip))
+        && (tcbptr->rtcache.mtu - IPv4_HDR_LEN - TCP_HDR_LEN < mss))
+    {
+        mss = tcbptr->rtcache.mtu - IPv4_HDR_LEN - TCP_HDR_LEN;
+    }
+    tcbptr->sndmss = mss;
+}
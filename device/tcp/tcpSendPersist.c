@@ -21,7 +21,7 @@ int tcpSendPersist(struct tcb *tcbptr)
     wait(tcbptr->mutex);
 
     /* Verify there is data to transmit */
-    if (tcbptr->ocount <= 0)
+    if (0 == tcpOutPending(tcbptr))
     {
         tcbptr->sndflg &= ~TCP_FLG_PERSIST;
         signal(tcbptr->mutex);
@@ -37,15 +37,15 @@ int tcpSendPersist(struct tcb *tcbptr)
     tcpTimerSched(tcbptr->psttime, tcbptr, TCP_EVT_PERSIST);
 
     /* Send as much as possible */
-    tosend = tcbptr->ocount;
+    tosend = tcpOutPending(tcbptr);
     if (tosend > tcbptr->sndmss)
     {
         tosend = tcbptr->sndmss;
     }
 
     /* Send data */
-    tcpSend(tcbptr, TCP_CTRL_ACK, tcbptr->snduna, tcbptr->rcvnxt,
-            tcbptr->ostart, tosend);
+    tcpSend(tcbptr, TCP_CTRL_ACK, tcbptr->snduna, tcbptr->rcvnxt, 0, tosend);
+    tcbptr->instr.probes++;
 
     /* TODO: Determine if flags need to be cleared */
     signal(tcbptr->mutex);
@@ -52,6 +52,9 @@ int tcpSendRst(struct packet *pkt, struct netaddr *src,
     outtcp->dstpt = tcp->srcpt;
     outtcp->offset = octets2offset(TCP_HDR_LEN);
     outtcp->control = TCP_CTRL_RST;
+    outtcp->window = 0;
+    outtcp->chksum = 0;
+    outtcp->urgent = 0;
     if (tcp->control & TCP_CTRL_ACK)
     {
         outtcp->seqnum = tcp->acknum;
@@ -84,7 +87,7 @@ int tcpSendRst(struct packet *pkt, struct netaddr *src,
     outtcp->chksum = tcpChksum(out, TCP_HDR_LEN, src, dst);
 
     /* Send TCP packet */
-    result = ipv4Send(out, src, dst, IPv4_PROTO_TCP);
+    result = ipv4Send(out, src, dst, IPv4_PROTO_TCP, NULL);
 
     if (SYSERR == netFreebuf(out))
     {
@@ -17,7 +17,7 @@
  */
 int tcpSendRxt(struct tcb *tcbptr)
 {
-    uint pending;      /**< amount of data pending ACK */
+    uint flight;       /**< amount of data pending ACK */
     uint tosend;
     uchar control = NULL;
     int time;
@@ -47,6 +47,7 @@ int tcpSendRxt(struct tcb *tcbptr)
         tcpFree(tcbptr);
         return 0;
     }
+    tcbptr->instr.rtos++;
 
     /* Reschedule retransmit event */
     time = tcbptr->rxttime << tcbptr->rxtcount;
@@ -72,49 +73,31 @@ int tcpSendRxt(struct tcb *tcbptr)
         return 1;
     }
 
-    /* Calculate amount of data pending ACK */
-    pending = tcpSeqdiff(tcbptr->sndnxt, tcbptr->snduna);
-    control = TCP_CTRL_ACK;
-
-    /* Determine if FIN is pending ACK */
-    if ((tcbptr->sndflg & TCP_FLG_FIN)
-        && seqlte(tcbptr->snduna, tcbptr->sndfin)
-        && seqlt(tcbptr->sndfin, tcbptr->sndnxt))
-    {
-        control |= TCP_CTRL_FIN;
-    }
-
-    /* Calculate amount of data to send */
-    tosend = pending;
-    if (pending > tcbptr->sndmss)
-    {
-        tosend = tcbptr->sndmss;
-        control &= ~TCP_CTRL_FIN;
-    }
-
     /* Send data */
-    tcpSend(tcbptr, control, tcbptr->snduna, tcbptr->rcvnxt,
-            tcbptr->ostart, tosend);
+    tcbptr->rxtnxt = tcbptr->snduna;
+    tosend = tcpSendUna(tcbptr);
 
-    /* Adjust sender congestion window */
+    /* Adjust sender congestion window (RFC 5681), halving the slow start
+     * threshold only on the first timeout for the segment */
     if (first)
     {
-        tcbptr->sndsst = tcbptr->sndcwn;
-    }
-    if (tcbptr->sndwnd < tcbptr->sndsst)
-    {
-        tcbptr->sndsst = tcbptr->sndwnd >> 1;
-    }
-    else
-    {
-        tcbptr->sndsst = tcbptr->sndsst >> 1;
-    }
-    if (tcbptr->sndsst < tcbptr->sndmss)
-    {
-        tcbptr->sndsst = tcbptr->sndmss;
+        flight = tcpSeqdiff(tcbptr->sndnxt, tcbptr->snduna);
+        tcbptr->sndsst = flight >> 1;
+        if (tcbptr->sndsst < (tcbptr->sndmss << 1))
+        {
+            tcbptr->sndsst = tcbptr->sndmss << 1;
+        }
     }
     tcbptr->sndcwn = tcbptr->sndmss;
 
+    /* Leave fast recovery; dup ACKs for data sent so far are stale, and
+     * the remote side may have dropped what it selectively acknowledged */
+    tcbptr->sndflg &= ~TCP_FLG_RECOVER;
+    tcbptr->recover = tcbptr->sndnxt;
+    tcbptr->dupacks = 0;
+    tcbptr->nsacked = 0;
+    tcpInstrTrace(tcbptr, TCP_TRC_RTO);
+
     signal(tcbptr->mutex);
     return tosend;
 }
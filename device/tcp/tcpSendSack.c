@@ -0,0 +1,67 @@
+/**
+ * @file tcpSendSack.c
+ * @provides tcpSendSack
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <tcp.h>
+
+/**
+ * Resends the next segment of a hole the remote side's selective
+ * acknowledgements show, skipping data already resent in this recovery
+ * (RFC 2018).  Only data below the highest range the remote side holds
+ * counts as a hole.
+ * @param tcbptr pointer to the transmission control block for connection
+ * @return number of octets sent, 0 if there is no hole left to fill
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+int tcpSendSack(struct tcb *tcbptr)
+{
+    struct tcpRange *range;
+    tcpseq seq;
+    uint tosend;
+    uint i;
+
+    seq = tcbptr->rxtnxt;
+    if (seqlt(seq, tcbptr->snduna))
+    {
+        seq = tcbptr->snduna;
+    }
+
+    /* Find the first hole at or past seq */
+    for (i = 0; i < tcbptr->nsacked; i++)
+    {
+        range = &tcbptr->sacked[i];
+        if (seqlt(seq, range->start))
+        {
+            break;
+        }
+        if (seqlt(seq, range->end))
+        {
+            seq = range->end;
+        }
+    }
+    if (i == tcbptr->nsacked)
+    {
+        return 0;
+    }
+
+    /* Send at most a segment of the hole */
+    tcpSendMss(tcbptr);
+    tosend = tcpSeqdiff(tcbptr->sacked[i].start, seq);
+    if (tosend > tcbptr->sndmss)
+    {
+        tosend = tcbptr->sndmss;
+    }
+    tcpSend(tcbptr, TCP_CTRL_ACK, seq, tcbptr->rcvnxt,
+            tcpSeqdiff(seq, tcbptr->snduna), tosend);
+
+    tcbptr->rxtnxt = seqadd(seq, tosend);
+    tcbptr->sackrxt += tosend;
+    TCP_TRACE("SACK resent %u at %u", tosend, seq);
+    return tosend;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file tcpSendUna.c
+ * @provides tcpSendUna
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <tcp.h>
+
+/**
+ * Resends the first unacknowledged segment of data (including FIN) for a
+ * TCP connection.
+ * @param tcbptr pointer to the transmission control block for connection
+ * @return number of octets sent
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+int tcpSendUna(struct tcb *tcbptr)
+{
+    uint pending;      /**< amount of data pending ACK */
+    uint tosend;
+    uchar control;
+
+    /* Resend in segments that fit the path as it is now known */
+    tcpSendMss(tcbptr);
+
+    /* Calculate amount of data pending ACK */
+    pending = tcpSeqdiff(tcbptr->sndnxt, tcbptr->snduna);
+    control = TCP_CTRL_ACK;
+
+    /* Determine if FIN is pending ACK */
+    if ((tcbptr->sndflg & TCP_FLG_FIN)
+        && seqlte(tcbptr->snduna, tcbptr->sndfin)
+        && seqlt(tcbptr->sndfin, tcbptr->sndnxt))
+    {
+        control |= TCP_CTRL_FIN;
+    }
+
+    /* Calculate amount of data to send */
+    tosend = pending;
+    if (pending > tcbptr->sndmss)
+    {
+        tosend = tcbptr->sndmss;
+        control &= ~TCP_CTRL_FIN;
+    }
+
+    /* Send data */
+    tcpSend(tcbptr, control, tcbptr->snduna, tcbptr->rcvnxt, 0, tosend);
+    if (seqlt(tcbptr->rxtnxt, seqadd(tcbptr->snduna, tosend)))
+    {
+        tcbptr->rxtnxt = seqadd(tcbptr->snduna, tosend);
+    }
+
+    return tosend;
+}
@@ -11,17 +11,31 @@
 
 /**
  * Calculates the window size to advertise in an outgoing TCP packet.
+ * Outside the handshake the window is scaled down by the shift agreed
+ * with the remote side (RFC 7323).
  * @param tcbptr pointer to transmission control block for connection
+ * @return value for the window field of the outgoing packet
  * @pre-condition TCB mutex is already held
  * @post-condition TCB mutex is still held
  */
 ushort tcpSendWindow(struct tcb *tcbptr)
 {
-    ushort unused = 0;
-    ushort window = 0;
+    uint unused = 0;
+    uint window = 0;
+    uint size;
+
+    /* Offer no more than the input buffer is being kept to */
+    size = tcpBufTarget(tcbptr->ilimit);
+    if (size > tcbptr->ilen)
+    {
+        size = tcbptr->ilen;
+    }
 
     /* Set proposed window to maximum possible */
-    window = TCP_IBLEN - tcbptr->icount;        // Correct?
+    if (tcbptr->icount < size)
+    {
+        window = size - tcbptr->icount;
+    }
 
     switch (tcbptr->state)
     {
@@ -31,31 +45,39 @@ ushort tcpSendWindow(struct tcb *tcbptr)
     case TCP_LISTEN:
     case TCP_SYNSENT:
     case TCP_SYNRECV:
-        /* Don't do receiver-side silly window syndrome avoidance */
+        /* Don't do receiver-side silly window syndrome avoidance, and
+         * don't scale the window of a SYN */
+        if (window > TCP_MAX_WND)
+        {
+            window = TCP_MAX_WND;
+        }
         tcbptr->rcvwnd = seqadd(tcbptr->rcvnxt, window);
         return window;
     }
 
     /* Receiver-side silly window syndrome avoidance */
     /* Calculate unsued portion of currently advertised window */
-    unused = (ushort)tcpSeqdiff(tcbptr->rcvwnd, tcbptr->rcvnxt);
-#ifdef TCP_FAKEACK
-    if (seqlt(tcbptr->rcvwnd, tcbptr->rcvnxt))
+    if (seqlt(tcbptr->rcvnxt, tcbptr->rcvwnd))
     {
-        unused = 0;
+        unused = tcpSeqdiff(tcbptr->rcvwnd, tcbptr->rcvnxt);
     }
-#endif
     /* Use 0 if proposed window less than 1/4 buffer or less than 1 MSS */
-    if (((window * 4) < TCP_IBLEN) || (window < tcbptr->rcvmss))
+    if (((window * 4) < size) || (window < tcbptr->rcvmss))
     {
         window = 0;
     }
+    /* Round down to what the scaled window field can say */
+    window >>= tcbptr->rcvwsc;
+    if (window > TCP_MAX_WND)
+    {
+        window = TCP_MAX_WND;
+    }
     /* If proposed win is greater than unused advertised win, use new size */
-    if (window > unused)
+    if ((window << tcbptr->rcvwsc) > unused)
     {
-        tcbptr->rcvwnd = seqadd(tcbptr->rcvnxt, window);
+        tcbptr->rcvwnd = seqadd(tcbptr->rcvnxt, window << tcbptr->rcvwsc);
         return window;
     }
     /* Otherwise, keep current advertised window end point */
-    return unused;
+    return unused >> tcbptr->rcvwsc;
 }
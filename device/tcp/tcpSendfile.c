@@ -0,0 +1,94 @@
+/**
+ * @file tcpSendfile.c
+ * @provides tcpSendfile
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <tcp.h>
+
+/**
+ * Send octets that stay where they lie until acknowledged, such as a file
+ * in the tar archive, after what is already in the send buffer.  Each
+ * segment, sent or resent, copies them once from where they lie rather
+ * than through the send buffer.  Blocks until a file already being sent
+ * is acknowledged, unless the connection is non-blocking.
+ * @param tcbptr pointer to transmission control block for connection
+ * @param data octets to send, unchanged until acknowledged
+ * @param len count of octets to send
+ * @return count of octets taken, 0 if non-blocking and a file is already
+ *         being sent, otherwise an error
+ */
+int tcpSendfile(struct tcb *tcbptr, const uchar *data, uint len)
+{
+    bool nonblock;
+    int check;
+
+    if (0 == len)
+    {
+        return 0;
+    }
+    if (NULL == data)
+    {
+        return SYSERR;
+    }
+
+    wait(tcbptr->mutex);
+    nonblock = (0 != (tcbptr->sndflg & TCP_FLG_NONBLOCK));
+    signal(tcbptr->mutex);
+
+    /* Take a writer's turn, so nothing written comes between, and wait
+     * for any file already being sent */
+    while (TRUE)
+    {
+        if (!nonblock)
+        {
+            wait(tcbptr->writers);
+        }
+        wait(tcbptr->mutex);
+
+        check = OK;
+        if ((TCP_ESTAB != tcbptr->state) && (TCP_CLOSEWT != tcbptr->state))
+        {
+            check = (tcbptr->sndflg & TCP_FLG_FIN) ?
+                TCP_ERR_CLOSING : TCP_ERR_NOCONN;
+        }
+        if (check != OK)
+        {
+            if (!nonblock)
+            {
+                signal(tcbptr->writers);
+            }
+            signal(tcbptr->mutex);
+            return check;
+        }
+
+        if (0 == tcbptr->sfcount)
+        {
+            break;
+        }
+        signal(tcbptr->mutex);
+        if (nonblock)
+        {
+            return 0;
+        }
+    }
+
+    tcbptr->sfdata = data;
+    tcbptr->sfcount = len;
+    TCP_TRACE("Sending file of %u octets", len);
+
+    /* Writers wait until the file is acknowledged, so a wakeup left for
+     * them is used up */
+    if (semcount(tcbptr->writers) > 0)
+    {
+        wait(tcbptr->writers);
+    }
+
+    tcpSendData(tcbptr);
+    signal(tcbptr->mutex);
+
+    return len;
+}
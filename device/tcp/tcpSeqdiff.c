@@ -11,26 +11,12 @@
 
 /**
  * Calculates the difference between two sequence numbers.
- * @param first sequence number that occurs first
- * @param second sequence number that occurs second
- * @return difference between two sequence numbers
+ * @param first later sequence number
+ * @param second earlier sequence number
+ * @return count of sequence numbers from second up to first
  */
 tcpseq tcpSeqdiff(tcpseq first, tcpseq second)
 {
-/*	if (first <= second)
-	{ return (second-first); }
-	else
-	{ return ((TCP_MAXSEQ - first) + second); }*/
-
-    if ((first < (TCP_MAXSEQ / 2)) && (second > (TCP_MAXSEQ / 2)))
-    {
-        return ((TCP_MAXSEQ - first) + second);
-    }
-
-    if ((second < (TCP_MAXSEQ / 2)) && (first > (TCP_MAXSEQ / 2)))
-    {
-        return ((TCP_MAXSEQ - first) + second);
-    }
-
+    /* Unsigned arithmetic wraps the same way sequence numbers do */
     return first - second;
 }
@@ -10,6 +10,7 @@
 #include <clock.h>
 #include <network.h>
 #include <semaphore.h>
+#include <stdlib.h>
 #include <tcp.h>
 
 static uint tcpIss(void);
@@ -34,15 +35,18 @@ int tcpSetup(struct tcb *tcbptr)
 
     /* Initialize input buffer */
     tcbptr->istart = 0;
-    tcbptr->inxt = 0;
     tcbptr->icount = 0;
     tcbptr->ibytes = 0;
+    tcbptr->nooo = 0;
+    tcbptr->rcvsegs = 0;
     tcbptr->readers = semcreate(0);
 
     /* Initialize output buffer */
     tcbptr->ostart = 0;
     tcbptr->ocount = 0;
     tcbptr->obytes = 0;
+    tcbptr->sfdata = NULL;
+    tcbptr->sfcount = 0;
     tcbptr->writers = semcreate(1);
 
     /* Initialize send fields */
@@ -51,16 +55,33 @@ int tcpSetup(struct tcb *tcbptr)
     tcbptr->sndnxt = tcbptr->iss;
     tcbptr->sndwl2 = tcbptr->iss;
     tcbptr->sndmss = TCP_INIT_MSS;
-    tcbptr->sndflg = NULL;
+    tcbptr->peermss = TCP_INIT_MSS;
+    /* Keep the sending mode if it was set before opening */
+    tcbptr->sndflg &= (TCP_FLG_NODELAY | TCP_FLG_CORK | TCP_FLG_NONBLOCK);
+    tcbptr->sndwsc = 0;
     tcbptr->sndcwn = tcbptr->sndmss;
-    tcbptr->sndsst = TCP_MAX_WND;
+    tcbptr->sndsst = TCP_MAX_WND << TCP_WSC_MAX;
+    tcbptr->dupacks = 0;
+    tcbptr->recover = tcbptr->iss;
+    tcbptr->nsacked = 0;
+    tcbptr->rxtnxt = tcbptr->iss;
+    tcbptr->sackrxt = 0;
     tcbptr->rxttime = TCP_RXT_INITTIME;
     tcbptr->rxtcount = 0;
     tcbptr->psttime = TCP_PST_INITTIME;
+    tcbptr->delack = TCP_DELACK_TIME;
+    tcbptr->acksent = 0;
+    bzero(tcbptr->seghist, sizeof(tcbptr->seghist));
+    bzero(&tcbptr->instr, sizeof(tcbptr->instr));
+
+    /* Discover the path MTU rather than have routers fragment */
+    tcbptr->rtcache.gen = 0;
+    tcbptr->rtcache.pmtud = TRUE;
 
     /* Initialize receive fields */
     tcbptr->rcvmss = TCP_INIT_MSS - TCP_HDR_LEN;
     tcbptr->rcvflg = NULL;
+    tcbptr->rcvwsc = 0;
 
     /* Verify creation of semaphores */
     if ((SYSERR == (int)tcbptr->openclose)
@@ -70,6 +91,12 @@ int tcpSetup(struct tcb *tcbptr)
         return SYSERR;
     }
 
+    /* Allocate buffers, small until a transfer needs them bigger */
+    if (SYSERR == tcpBufAlloc(tcbptr))
+    {
+        return SYSERR;
+    }
+
     return OK;
 }
 
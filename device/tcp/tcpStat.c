@@ -1,12 +1,13 @@
 /*
  * @file     tcpStat.c
- * @provides tcpStat
+ * @provides tcpStat, tcpStatInstr
  *
  * $Id: tcpStat.c 2135 2009-11-20 07:23:03Z svn $
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
+#include <debug.h>
 #include <stdio.h>
 #include <string.h>
 #include <network.h>
@@ -105,6 +106,15 @@ void tcpStat(struct tcb *tcbptr)
     netaddrsprintf(strA, &copy.remoteip);
     printf("Remote Port: %-5d    IP: %-15s\n", copy.remotept, strA);
 
+    /* Listening socket queues */
+    if (copy.backlog > 0)
+    {
+        printf("           ");
+        printf("Accept Queue: %2u/%-2u  SYN Queue: %2u/%-2u  "
+               "SYN Drops: %u\n", copy.acceptlen, copy.backlog,
+               copy.synlen, copy.synmax, copy.syndrops);
+    }
+
     /* Sequence numbers */
     printf("           ");
     printf("Rcv Nxt: %-10u   Wnd: %-10u\n", copy.rcvnxt,
@@ -120,7 +130,130 @@ void tcpStat(struct tcb *tcbptr)
     printf("           ");
     printf("Out Start: %-10u Count: %-10u Read %-10u\n",
            copy.ostart, copy.ocount, copy.obytes);
+    printf("           ");
+    printf("In  Size:  %-10u Limit: %-10u Scale %-2u\n",
+           copy.ilen, copy.ilimit, copy.rcvwsc);
+    printf("           ");
+    printf("Out Size:  %-10u Limit: %-10u Scale %-2u\n",
+           copy.olen, copy.olimit, copy.sndwsc);
+    if (copy.sfcount > 0)
+    {
+        printf("           ");
+        printf("File Unacked: %-10u\n", copy.sfcount);
+    }
+    printf("           ");
+    printf("Data Segs In: %-10u ACKs Out: %-10u Delay: %u ms\n",
+           copy.rcvsegs, copy.acksent, copy.delack);
+    printf("           ");
+    printf("Nagle: %-3s  Cork: %-3s\n",
+           (copy.sndflg & TCP_FLG_NODELAY) ? "off" : "on",
+           (copy.sndflg & TCP_FLG_CORK) ? "on" : "off");
+    printf("           ");
+    printf("Segs Out  <64: %-8u <256: %-8u <512: %-8u\n",
+           copy.seghist[0], copy.seghist[1], copy.seghist[2]);
+    printf("           ");
+    printf("          <1K: %-8u <MSS: %-8u  MSS: %-8u\n",
+           copy.seghist[3], copy.seghist[4], copy.seghist[5]);
+    printf("           ");
+    printf("SACK: %-3s  Ranges: %-3u Resent: %-10u\n",
+           (copy.rcvflg & TCP_FLG_SACK) ? "on" : "off", copy.nsacked,
+           copy.sackrxt);
     printf("\n");
 
     return;
 }
+
+/**
+ * Print the round trip and congestion instrumentation of a connection,
+ * or dump it as the raw struct tcpInstr.
+ * @param tcbptr pointer to transmission control block
+ * @param dump TRUE to dump the struct in hex rather than print it
+ */
+void tcpStatInstr(struct tcb *tcbptr, bool dump)
+{
+    device *pdev;
+    struct tcpInstr instr;
+    struct tcpTrace *trc;
+    uint i, first;
+    char *event;
+
+    if (NULL == tcbptr)
+    {
+        return;
+    }
+
+    wait(tcbptr->mutex);
+    if (tcbptr->devstate != TCP_ALLOC)
+    {
+        signal(tcbptr->mutex);
+        return;
+    }
+    pdev = (device *)&devtab[tcbptr->dev];
+    memcpy(&instr, &tcbptr->instr, sizeof(struct tcpInstr));
+    signal(tcbptr->mutex);
+
+    printf("%-10s ", pdev->name);
+    if (dump)
+    {
+        printf("%u octets\n", sizeof(struct tcpInstr));
+        hexdump(&instr, sizeof(struct tcpInstr), FALSE);
+        printf("\n");
+        return;
+    }
+
+    printf("RTT Samples: %-8u Min: %-8d us  Max: %-8d us\n",
+           instr.rttsamples, instr.rttmin, instr.rttmax);
+    printf("           ");
+    printf("RTT   <1ms: %-8u <4ms: %-8u <16ms: %-8u <64ms: %-8u\n",
+           instr.rtthist[0], instr.rtthist[1], instr.rtthist[2],
+           instr.rtthist[3]);
+    printf("           ");
+    printf("    <256ms: %-8u  <1s: %-8u   <4s: %-8u  4s+: %-8u\n",
+           instr.rtthist[4], instr.rtthist[5], instr.rtthist[6],
+           instr.rtthist[7]);
+    printf("           ");
+    printf("RTOs: %-8u Fast Rxts: %-8u Dup ACKs: %-8u\n",
+           instr.rtos, instr.fastrxts, instr.dupacks);
+    printf("           ");
+    printf("Zero Window Probes: %-8u Out-of-order Segs: %-8u\n",
+           instr.probes, instr.ooosegs);
+
+    /* Samples, oldest first */
+    first = 0;
+    if (instr.ntrace > TCP_NTRACE)
+    {
+        first = instr.ntrace - TCP_NTRACE;
+    }
+    if (first < instr.ntrace)
+    {
+        printf("           ");
+        printf("%-10s %-8s %-10s %-10s %-10s %-10s\n", "Tick", "Event",
+               "Cwnd", "Ssthresh", "SRTT us", "RTTVAR us");
+    }
+    for (i = first; i < instr.ntrace; i++)
+    {
+        trc = &instr.trace[i % TCP_NTRACE];
+        switch (trc->event)
+        {
+        case TCP_TRC_RTT:
+            event = "RTT";
+            break;
+        case TCP_TRC_RTO:
+            event = "RTO";
+            break;
+        case TCP_TRC_FASTRXT:
+            event = "FastRxt";
+            break;
+        case TCP_TRC_RECOVER:
+            event = "Recover";
+            break;
+        default:
+            event = "Unknown";
+            break;
+        }
+        printf("           ");
+        printf("%-10lu %-8s %-10u %-10u %-10d %-10d\n", trc->tick, event,
+               trc->cwnd, trc->ssthresh, trc->srtt, trc->rttvar);
+    }
+    printf("\n");
+}
@@ -1,6 +1,14 @@
 /**
  * @file tcpTimer.c
- * @provides tcpTimer
+ * @provides tcpTimer, tcpTimerNow, tcpTimerLink, tcpTimerUnlink
+ *
+ * Timer events are filed in a wheel with a slot for each clock tick, so
+ * linking an event into the wheel, unlinking it, and finding the events
+ * due at a tick take time independent of how many are pending.  Finding
+ * a free event when scheduling, and finding a TCB's events to purge or
+ * to read the time remaining, still search the whole event table.  The
+ * timer thread sleeps until the earliest event is due, or for good while
+ * there are none, and is woken when an earlier event is scheduled.
  *
  * $Id: tcpTimer.c 2076 2009-09-24 23:05:39Z brylow $
  */
@@ -15,119 +23,195 @@
 #include <thread.h>
 
 struct tcpEvent tcptimertab[TCP_NEVENTS];
+struct tcpEvent *tcpwheel[TCP_NWHEEL];
 semaphore tcpmutex;
 
-static int calcElapsed(int, int);
+static tid_typ timertid;        /* Timer thread */
+static ulong wheelpos;          /* Last tick whose slot was run */
+static ulong wakeat;            /* Tick timer thread sleeps until */
+static bool idle;               /* Timer thread sleeps for good */
+static uint nevents;            /* Count of events in wheel */
+
+#define slot(tick) ((tick) & (TCP_NWHEEL - 1))
+
+static ulong nextExpire(ulong);
 
 /**
  * TCP timer process to manage timeout and retransmit events.
  */
 thread tcpTimer(void)
 {
-    struct tcpEvent *first = NULL;
-    struct tcpEvent *head = NULL;
-    ulong lastticks;
-    ulong lasttime;
-    ulong elapse;
-    irqmask ps;
+    struct tcpEvent *evt;
+    struct tcb *tcbptr;
+    ulong now, next;
     uchar type;
-    struct tcb *tcbptr = NULL;
 
     enable();
 
-    /* Setup timer event delta queue */
+    /* Setup timer wheel */
     bzero(tcptimertab, sizeof(struct tcpEvent) * TCP_NEVENTS);
+    bzero(tcpwheel, sizeof(struct tcpEvent *) * TCP_NWHEEL);
+    nevents = 0;
+    timertid = gettid();
+    wheelpos = tcpTimerNow();
+    idle = TRUE;
     tcpmutex = semcreate(1);
-    head = &tcptimertab[TCP_EVT_HEAD];
-    head->used = TRUE;
-    head->next = NULL;
 
     TCP_TRACE("Timer init complete");
-    /* Initialize timer accounting information */
-    ps = disable();
-    lastticks = clkticks;
-    lasttime = clktime;
-    elapse = 0;
-    restore(ps);
-    sleep(TCP_FREQ);
 
+    wait(tcpmutex);
     while (TRUE)
     {
-//              TCP_TRACE("Tick");
-        wait(tcpmutex);
-        while ((head->next != NULL) && (elapse > 0))
+        /* Run the slots passed since last time, at most one turn */
+        now = tcpTimerNow();
+        if (now - wheelpos > TCP_NWHEEL)
         {
-            first = head->next;
-            if (first->remain > elapse)
-            {
-                first->remain -= elapse;
-                break;
-            }
-
-            elapse -= first->remain;
-            first->remain = 0;
-            while ((first != NULL) && (first->remain <= 0))
+            wheelpos = now - TCP_NWHEEL;
+        }
+        while (wheelpos != now)
+        {
+            wheelpos++;
+            evt = tcpwheel[slot(wheelpos)];
+            while (evt != NULL)
             {
-                /* Save event information and update pointers */
-                type = first->type;
-                tcbptr = first->tcbptr;
-                first->used = FALSE;
-                head->next = first->next;
+                /* Skip events due on a later turn of the wheel */
+                if ((int)(evt->expire - now) > 0)
+                {
+                    evt = evt->next;
+                    continue;
+                }
+
+                /* Save event information and free the event */
+                type = evt->type;
+                tcbptr = evt->tcbptr;
+                tcpTimerUnlink(evt);
+                evt->used = FALSE;
 
                 /* Release mutex in case triggered event needs it */
                 signal(tcpmutex);
-
-                /* Trigger event */
                 tcpTimerTrigger(type, tcbptr);
-
-                /* Reclaim mutex */
                 wait(tcpmutex);
 
-                /* Obtain first event (which may have changed while 
-                 * mutex was released) */
-                first = head->next;
+                /* Start the slot again, as it may have changed while
+                 * mutex was released */
+                evt = tcpwheel[slot(wheelpos)];
             }
         }
-        signal(tcpmutex);
 
-        ps = disable();
-        elapse = calcElapsed(lastticks, lasttime);
-        restore(ps);
+        /* Sleep until the next event is due or an earlier one is
+         * scheduled */
+        if (0 == nevents)
+        {
+            idle = TRUE;
+            signal(tcpmutex);
+            receive();
+        }
+        else
+        {
+            next = nextExpire(now);
+            wakeat = next;
+            idle = FALSE;
+            signal(tcpmutex);
+            recvtime(next - now);
+        }
+        wait(tcpmutex);
+    }
+    return OK;
+}
 
-//        sleep(TCP_FREQ - elapse);
-        sleep(TCP_FREQ);
+/**
+ * Find the tick the earliest event in the wheel is due, looking no
+ * further than one turn of the wheel ahead.
+ * @pre-condition TCP Timer mutex is already held
+ */
+static ulong nextExpire(ulong now)
+{
+    struct tcpEvent *evt;
+    ulong tick;
 
-        ps = disable();
-        elapse = calcElapsed(lastticks, lasttime);
-        lastticks = clkticks;
-        lasttime = clktime;
-        restore(ps);
+    for (tick = now + 1; tick != now + TCP_NWHEEL; tick++)
+    {
+        for (evt = tcpwheel[slot(tick)]; NULL != evt; evt = evt->next)
+        {
+            if ((int)(evt->expire - tick) <= 0)
+            {
+                return tick;
+            }
+        }
     }
-    return OK;
+    return tick;
+}
+
+/**
+ * Current time in timer ticks.
+ * @return count of clock ticks since boot
+ */
+ulong tcpTimerNow(void)
+{
+    irqmask im;
+    ulong now;
+
+    im = disable();
+    now = (clktime * CLKTICKS_PER_SEC) + clkticks;
+    restore(im);
+    return now;
 }
 
 /**
- * Calulates the number of milliseconds elapsed.
- * @param lastticks last value of clock ticks
- * @param lasttime last value of clock time
- * @return number of milliseconds elapsed between the time provided and now 
- * @precondition interrupts are disabled
- * @postcondition interrupts are still disabled
+ * File an event in the wheel slot for the tick it expires on, waking
+ * the timer thread if the event is due before it would wake.  An event
+ * due on a tick whose slot was already run is moved to the next tick.
+ * @param evt event with expire filled in
+ * @pre-condition TCP Timer mutex is already held
+ * @post-condition TCP Timer mutex is still held
  */
-static int calcElapsed(int lastticks, int lasttime)
+void tcpTimerLink(struct tcpEvent *evt)
 {
-    int ticks = 0;
+    struct tcpEvent **head;
 
-    if (lasttime == clktime)
+    if ((int)(evt->expire - wheelpos) <= 0)
     {
-        ticks = clkticks - lastticks;
+        evt->expire = wheelpos + 1;
     }
-    else
+    head = &tcpwheel[slot(evt->expire)];
+    evt->prev = NULL;
+    evt->next = *head;
+    if (NULL != *head)
+    {
+        (*head)->prev = evt;
+    }
+    *head = evt;
+    nevents++;
+
+    if (idle || ((int)(evt->expire - wakeat) < 0))
     {
-        ticks = CLKTICKS_PER_SEC - lastticks;
-        ticks += (clktime - lasttime - 1) * CLKTICKS_PER_SEC;
-        ticks += clkticks;
+        idle = FALSE;
+        wakeat = evt->expire;
+        send(timertid, OK);
     }
+}
 
-    return (ticks * (CLKTICKS_PER_SEC / 1000));
+/**
+ * Take an event out of its wheel slot.
+ * @param evt event to take out
+ * @pre-condition TCP Timer mutex is already held
+ * @post-condition TCP Timer mutex is still held
+ */
+void tcpTimerUnlink(struct tcpEvent *evt)
+{
+    if (NULL != evt->prev)
+    {
+        evt->prev->next = evt->next;
+    }
+    else
+    {
+        tcpwheel[slot(evt->expire)] = evt->next;
+    }
+    if (NULL != evt->next)
+    {
+        evt->next->prev = evt->prev;
+    }
+    evt->next = NULL;
+    evt->prev = NULL;
+    nevents--;
 }
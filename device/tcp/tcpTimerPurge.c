@@ -19,31 +19,24 @@
  */
 devcall tcpTimerPurge(struct tcb *tcbptr, uchar type)
 {
-    struct tcpEvent *prev = NULL;
-    struct tcpEvent *cur = NULL;
+    struct tcpEvent *evt = NULL;
     int result = SYSERR;
+    int i;
 
     wait(tcpmutex);
-    prev = &tcptimertab[TCP_EVT_HEAD];
-    cur = prev->next;
-    while (cur != NULL)
+    for (i = 0; i < TCP_NEVENTS; i++)
     {
-        if ((cur->tcbptr == tcbptr)
-            && ((NULL == type) || (cur->type == type)))
+        evt = &tcptimertab[i];
+        if (evt->used && (evt->tcbptr == tcbptr)
+            && ((NULL == type) || (evt->type == type)))
         {
             if (SYSERR == result)
             {
-                result = cur->time - cur->remain;
+                result = (tcpTimerNow() - evt->start) * TCP_FREQ;
             }
-            if (cur->next != NULL)
-            {
-                cur->next->remain += cur->remain;
-            }
-            prev->next = cur->next;
-            cur->used = FALSE;
+            tcpTimerUnlink(evt);
+            evt->used = FALSE;
         }
-        prev = cur;
-        cur = cur->next;
     }
     signal(tcpmutex);
 
@@ -1,11 +1,13 @@
 /**
  * @file tcpTimerRemain.c
- * @provides tcpTimerRemain
+ * @provides tcpTimerRemain, tcpTimerUsec
  *
  * $Id: tcpTimerRemain.c 2076 2009-09-24 23:05:39Z brylow $
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
+#include <clock.h>
+#include <platform.h>
 #include <semaphore.h>
 #include <stddef.h>
 #include <tcp.h>
@@ -18,22 +20,65 @@
  */
 int tcpTimerRemain(struct tcb *tcbptr, uchar type)
 {
-    struct tcpEvent *cur = NULL;
+    struct tcpEvent *evt = NULL;
     int time = 0;
+    int i;
 
     wait(tcpmutex);
-    cur = tcptimertab[TCP_EVT_HEAD].next;
-    while (cur != NULL)
+    for (i = 0; i < TCP_NEVENTS; i++)
     {
-        time += cur->remain;
-        if ((cur->tcbptr == tcbptr) && (cur->type == type))
+        evt = &tcptimertab[i];
+        if (evt->used && (evt->tcbptr == tcbptr) && (evt->type == type))
         {
-            signal(tcpmutex);
-            return time;
+            time = (int)(evt->expire - tcpTimerNow()) * TCP_FREQ;
+            if (time < 1)
+            {
+                time = 1;
+            }
+            break;
         }
-        cur = cur->next;
     }
     signal(tcpmutex);
 
-    return 0;
+    return time;
+}
+
+/**
+ * Determine microseconds elapsed since a TCP timer event for a particular
+ * TCB was scheduled, measured with the processor cycle counter.
+ * @param tcbptr TCB to which event corresponds
+ * @param type type of timer event
+ * @return microseconds elapsed, SYSERR if no event exists
+ */
+int tcpTimerUsec(struct tcb *tcbptr, uchar type)
+{
+    struct tcpEvent *evt = NULL;
+    ulong cycles = 0;
+    ulong mhz;
+    int i;
+
+    wait(tcpmutex);
+    for (i = 0; i < TCP_NEVENTS; i++)
+    {
+        evt = &tcptimertab[i];
+        if (evt->used && (evt->tcbptr == tcbptr) && (evt->type == type))
+        {
+            cycles = clkcount() - evt->stamp;
+            break;
+        }
+    }
+    signal(tcpmutex);
+
+    if (i >= TCP_NEVENTS)
+    {
+        return SYSERR;
+    }
+
+    /* Counters slower than 1 MHz are scaled by kHz instead */
+    mhz = platform.clkfreq / 1000000;
+    if (0 == mhz)
+    {
+        return (cycles * 1000) / (platform.clkfreq / 1000);
+    }
+    return cycles / mhz;
 }
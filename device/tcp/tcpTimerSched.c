@@ -6,6 +6,7 @@
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
+#include <clock.h>
 #include <semaphore.h>
 #include <stddef.h>
 #include <tcp.h>
@@ -23,8 +24,6 @@ devcall tcpTimerSched(int time, struct tcb *tcbptr, uchar type)
 {
     int evt = 0;
     struct tcpEvent *evtptr = NULL;
-    struct tcpEvent *prev = NULL;
-    struct tcpEvent *next = NULL;
 
     /* Verify parameters */
     if ((time < 0) || (NULL == tcbptr))
@@ -41,26 +40,14 @@ devcall tcpTimerSched(int time, struct tcb *tcbptr, uchar type)
         return SYSERR;
     }
     evtptr = &tcptimertab[evt];
-    evtptr->time = time;
     evtptr->type = type;
     evtptr->tcbptr = tcbptr;
+    evtptr->stamp = clkcount();
+    evtptr->start = tcpTimerNow();
+    evtptr->expire = evtptr->start + ((time + TCP_FREQ - 1) / TCP_FREQ);
 
-    /* Insert event into delta queue */
-    prev = &tcptimertab[TCP_EVT_HEAD];
-    next = prev->next;
-    while ((next != NULL) && (next->remain <= time))
-    {
-        time -= next->remain;
-        prev = next;
-        next = next->next;
-    }
-    evtptr->next = next;
-    prev->next = evtptr;
-    evtptr->remain = time;
-    if (next != NULL)
-    {
-        next->remain -= time;
-    }
+    /* File event in the timer wheel */
+    tcpTimerLink(evtptr);
     signal(tcpmutex);
 
     return OK;
@@ -77,15 +64,10 @@ static int allocEvent(void)
     int evt;
     static int nextevt = 0;
 
-    /* Check all TCP timer event slots (except the head) */
+    /* Check all TCP timer event slots */
     for (evt = 0; evt < TCP_NEVENTS; evt++)
     {
         nextevt = (nextevt + 1) % TCP_NEVENTS;
-        /* Ignore head */
-        if (TCP_EVT_HEAD == nextevt)
-        {
-            continue;
-        }
         if (FALSE == tcptimertab[nextevt].used)
         {
             tcptimertab[nextevt].used = TRUE;
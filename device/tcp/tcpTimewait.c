@@ -0,0 +1,243 @@
+/**
+ * @file tcpTimewait.c
+ * @provides tcpTimewaitAdd, tcpTimewaitRecv, tcpTimewaitStat
+ *
+ * A connection that closes first waits out TIME-WAIT in a small entry
+ * holding only what it needs to answer the other side: the 4-tuple, the
+ * sequence numbers and when it expires.  Its TCB and buffers go back to
+ * the pool at once.  Entries expire as the table is searched, and when
+ * the table is full the entry nearest expiry makes room.
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <clock.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <network.h>
+#include <stdio.h>
+#include <tcp.h>
+
+struct tcpTimewait tcptwtab[TCP_NTIMEWT];
+uint tcptwcount;
+
+/* Seconds an entry lasts, rounded up as clktime may be about to tick */
+#define TWOMSL_SECS ((TCP_TWOMSL + 999) / 1000 + 1)
+
+#define twexpired(tw) ((int)((tw)->expire - clktime) <= 0)
+
+/**
+ * Free an entry.
+ * @pre-condition interrupts are disabled
+ */
+static void twFree(struct tcpTimewait *tw)
+{
+    tw->used = FALSE;
+    tcptwcount--;
+}
+
+/**
+ * Acknowledge a segment for a connection in TIME-WAIT.
+ */
+static int twSendAck(struct tcpTimewait *tw)
+{
+    struct packet *out;
+    struct tcpPkt *tcp;
+    int result;
+
+    out = netGetbuf();
+    if (SYSERR == (int)out)
+    {
+        return SYSERR;
+    }
+    out->curr -= TCP_HDR_LEN;
+    out->len += TCP_HDR_LEN;
+
+    tcp = (struct tcpPkt *)out->curr;
+    tcp->srcpt = hs2net(tw->localpt);
+    tcp->dstpt = hs2net(tw->remotept);
+    tcp->seqnum = hl2net(tw->sndnxt);
+    tcp->acknum = hl2net(tw->rcvnxt);
+    tcp->offset = octets2offset(TCP_HDR_LEN);
+    tcp->control = TCP_CTRL_ACK;
+    tcp->window = 0;
+    tcp->chksum = 0;
+    tcp->urgent = 0;
+    tcp->chksum = tcpChksum(out, TCP_HDR_LEN, &tw->localip, &tw->remoteip);
+
+    TCP_TRACE("TIME-WAIT ACK <S=%u><A=%u>", tw->sndnxt, tw->rcvnxt);
+    result = ipv4Send(out, &tw->localip, &tw->remoteip, IPv4_PROTO_TCP,
+                      NULL);
+
+    if (SYSERR == netFreebuf(out))
+    {
+        return SYSERR;
+    }
+    return result;
+}
+
+/**
+ * Record that a connection has entered TIME-WAIT, so that its TCB can be
+ * freed.  The final ACK must already have been sent.
+ * @param tcbptr pointer to transmission control block for connection
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+void tcpTimewaitAdd(struct tcb *tcbptr)
+{
+    struct tcpTimewait *tw, *oldest = NULL;
+    irqmask im;
+    int i;
+
+    im = disable();
+    for (i = 0; i < TCP_NTIMEWT; i++)
+    {
+        tw = &tcptwtab[i];
+        if (tw->used && twexpired(tw))
+        {
+            twFree(tw);
+        }
+        if (!tw->used)
+        {
+            oldest = tw;
+            break;
+        }
+        if ((NULL == oldest) || ((int)(tw->expire - oldest->expire) < 0))
+        {
+            oldest = tw;
+        }
+    }
+    if (oldest->used)
+    {
+        TCP_TRACE("TIME-WAIT table full, dropping oldest");
+        twFree(oldest);
+    }
+
+    tw = oldest;
+    tw->used = TRUE;
+    tw->localpt = tcbptr->localpt;
+    tw->remotept = tcbptr->remotept;
+    netaddrcpy(&tw->localip, &tcbptr->localip);
+    netaddrcpy(&tw->remoteip, &tcbptr->remoteip);
+    tw->sndnxt = tcbptr->sndnxt;
+    tw->rcvnxt = tcbptr->rcvnxt;
+    tw->expire = clktime + TWOMSL_SECS;
+    tcptwcount++;
+    restore(im);
+
+    TCP_TRACE("TIME-WAIT for TCP%d", tcbptr->dev - TCP0);
+}
+
+/**
+ * Handle an incoming segment for a connection in TIME-WAIT.  A FIN sent
+ * again is acknowledged and restarts the wait; other segments with data
+ * or out of order are acknowledged, and a RST is ignored (RFC 1337).  A
+ * SYN past the end of the old connection ends the wait and is left for
+ * a listener to take.
+ * @param pkt incoming packet, TCP header in host order
+ * @param src source IP address of the packet
+ * @param dst destination IP address of the packet
+ * @return TRUE if the segment was handled, FALSE if no entry took it
+ */
+bool tcpTimewaitRecv(struct packet *pkt, struct netaddr *src,
+                     struct netaddr *dst)
+{
+    struct tcpPkt *tcp;
+    struct tcpTimewait *tw = NULL;
+    struct tcpTimewait copy;
+    ushort tcplen;
+    irqmask im;
+    int i;
+
+    if (0 == tcptwcount)
+    {
+        return FALSE;
+    }
+
+    tcp = (struct tcpPkt *)pkt->curr;
+    tcplen = pkt->len - (pkt->curr - pkt->linkhdr);
+
+    im = disable();
+    for (i = 0; i < TCP_NTIMEWT; i++)
+    {
+        if (!tcptwtab[i].used)
+        {
+            continue;
+        }
+        if (twexpired(&tcptwtab[i]))
+        {
+            twFree(&tcptwtab[i]);
+            continue;
+        }
+        if ((tcptwtab[i].localpt == tcp->dstpt)
+            && (tcptwtab[i].remotept == tcp->srcpt)
+            && netaddrequal(&tcptwtab[i].remoteip, src)
+            && netaddrequal(&tcptwtab[i].localip, dst))
+        {
+            tw = &tcptwtab[i];
+            break;
+        }
+    }
+    if (NULL == tw)
+    {
+        restore(im);
+        return FALSE;
+    }
+
+    if (tcp->control & TCP_CTRL_RST)
+    {
+        restore(im);
+        return TRUE;
+    }
+    if ((tcp->control & TCP_CTRL_SYN) && seqlt(tw->rcvnxt, tcp->seqnum))
+    {
+        TCP_TRACE("SYN ends TIME-WAIT");
+        twFree(tw);
+        restore(im);
+        return FALSE;
+    }
+    if (tcp->control & TCP_CTRL_FIN)
+    {
+        tw->expire = clktime + TWOMSL_SECS;
+    }
+    else if ((0 == tcpSeglen(tcp, tcplen)) && (tw->rcvnxt == tcp->seqnum)
+             && !(tcp->control & TCP_CTRL_SYN))
+    {
+        restore(im);
+        return TRUE;
+    }
+    copy = *tw;
+    restore(im);
+
+    twSendAck(&copy);
+    return TRUE;
+}
+
+/**
+ * Print the connections waiting out TIME-WAIT.
+ */
+void tcpTimewaitStat(void)
+{
+    struct tcpTimewait copy;
+    char strA[20];
+    char strB[20];
+    irqmask im;
+    int i;
+
+    for (i = 0; i < TCP_NTIMEWT; i++)
+    {
+        im = disable();
+        copy = tcptwtab[i];
+        restore(im);
+        if (!copy.used || twexpired(&copy))
+        {
+            continue;
+        }
+        netaddrsprintf(strA, &copy.localip);
+        netaddrsprintf(strB, &copy.remoteip);
+        printf("TIMEWAIT   %s:%u <-> %s:%u  %lu s\n", strA, copy.localpt,
+               strB, copy.remotept, copy.expire - clktime);
+    }
+}
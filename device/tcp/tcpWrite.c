@@ -8,12 +8,16 @@
 
 #include <device.h>
 #include <stddef.h>
+#include <string.h>
 #include <tcp.h>
 
 static int stateCheck(struct tcb *);
+static uint outcopyin(struct tcb *, uchar *, uint);
 
 /**
- * Write into a buffer to send via TCP.
+ * Write into a buffer to send via TCP.  Blocks until all of the buffer is
+ * taken, unless the connection is non-blocking, when it takes only what
+ * fits in the output buffer.
  * @param devptr TCP device table entry
  * @param buf buffer to read octets into
  * @param len size of the buffer
@@ -22,10 +26,10 @@ static int stateCheck(struct tcb *);
 devcall tcpWrite(device *devptr, void *buf, uint len)
 {
     uint count = 0;
-    uchar ch;
     struct tcb *tcbptr;
     uchar *buffer = buf;
     int check;
+    bool nonblock;
 
     tcbptr = &tcptab[devptr->minor];
 
@@ -37,48 +41,102 @@ devcall tcpWrite(device *devptr, void *buf, uint len)
         signal(tcbptr->mutex);
         return check;
     }
+    nonblock = (0 != (tcbptr->sndflg & TCP_FLG_NONBLOCK));
     signal(tcbptr->mutex);
 
-    /* Put each octet from the buffer into output buffer */
+    /* Fill the output buffer a block at a time */
     while (count < len)
     {
-        /* Wait for space and write as much as possible into the output
-         * buffer; Preserve the circular buffer */
-        wait(tcbptr->writers);
+        /* Wait for space */
+        if (!nonblock)
+        {
+            wait(tcbptr->writers);
+        }
         wait(tcbptr->mutex);
 
-        /* Returned if changed to a state where no data can be sent */
+        /* Returned if changed to a state where no data can be sent,
+         * counting what was written before */
         check = stateCheck(tcbptr);
         if (check != OK)
         {
-            signal(tcbptr->writers);
-            return check;
+            if (!nonblock)
+            {
+                signal(tcbptr->writers);
+            }
+            signal(tcbptr->mutex);
+            return (count > 0) ? count : check;
         }
 
-        while ((tcbptr->ocount < TCP_OBLEN) && (count < len))
+        count += outcopyin(tcbptr, buffer + count, len - count);
+
+        /* Grow a full buffer if the remote side and network would take
+         * all it holds, since it is then what limits the transfer */
+        if ((tcbptr->ocount == tcbptr->olen)
+            && (tcbptr->sndwnd >= tcbptr->olen)
+            && (tcbptr->sndcwn >= tcbptr->olen))
         {
-            ch = *buffer++;
-            tcbptr->out[((tcbptr->ostart + tcbptr->ocount) % TCP_OBLEN)] =
-                ch;
-            tcbptr->ocount++;
-            count++;
+            tcpBufGrowOut(tcbptr);
         }
-        /* If space remains, another writer can write */
-        if (tcbptr->ocount < TCP_OBLEN)
+        /* If space remains, another writer can write; if not, a wakeup
+         * left for space a non-blocking write took is used up */
+        if ((tcbptr->ocount < tcbptr->olen) && (0 == tcbptr->sfcount)
+            && (semcount(tcbptr->writers) < 1))
         {
             signal(tcbptr->writers);
         }
+        else if (((tcbptr->ocount == tcbptr->olen)
+                  || (tcbptr->sfcount > 0))
+                 && (semcount(tcbptr->writers) > 0))
+        {
+            wait(tcbptr->writers);
+        }
         if ((TCP_ESTAB == tcbptr->state)
             || (TCP_CLOSEWT == tcbptr->state))
         {
             tcpSendData(tcbptr);
         }
         signal(tcbptr->mutex);
+
+        if (nonblock)
+        {
+            break;
+        }
     }
 
     return count;
 }
 
+/**
+ * Copy octets into the free space of the output buffer, at most two
+ * blocks either side of the end of the buffer.  Nothing is copied while
+ * a file is being sent, as the octets must follow it.
+ * @return count of octets copied
+ */
+static uint outcopyin(struct tcb *tcbptr, uchar *buf, uint len)
+{
+    uint index, first;
+
+    if (tcbptr->sfcount > 0)
+    {
+        return 0;
+    }
+    if (len > tcbptr->olen - tcbptr->ocount)
+    {
+        len = tcbptr->olen - tcbptr->ocount;
+    }
+    index = (tcbptr->ostart + tcbptr->ocount) % tcbptr->olen;
+    first = tcbptr->olen - index;
+    if (first > len)
+    {
+        first = len;
+    }
+    memcpy(&tcbptr->out[index], buf, first);
+    memcpy(tcbptr->out, buf + first, len - first);
+
+    tcbptr->ocount += len;
+    return len;
+}
+
 /*
  * Verifys the connection is an appropriate state
  * @param tcbptr TCB for connection
@@ -92,7 +150,6 @@ static int stateCheck(struct tcb *tcbptr)
     {
     case TCP_CLOSED:
         /* No connection exists */
-        signal(tcbptr->mutex);
         return TCP_ERR_NOCONN;
     case TCP_LISTEN:
         /* If foreign socket is specified change to active connection */
@@ -101,7 +158,6 @@ static int stateCheck(struct tcb *tcbptr)
             tcbptr->state = TCP_SYNSENT;
             if (tcpOpenActive(tcbptr) != OK)
             {
-                signal(tcbptr->mutex);
                 return SYSERR;
             }
             /* Attempt to send SYN */
@@ -110,7 +166,6 @@ static int stateCheck(struct tcb *tcbptr)
                 tcpSendSyn(tcbptr);
             }
         }
-        signal(tcbptr->mutex);
         return TCP_ERR_NOSPEC;
     case TCP_FINWT1:
     case TCP_FINWT2:
@@ -118,7 +173,6 @@ static int stateCheck(struct tcb *tcbptr)
     case TCP_LASTACK:
     case TCP_TIMEWT:
         /* Connection closing */
-        signal(tcbptr->mutex);
         return TCP_ERR_CLOSING;
     }
     return OK;
@@ -18,43 +18,31 @@ thread telnetServerKiller(ushort, ushort);
 
 /**
  * Start telnet server
- * @param ethdev  interface on which telnet server will listen
- * @param port  port on which to start the server
+ * @param lsndev  listening TCP device to accept connections from
  * @param telnetdev  telnet device to use for connection
  * @param shellname     shell device to use for connection
  * @return      OK on success SYSERR on failure
  */
-thread telnetServer(int ethdev, int port, ushort telnetdev,
-                    char *shellname)
+thread telnetServer(int lsndev, ushort telnetdev, char *shellname)
 {
     tid_typ tid, killtid;
     ushort tcpdev;
-    struct netif *interface;
-    struct netaddr *host;
     char thrname[16];
     uchar buf[6];
 
-    TELNET_TRACE("ethdev %d, port %d, telnet %d", ethdev, port,
-                 telnetdev);
-    /* find netaddr of ethernet device */
-    interface = netLookup(ethdev);
-    if (NULL == interface)
-    {
-        close(telnetdev);
-        return SYSERR;
-    }
-    host = &(interface->ip);
+    TELNET_TRACE("listener %d, telnet %d", lsndev, telnetdev);
 
     enable();
 
     while (TRUE)
     {
-        tcpdev = tcpAlloc();
+        /* Wait for a connection, which stays queued while busy */
+        tcpdev = control(lsndev, TCP_CTRL_ACCEPT, 0, 0);
         if (SYSERR == (short)tcpdev)
         {
             close(telnetdev);
             fprintf(stderr,
-                    "telnet server failed to allocate TCP device\n");
+                    "telnet server failed to accept a connection\n");
             return SYSERR;
         }
         sprintf(thrname, "telnetSvrKill_%d\0", (devtab[telnetdev].minor));
@@ -62,17 +50,6 @@ thread telnetServer(int ethdev, int port, ushort telnetdev,
                          thrname, 2, telnetdev, tcpdev);
         ready(killtid, RESCHED_YES);
 
-        if (open(tcpdev, host, NULL, port, NULL, TCP_PASSIVE) < 0)
-        {
-            kill(killtid);
-            close(tcpdev);
-            close(telnetdev);
-            fprintf(stderr,
-                    "telnet server failed to open TCP socket %d\n",
-                    tcpdev);
-            return SYSERR;
-        }
-
         if (SYSERR == open(telnetdev, tcpdev))
         {
             kill(killtid);
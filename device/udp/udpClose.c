@@ -27,12 +27,16 @@ devcall udpClose(device *devptr)
     udpptr = &udptab[devptr->minor];
 
     im = disable();
-    /* Free the in buffer pool */
+    /* Free the in buffer pools */
     bfpfree(udpptr->inPool);
+    bfpfree(udpptr->bigPool);
 
     /* Free the in semaphore */
     semfree(udpptr->isem);
 
+    /* Stop demultiplexing datagrams to this socket */
+    udpHashRemove(udpptr);
+
     /* Clear the UDP structure and the device IO block */
     bzero(udpptr, sizeof(struct udp));
 
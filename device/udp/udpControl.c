@@ -9,9 +9,12 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <device.h>
+#include <interrupt.h>
 #include <network.h>
 #include <udp.h>
 
+static void rehash(struct udp *);
+
 /**
  * Control function for udp devices.
  * @param devptr udp device table entry
@@ -40,6 +43,7 @@ devcall udpControl(device *devptr, int func, long arg1, long arg2)
         {
             netaddrcpy(&(udpptr->localip), (struct netaddr *)arg2);
         }
+        rehash(udpptr);
         return OK;
     case UDP_CTRL_BIND:
         /* arg1 is port and arg2 is pointer to netaddr */
@@ -52,6 +56,7 @@ devcall udpControl(device *devptr, int func, long arg1, long arg2)
         {
             netaddrcpy(&(udpptr->remoteip), (struct netaddr *)arg2);
         }
+        rehash(udpptr);
         return OK;
     case UDP_CTRL_CLRFLAG:
         /* arg1 is the flag we are clearing */
@@ -69,3 +74,21 @@ devcall udpControl(device *devptr, int func, long arg1, long arg2)
 
     return OK;
 }
+
+/**
+ * File an open socket in the demultiplexing hash under its new ports and
+ * addresses.  A closed socket stays out of the hash, so datagrams are
+ * never handed to it.
+ * @param udpptr UDP socket
+ */
+static void rehash(struct udp *udpptr)
+{
+    irqmask im;
+
+    im = disable();
+    if (UDP_FREE != udpptr->state)
+    {
+        udpHashUpdate(udpptr);
+    }
+    restore(im);
+}
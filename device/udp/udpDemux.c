@@ -1,14 +1,53 @@
 /**
  * @file     udpDemux.c
- * @provides udpDemux
+ * @provides udpDemux, udpHashUpdate, udpHashRemove
  *
  * $Id: udpDemux.c 2020 2009-08-13 17:50:08Z mschul $
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
+#include <interrupt.h>
 #include <udp.h>
 
+struct udpHashTab udphash;
+
+#define isexact(ent) \
+    ((NULL != (ent)->remotept) && (NULL != (ent)->remoteip.type))
+#define localhash(pt)  ((pt) & (UDP_NLHASH - 1))
+
+/**
+ * Compute the exact table bucket for a 4-tuple.
+ */
+static uint exacthash(ushort localpt, ushort remotept,
+                      struct netaddr *remoteip)
+{
+    uint h;
+    int i;
+
+    h = ((uint)localpt << 16) | remotept;
+    for (i = 0; i < remoteip->len; i++)
+    {
+        h = (h * 31) + remoteip->addr[i];
+    }
+    h ^= h >> 16;
+    h ^= h >> 8;
+    return h & (UDP_NHASH - 1);
+}
+
+/**
+ * Return the head of the bucket an entry belongs in.
+ */
+static struct udpHashEnt **bucket(struct udpHashEnt *ent)
+{
+    if (isexact(ent))
+    {
+        return &udphash.exact[exacthash(ent->localpt, ent->remotept,
+                                        &ent->remoteip)];
+    }
+    return &udphash.local[localhash(ent->localpt)];
+}
+
 /**
  * Locate the UDP socket for a UDP packet
  * @param dstpt destination port of the UDP packet
@@ -22,49 +61,88 @@
 struct udp *udpDemux(ushort dstpt, ushort srcpt, struct netaddr *dstip,
                      struct netaddr *srcip)
 {
+    struct udpHashEnt *ent;
     struct udp *udpptr = NULL;
-    uint i;
-    uint level = 0;
 
-    /* Cycle through all udp devices to find the best match */
-    for (i = 0; i < NUDP; i++)
+    /* Full match is the best */
+    ent = udphash.exact[exacthash(dstpt, srcpt, srcip)];
+    for (; NULL != ent; ent = ent->next)
     {
-        if (udptab[i].state != UDP_FREE)
+        if ((UDP_FREE != ent->udpptr->state)
+            && (ent->localpt == dstpt) && (ent->remotept == srcpt)
+            && (netaddrequal(&ent->remoteip, srcip))
+            && (netaddrequal(&ent->localip, dstip)))
         {
-            /* Full match is the best */
-            if (level < 3
-                && (udptab[i].localpt == dstpt)
-                && (udptab[i].remotept == srcpt)
-                && (netaddrequal(&udptab[i].remoteip, srcip))
-                && (netaddrequal(&udptab[i].localip, dstip)))
-            {
-                udpptr = &udptab[i];
-                level = 3;
-            }
-
-            /* Src and dst ports match is second */
-            if (level < 2
-                && (udptab[i].localpt == dstpt)
-                && (udptab[i].remotept == srcpt)
-                && (netaddrequal(&udptab[i].localip, dstip))
-                && (udptab[i].remoteip.type == NULL))
-            {
-                udpptr = &udptab[i];
-                level = 2;
-            }
+            return ent->udpptr;
+        }
+    }
 
-            /* Dst ports match is last */
-            if (level < 1
-                && (udptab[i].localpt == dstpt)
-                && (udptab[i].remotept == NULL)
-                && (netaddrequal(&udptab[i].localip, dstip))
-                && (udptab[i].remoteip.type == NULL))
-            {
-                udpptr = &udptab[i];
-                level = 1;
-            }
+    /* Src and dst ports match is second, dst port match is last */
+    ent = udphash.local[localhash(dstpt)];
+    for (; NULL != ent; ent = ent->next)
+    {
+        if ((UDP_FREE == ent->udpptr->state)
+            || (ent->localpt != dstpt) || (ent->remoteip.type != NULL)
+            || !(netaddrequal(&ent->localip, dstip)))
+        {
+            continue;
+        }
+        if (ent->remotept == srcpt)
+        {
+            return ent->udpptr;
+        }
+        if (ent->remotept == NULL)
+        {
+            udpptr = ent->udpptr;
         }
     }
 
     return udpptr;
 }
+
+/**
+ * Remove a socket from the demultiplexing hash, if it is filed there.
+ * @param udpptr UDP socket
+ */
+void udpHashRemove(struct udp *udpptr)
+{
+    struct udpHashEnt *ent = &udpptr->hash;
+    struct udpHashEnt **link;
+    irqmask im;
+
+    im = disable();
+    for (link = bucket(ent); NULL != *link; link = &(*link)->next)
+    {
+        if (*link == ent)
+        {
+            *link = ent->next;
+            ent->next = NULL;
+            break;
+        }
+    }
+    restore(im);
+}
+
+/**
+ * File a socket in the demultiplexing hash under its current ports and
+ * addresses, moving it if it was already filed.
+ * @param udpptr UDP socket
+ */
+void udpHashUpdate(struct udp *udpptr)
+{
+    struct udpHashEnt *ent = &udpptr->hash;
+    struct udpHashEnt **head;
+    irqmask im;
+
+    im = disable();
+    udpHashRemove(udpptr);
+    ent->udpptr = udpptr;
+    ent->localpt = udpptr->localpt;
+    ent->remotept = udpptr->remotept;
+    netaddrcpy(&ent->localip, &udpptr->localip);
+    netaddrcpy(&ent->remoteip, &udpptr->remoteip);
+    head = bucket(ent);
+    ent->next = *head;
+    *head = ent;
+    restore(im);
+}
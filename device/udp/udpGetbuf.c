@@ -9,20 +9,50 @@
 #include <stddef.h>
 #include <bufpool.h>
 #include <network.h>
+#include <semaphore.h>
 #include <stdlib.h>
 #include <udp.h>
 
-struct udpPkt *udpGetbuf(struct udp *udpptr)
+/**
+ * Get a buffer from a UDP socket's pools to hold a received datagram.
+ * Datagrams too long for the socket's usual buffers, reassembled from
+ * fragments, take one of its few larger buffers, and fail rather than
+ * wait when none is free.
+ * @param udpptr pointer to UDP socket
+ * @param len length of datagram, header included
+ * @return pointer to buffer on success, SYSERR on failure
+ */
+struct udpPkt *udpGetbuf(struct udp *udpptr, uint len)
 {
     struct udpPkt *udppkt = NULL;
+    int pool, size;
+
+    if (len <= NET_MAX_PKTLEN)
+    {
+        pool = udpptr->inPool;
+        size = NET_MAX_PKTLEN;
+    }
+    else if (len <= UDP_MAX_RECVLEN)
+    {
+        pool = udpptr->bigPool;
+        size = UDP_MAX_RECVLEN;
+        if (isbadpool(pool) || (semcount(bfptab[pool].freebuf) <= 0))
+        {
+            return (struct udpPkt *)SYSERR;
+        }
+    }
+    else
+    {
+        return (struct udpPkt *)SYSERR;
+    }
 
-    udppkt = bufget(udpptr->inPool);
+    udppkt = bufget(pool);
     if (SYSERR == (int)udppkt)
     {
         return (struct udpPkt *)SYSERR;
     }
 
-    bzero(udppkt, NET_MAX_PKTLEN);
+    bzero(udppkt, size);
 
     return udppkt;
 }
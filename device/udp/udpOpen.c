@@ -100,11 +100,19 @@ devcall udpOpen(device *devptr, va_list ap)
         netaddrcpy(&(udpptr->remoteip), remoteip);
     }
 
+    /* Make the socket visible to incoming datagrams */
+    udpHashUpdate(udpptr);
+
     /* Allocate received UDP packet buffer pool */
     udpptr->inPool = bfpalloc(NET_MAX_PKTLEN, UDP_MAX_PKTS);
     UDP_TRACE("udp%d inPool has been assigned pool ID %d.\r\n",
               devptr->minor, udpptr->inPool);
 
+    /* Allocate a few larger buffers for reassembled datagrams */
+    udpptr->bigPool = bfpalloc(UDP_MAX_RECVLEN, UDP_MAX_BIGPKTS);
+    UDP_TRACE("udp%d bigPool has been assigned pool ID %d.\r\n",
+              devptr->minor, udpptr->bigPool);
+
     udpptr->flags = 0;
 
     restore(im);
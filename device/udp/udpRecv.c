@@ -92,14 +92,16 @@ syscall udpRecv(struct packet *pkt, struct netaddr *src,
         netaddrcpy(&(udpptr->localip), dst);
         netaddrcpy(&(udpptr->remoteip), src);
         udpptr->flags &= ~UDP_FLAG_BINDFIRST;
+        udpHashUpdate(udpptr);
     }
 
     /* Get some buffer space to store the packet */
-    tpkt = udpGetbuf(udpptr);
+    tpkt = udpGetbuf(udpptr, udppkt->len);
 
     if (SYSERR == (int)tpkt)
     {
         UDP_TRACE("Unable to get UDP buffer from pool. Dropping packet.");
+        restore(im);
         netFreebuf(pkt);
         return SYSERR;
     }
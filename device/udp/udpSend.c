@@ -46,8 +46,6 @@ syscall udpSend(struct udp *udpptr, ushort datalen, void *buf)
     udppkt->len = hs2net(pkt->len);
     udppkt->chksum = 0;
 
-    /* Zero out the data buffer so empty space is padded with zeroes */
-    bzero(udppkt->data, datalen);
     memcpy(udppkt->data, buf, datalen);
 
     /* Calculate UDP checksum (which happens to be the same as TCP's) */
@@ -56,7 +54,7 @@ syscall udpSend(struct udp *udpptr, ushort datalen, void *buf)
 
     /* Send the UDP packet through IP */
     result = ipv4Send(pkt, &(udpptr->localip), &(udpptr->remoteip),
-                      IPv4_PROTO_UDP);
+                      IPv4_PROTO_UDP, &(udpptr->rtcache));
 
     if (SYSERR == netFreebuf(pkt))
     {
@@ -46,14 +46,19 @@
 /* ARP entry is resolved if it is USED and RESOLVED (0b11) */
 #define ARP_RESOLVED        3      /**< Entry is used and resolved      */
 #define ARP_NTHRWAIT        10     /**< Num threads that can wait       */
+#define ARP_NHASH          16      /**< Buckets in ARP hash, power of 2 */
+#define ARP_NPENDING        4      /**< Pkts held per unresolved entry  */
 
 /* ARP Lookup */
 #define ARP_MAX_LOOKUP      5     /**< Num ARP lookup attempts per pkt  */
 #define ARP_MSG_RESOLVED    1     /**< Message shows arp resolution     */
+#define ARP_QUEUED          2     /**< Pkt held until address resolves  */
 
 /* Timing info */
 #define ARP_TTL_UNRESOLVED  5    /**< TTL in secs for unresolv entry  */
 #define ARP_TTL_RESOLVED    300   /**< TTL in secs for resolved entry  */
+#define ARP_RQST_INTERVAL   1     /**< Min secs between requests resent */
+#define ARP_MONITOR_MS      1000  /**< ms between sweeps of ARP table   */
 
 /* ARP thread constants */
 #define ARP_THR_PRIO        NET_THR_PRIO   /**< ARP thread priority     */
@@ -104,25 +109,38 @@ struct arpEntry
     struct netaddr hwaddr;               /**< Hardware address              */
     struct netaddr praddr;               /**< Protocol address              */
     uint expires;                    /**< clktime when entry expires    */
+    uint rqsttime;                   /**< clktime request was last sent */
     tid_typ waiting[ARP_NTHRWAIT];   /**< Threads waiting for entry     */
     int count;                       /**< Count of threads waiting      */
+    struct packet *pending[ARP_NPENDING]; /**< Pkts awaiting resolution */
+    int npending;                    /**< Count of pending packets      */
+    struct arpEntry *next;           /**< Next entry in hash bucket     */
 };
 
 /* ARP table */
 extern struct arpEntry arptab[ARP_NENTRY];
 
+/* ARP table hashed by protocol address */
+extern struct arpEntry *arphash[ARP_NHASH];
+
 /* ARP packet queue for packets requiring reply */
 extern mailbox arpqueue;
 
 /* ARP Function Prototypes */
 struct arpEntry *arpAlloc(void);
 thread arpDaemon(void);
+thread arpMonitor(void);
 struct arpEntry *arpGetEntry(struct netaddr *);
 syscall arpFree(struct arpEntry *);
+uint arpHash(struct netaddr *);
+void arpHashInsert(struct arpEntry *);
+void arpHashRemove(struct arpEntry *);
 syscall arpInit(void);
 syscall arpLookup(struct netif *, struct netaddr *, struct netaddr *);
 syscall arpNotify(struct arpEntry *, message);
 syscall arpRecv(struct packet *);
+syscall arpResolve(struct netif *, struct netaddr *, struct netaddr *,
+                   struct packet *);
 syscall arpSendRqst(struct arpEntry *);
 syscall arpSendReply(struct packet *);
 
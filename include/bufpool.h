@@ -12,8 +12,8 @@
 #include <stddef.h>
 #include <semaphore.h>
 
-#define NPOOL  8
-#define POOL_MAX_BUFSIZE  2048
+#define NPOOL  16
+#define POOL_MAX_BUFSIZE  8192
 #define POOL_MIN_BUFSIZE  8
 #define POOL_MAX_NBUFS    8192
 
@@ -43,6 +43,7 @@
 #define ETH_RX_BUF_SIZE     ( ETH_MAX_PKT_LEN + ETH_CRC_LEN \
                               + sizeof(struct rxHeader) )
 #define ETH_TX_BUF_SIZE     ( ETH_MAX_PKT_LEN )
+#define ETH_RX_PKT_MAX      ( ETH_MAX_PKT_LEN + ETH_CRC_LEN )
 
 /* ETH states */
 #define ETH_STATE_FREE       0
@@ -100,6 +101,9 @@ struct ether
     ulong txTail;               /**< Tx ring tail index                 */
     ulong txRingSize;           /**< Number of Tx ring descriptors      */
     ulong txirq;                /**< Count of Tx interrupt requests     */
+    ulong txkicks;              /**< Count of Tx doorbell writes        */
+    int txwake;                 /**< sem to signal when Tx ring drains  */
+    bool txstall;               /**< a batch was cut short by full ring */
 
     uchar devAddress[ETH_ADDR_LEN];
 
@@ -116,6 +120,7 @@ struct ether
 
     int inPool;                 /**< buffer pool id for input           */
     int outPool;                /**< buffer pool id for output          */
+    int rxPool;                 /**< packet pool for recv handoff       */
 };
 
 extern struct ether ethertab[];
@@ -134,6 +139,11 @@ void etherThroughput(ushort);
 
 int colon2mac(char *, uchar *);
 int allocRxBuffer(struct ether *, int);
+struct packet;
+int etherPoll(struct ether *, struct packet **, int);
+int etherRxFrame(struct ether *, void *, uint);
+void etherRxRearm(struct ether *);
+int etherSendBatch(struct ether *, struct packet **, int);
 int waitOnBit(volatile uint *, uint, const int, int);
 
 #endif                          /* _ETHER_H_ */
@@ -39,6 +39,9 @@ struct ethloop
     device *dev;                    /**< device table entry                 */
     int poolid;                     /**< poolid for the buffer pool         */
     uchar flags;                    /**< flags                              */
+    int rxpool;                     /**< packet pool for recv handoff       */
+    int txwake;                     /**< sem to signal when queue drains    */
+    bool txstall;                   /**< a batch was cut short, queue full  */
 
     /* Packet queue */
     int index;                  /**< index of first packet in buffer    */
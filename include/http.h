@@ -103,6 +103,7 @@ extern const struct httpcmd httpcmdtab[];
 extern ulong nhttpcmd;              /**< number of commands in table    */
 extern semaphore maxhttp;           /**< counter for HTTP threads       */
 extern semaphore activeXWeb;        /**< on/off status of webserver     */
+extern int httplisten;              /**< listening TCP device, or SYSERR */
 
 /* HTTP device structure */
 struct http
@@ -53,6 +53,15 @@
 #define IPv4_FLAG_MF 		0x2000
 #define IPv4_FLAG_DF 		0x4000
 
+/* Fragment reassembly */
+#define IPv4_REASM_MAXLEN   4096  /**< Largest payload reassembled       */
+#define IPv4_REASM_NBUF     8     /**< Datagrams reassembled at once     */
+#define IPv4_REASM_TIMEOUT  30    /**< Seconds to wait for all fragments */
+#define IPv4_REASM_NOHOLE   0xFFFF  /**< End of hole list                */
+#define IPv4_REASM_INF      0xFFFF  /**< Last byte of open-ended hole    */
+#define IPv4_REASM_THR_PRIO NET_THR_PRIO  /**< Reassembly timer priority */
+#define IPv4_REASM_THR_STK  NET_THR_STK   /**< Reassembly timer stack    */
+
 /* Types of service */
 #define IPv4_TOS_NETCNTRL	0x7
 #define IPv4_TOS_INTCNTRL	0x6
@@ -102,13 +111,59 @@ struct ipv4Pkt             /**< IPv4 Packet Variables                   */
     uchar opts[1];           /**< Options and padding is variable       */
 };
 
+/**
+ * Gap in a datagram being reassembled (RFC 815).  A descriptor is kept
+ * in the first bytes of the gap it describes; every gap starts on an
+ * 8 byte boundary, so there is always room for it.
+ */
+struct ipv4Hole
+{
+    ushort first;               /**< Offset of first missing byte      */
+    ushort last;                /**< Offset of last missing byte       */
+    ushort next;                /**< Offset of next hole, or NOHOLE    */
+};
+
+/**
+ * Datagram being reassembled, keyed by source, destination, id and
+ * protocol.  Payload is collected in place in a buffer from the
+ * reassembly pool, so the pool size caps reassembly memory.
+ */
+struct ipv4ReasmEnt
+{
+    struct packet *pkt;         /**< Reassembly buffer, NULL if free   */
+    uchar src[IPv4_ADDR_LEN];   /**< Source address                    */
+    uchar dst[IPv4_ADDR_LEN];   /**< Destination address               */
+    ushort id;                  /**< Identification                    */
+    uchar proto;                /**< Protocol                          */
+    uchar hdrlen;               /**< Header length, 0 until first frag */
+    ushort holes;               /**< Offset of first hole              */
+    ushort total;               /**< Payload length, 0 until last frag */
+    uint expires;               /**< clktime to give up at             */
+    uchar hdr[IPv4_MAX_HDRLEN]; /**< Header of first fragment          */
+};
+
+extern struct ipv4ReasmEnt ipv4reasmtab[];
+extern int ipv4reasmpool;
+
+/* Reassembly statistics */
+extern uint ipv4reasmok;        /**< Datagrams reassembled             */
+extern uint ipv4reasmtimeout;   /**< Datagrams given up on             */
+extern uint ipv4reasmoverflow;  /**< Fragments dropped, no room        */
+
+struct rtCache;
+
 /* Function prototypes */
 syscall dot2ipv4(char *, struct netaddr *);
+struct packet *ipv4Reasm(struct packet *);
+void ipv4ReasmExpire(void);
+syscall ipv4ReasmInit(void);
+thread ipv4ReasmTimer(void);
 syscall ipv4Recv(struct packet *);
 bool ipv4RecvValid(struct ipv4Pkt *);
 bool ipv4RecvDemux(struct netaddr *);
 syscall ipv4Send(struct packet *, struct netaddr *, struct netaddr *,
-                 uchar);
-syscall ipv4SendFrag(struct packet *, struct netaddr *);
+                 uchar, struct rtCache *);
+syscall ipv4SendFrag(struct packet *, struct netaddr *, struct netaddr *,
+                     uint);
 
 #endif                          /* _IPv4_H_ */
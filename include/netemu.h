@@ -8,6 +8,8 @@
 #ifndef _NETEMU_H_
 #define _NETEMU_H_
 
+extern short emudrop;
+
 syscall netemu(struct packet *pkt);
 syscall emuCorrupt(struct packet *pkt);
 syscall emuDelay(struct packet *pkt);
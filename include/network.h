@@ -11,6 +11,7 @@
 #include <stddef.h>
 #include <conf.h>
 #include <ethernet.h>
+#include <semaphore.h>
 #include <string.h>
 
 /* Tracing macros */
@@ -25,6 +26,11 @@
 #define NET_TRACE(...)
 #endif
 
+/* Packet buffers are not cleared on allocation.  Define NET_POISON as a
+ * byte value to fill them with instead, flushing out code that sends
+ * bytes it never wrote. */
+//#define NET_POISON    0xA5
+
 /* Endian conversion macros*/
 #if BYTE_ORDER == LITTLE_ENDIAN
 #define hs2net(x) (unsigned) ((((x)>>8) &0xff) | (((x) & 0xff)<<8))
@@ -65,11 +71,28 @@ bool netaddrbcast(struct netaddr *, struct netaddr *, struct netaddr *);
 #define netaddrcpy(dst, src)     memcpy(dst, src, sizeof(struct netaddr))
 int netaddrsprintf(char *, struct netaddr *);
 
-/* Standard underlying network device driver control functions */
+/* Standard underlying network device driver control functions.
+ * A driver that accepts NET_SET_RXPOOL receives frames directly into
+ * packet buffers taken from that pool.  NET_RECV_POLL then waits for at
+ * least one frame and fills the struct packet * array in arg1 with up to
+ * arg2 (the budget) received packets, returning how many it handed off.
+ * Ownership (and the duty to netFreebuf them) passes to the caller.  A
+ * driver stays quiet (RX interrupts masked) until a poll finds its ring
+ * empty, so a flood costs one wakeup per budget rather than per frame.
+ * A driver that accepts NET_SET_TXWAKE (a semaphore in arg1, SYSERR to
+ * detach) takes frames in batches with NET_SEND_BATCH: arg1 is a
+ * struct packet * array of arg2 frames, each copied from curr for len
+ * bytes onto the transmit ring before a single doorbell write.  It never
+ * blocks; it returns how many frames it consumed and, if that is short,
+ * signals the semaphore once transmit completion frees ring space. */
 #define NET_GET_MTU         200
 #define NET_GET_LINKHDRLEN  201
 #define NET_GET_HWADDR      203
 #define NET_GET_HWBRC       204
+#define NET_SET_RXPOOL      205   /**< Post recv buffers from a pool   */
+#define NET_RECV_POLL       206   /**< Hand off a batch of recv pkts   */
+#define NET_SET_TXWAKE      207   /**< Signal sem when Tx ring drains  */
+#define NET_SEND_BATCH      208   /**< Submit several frames, one kick */
 
 /* Network interface structure definitions */
 #ifdef NETHER
@@ -85,6 +108,12 @@ int netaddrsprintf(char *, struct netaddr *);
 #define NET_NTHR       5              /**< Num net receive threads      */
 #define NET_THR_PRIO   30             /**< Net recv thread priority     */
 #define NET_THR_STK    4096           /**< Net recv thread stack size   */
+#define NET_RECV_BUDGET 16            /**< Max pkts handed off per poll */
+
+/* Network transmit queue constants */
+#define NET_TXQ_DEPTH  32             /**< Frames queued while Tx full  */
+#define NET_XMIT_PRIO  NET_THR_PRIO   /**< Net xmit thread priority     */
+#define NET_XMIT_STK   2048           /**< Net xmit thread stack size   */
 
 /* Network table entry states */
 #define NET_FREE   0                  /**< Netif state free             */
@@ -106,6 +135,20 @@ struct netif
     tid_typ recvthr[NET_NTHR];        /**< Recv thread ids              */
     uint nin;                         /**< Num recv pkts                */
     uint nproc;                       /**< Num recv pkts processed      */
+    uint npoll;                       /**< Num recv polls (handoff)     */
+    uint nbudget;                     /**< Num polls that filled budget */
+    bool txbatch;                     /**< Device takes batched frames  */
+    semaphore txlock;                 /**< Serializes Tx submission     */
+    semaphore txwake;                 /**< Signals Tx ring has space    */
+    tid_typ xmitthr;                  /**< Xmit thread id               */
+    struct packet *txq[NET_TXQ_DEPTH]; /**< Frames awaiting Tx ring */
+    ushort txqstart;                  /**< Index of first queued frame  */
+    ushort txqcount;                  /**< Num queued frames            */
+    uint nout;                        /**< Num pkts handed to device    */
+    uint ntxqueued;                   /**< Num pkts that had to queue   */
+    uint ntxdrop;                     /**< Num pkts dropped, queue full */
+    int rxpool;                       /**< Recv pool shared with device */
+    bool rxhandoff;                   /**< Device hands off recv pkts   */
     void *capture;                    /**< Snoop capture structure      */
 };
 
@@ -139,8 +182,12 @@ struct packet *netGetbuf(void);
 syscall netInit(void);
 struct netif *netLookup(int);
 thread netRecv(struct netif *);
+void netTxFlush(struct netif *);
+syscall netTxQueue(struct netif *, struct packet *);
+thread netXmit(struct netif *);
 syscall netSend(struct packet *, struct netaddr *, struct netaddr *,
                 ushort);
+syscall netSendFrame(struct packet *);
 syscall netUp(int, struct netaddr *, struct netaddr *, struct netaddr *);
 
 #endif                          /* _NETWORK_H_ */
@@ -11,6 +11,7 @@
 #include <stddef.h>
 #include <mailbox.h>
 #include <network.h>
+#include <semaphore.h>
 
 /* Tracing macros */
 //#define TRACE_RT     TTY1
@@ -24,8 +25,8 @@
 #define RT_TRACE(...)
 #endif
 
-/* Route Table (Must include at least one entry for default route) */
-#define RT_NENTRY         32       /**< Number of ARP table entries     */
+/* Route Table */
+#define RT_KEYBITS        32       /**< Bits in an IPv4 route key       */
 #define RT_FREE           0        /**< Entry is free                   */
 #define RT_USED           1        /**< Entry is used                   */
 #define RT_PEND           2        /**< Entry is pending                */
@@ -37,6 +38,14 @@
 /* Route daemon info */
 #define RT_NQUEUE          32      /**< Number of pkts allowed in queue */
 
+/* Path MTU discovery */
+#define RT_NPMTU           16      /**< Destinations with a known PMTU  */
+#define RT_PMTU_MIN        68      /**< Smallest path MTU (RFC 791)     */
+#define RT_PMTU_AGE        600     /**< Seconds a lowered PMTU is kept  */
+
+/* Inline forwarding */
+#define RT_NFWDCACHE       64      /**< Forwarding caches, power of 2   */
+
 /* Route Packet Structure */
 struct rtEntry
 {
@@ -46,10 +55,80 @@ struct rtEntry
     struct netaddr gateway;
     struct netaddr mask;
     struct netif *nif;
+    struct rtEntry *next;       /**< Next route in rtlist, or free   */
+};
+
+/*
+ * Routes are found by longest prefix match in a path-compressed binary
+ * trie.  Each node holds a prefix, the route for exactly that prefix (if
+ * any) and children for the next bit.  A node without a route always has
+ * two children.  Writers are serialized by the caller; each change is
+ * published with interrupts disabled and bumps gen, so readers walk the
+ * trie without locking and retry if gen moved under them.  Nodes that
+ * leave the trie are kept on the trie's free list for reuse, so a reader
+ * never touches returned memory.
+ */
+struct rtNode
+{
+    uint key;                           /**< Prefix bits, host order     */
+    ushort len;                         /**< Prefix length in bits       */
+    struct rtEntry *volatile route;     /**< Route for this prefix       */
+    struct rtNode *volatile child[2];   /**< Subtries for next bit       */
+};
+
+struct rtTrie
+{
+    struct rtNode *volatile root;       /**< Root of trie                */
+    volatile uint gen;                  /**< Bumped by every change      */
+    struct rtNode *free;                /**< Nodes available for reuse   */
+};
+
+/*
+ * Next hop and neighbor for one destination, kept by a connection so a
+ * steady-state send does not search the route or ARP tables.  A cache is
+ * current while its gen matches rtcachegen, which every route change and
+ * ARP table change bumps; the hardware address is also good only until
+ * the ARP entry it came from expires, and the path MTU only until the
+ * PMTU entry it came from ages out.
+ */
+struct rtCache
+{
+    uint gen;                   /**< rtcachegen when filled, 0 if empty */
+    struct netaddr dst;         /**< Destination the cache is for       */
+    struct netif *nif;          /**< Outgoing network interface         */
+    struct netaddr nxthop;      /**< Next hop protocol address          */
+    struct netaddr hwaddr;      /**< Next hop hardware address, if known*/
+    uint expires;               /**< clktime when hwaddr goes stale     */
+    ushort mtu;                 /**< Path MTU to the destination        */
+    uint mtuexpires;            /**< clktime when mtu goes stale, or 0  */
+    bool pmtud;                 /**< Set DF, leave PMTU to ICMP (owner) */
 };
 
-/* Route table */
-extern struct rtEntry rttab[RT_NENTRY];
+/**
+ * Path MTU learned for a destination from ICMP fragmentation needed
+ * messages (RFC 1191).
+ */
+struct rtPmtu
+{
+    struct netaddr dst;         /**< Destination, type NULL if free     */
+    ushort mtu;                 /**< Path MTU                           */
+    uint expires;               /**< clktime when the entry ages out    */
+};
+
+extern struct rtPmtu rtpmtutab[];
+
+extern volatile uint rtcachegen;
+
+/* Forwarding statistics */
+extern uint rtnfwdfast;         /**< Forwarded by receiving thread   */
+extern uint rtnfwdslow;         /**< Forwarded by route daemon       */
+
+/* Routes in the order they were added, and the trie indexing them */
+extern struct rtEntry *rtlist;
+extern struct rtTrie rttrie;
+
+/* Serializes changes to the route table */
+extern semaphore rtlock;
 
 /* Route pakcet queue for packets requiring routing */
 extern mailbox rtqueue;
@@ -58,13 +137,24 @@ extern mailbox rtqueue;
 syscall rtAdd(struct netaddr *dst, struct netaddr *gate,
               struct netaddr *mask, struct netif *nif);
 struct rtEntry *rtAlloc(void);
+void rtCacheFlush(void);
+syscall rtCacheLookup(struct rtCache *cache, struct netaddr *dst);
+void rtFree(struct rtEntry *rtptr);
 thread rtDaemon(void);
 syscall rtDefault(struct netaddr *gate, struct netif *nif);
+syscall rtForward(struct packet *pkt);
 syscall rtInit(void);
 struct rtEntry *rtLookup(struct netaddr *addr);
+ushort rtPmtuLookup(struct netaddr *dst, ushort mtu, uint *expires);
+syscall rtPmtuUpdate(struct netaddr *dst, ushort mtu, ushort len);
 syscall rtRecv(struct packet *pkt);
 syscall rtRemove(struct netaddr *dst);
 syscall rtClear(struct netif *nif);
 syscall rtSend(struct packet *pkt);
+syscall rtTrieInsert(struct rtTrie *trie, struct rtEntry *rtptr);
+void rtTrieRemove(struct rtTrie *trie, struct rtEntry *rtptr,
+                  struct rtEntry *repl);
+struct rtEntry *rtTrieLookup(struct rtTrie *trie, struct netaddr *addr);
+void rtTrieDestroy(struct rtTrie *trie);
 
 #endif                          /* _ROUTE_H_ */
@@ -61,5 +61,6 @@ int tarListFiles(struct tar *, char *, int);
 struct tar *tarGetFile(struct tar *, char *);
 int tarGetFilesize(struct tar *);
 int tarGetData(struct tar *, char *, uint);
+char *tarGetDataAddr(struct tar *);
 
 #endif                          /* _TAR_H_ */
@@ -10,8 +10,11 @@
 
 #include <stddef.h>
 #include <conf.h>
+#include <clock.h>
 #include <ethernet.h>
 #include <ipv4.h>
+#include <memory.h>
+#include <route.h>
 #include <semaphore.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -74,8 +77,14 @@ struct tcpPkt
 #define TCP_OPT_END      0 /**< end of option list */
 #define TCP_OPT_NOP      1 /**< no operation */
 #define TCP_OPT_MSS      2 /**< maximum segment size */
-#define TCP_OPT_MSS_SIZE 6 /**< bytes needed for MSS option */
+#define TCP_OPT_WSCALE   3 /**< window scale */
+#define TCP_OPT_SACKOK   4 /**< selective acknowledgement permitted */
+#define TCP_OPT_SACK     5 /**< selective acknowledgement */
 #define TCP_OPT_MSS_LEN  4 /**< length of MSS option */
+#define TCP_OPT_WSCALE_LEN 3 /**< length of window scale option */
+#define TCP_OPT_SACKOK_LEN 2 /**< length of SACK permitted option */
+#define TCP_OPT_SACK_BLK 8 /**< length of each SACK block */
+#define TCP_SACK_MAXBLK  4 /**< most SACK blocks that fit in a header */
 
 /* TCP Checksum Pseudo Header */
 struct tcpPseudo
@@ -90,14 +99,119 @@ struct tcpPseudo
 #define TCP_PSEUDO_LEN  12
 
 /* Buffer lengths */
-#define TCP_IBLEN 16384  /**< Size of input buffer, must be multiple of 8 */
-#define TCP_OBLEN 16384  /**< Size of output buffer */
+#define TCP_IBLEN 16384  /**< Initial size of input buffer, multiple of 8 */
+#define TCP_OBLEN 16384  /**< Initial size of output buffer */
+#define TCP_BUFMIN 4096  /**< Smallest a buffer shrinks to */
+#define TCP_BUFLIM (256*1024)   /**< Default most a buffer grows to */
+#define TCP_BUFMAX (1024*1024)  /**< Largest limit a buffer may be given */
+#define TCP_BUFLOWMEM (512*1024) /**< Free memory below which buffers shrink */
+#define TCP_NOOO  8      /**< Out-of-order ranges held in input buffer */
+#define TCP_NSACKED 8    /**< Ranges remote side reports past a gap */
+
+/**
+ * Size a buffer with the given limit is kept to, which is the smallest
+ * size while free memory is low.
+ */
+#define tcpBufTarget(limit) \
+    ((memlist.length < TCP_BUFLOWMEM) ? TCP_BUFMIN : (limit))
+
+/* Listening sockets */
+#define TCP_BACKLOG_MAX 16  /**< Most connections waiting for accept */
+#define TCP_SYNQ_MAX    32  /**< Most half-open connections per listener */
 
 /* Initial sizes */
 #define TCP_INIT_MSS (1440 + TCP_HDR_LEN)
 //#define TCP_INIT_MSS (4 + TCP_HDR_LEN) 
 #define TCP_INIT_WND TCP_INIT_MSS
 #define TCP_MAX_WND 65535
+#define TCP_WSC_MAX 14   /**< Largest window scale shift (RFC 7323) */
+
+/* Data segment size histogram: under 64, 256, 512, 1024, MSS, and MSS */
+#define TCP_NSEGHIST 6
+
+/* Connection demultiplexing hash */
+#define TCP_NHASH   64  /**< Buckets for connected TCBs, power of 2 */
+#define TCP_NLHASH  16  /**< Buckets for listening TCBs, power of 2 */
+
+/**
+ * Entry in the demultiplexing hash.  A TCB whose remote port and IP are
+ * both known is filed by its 4-tuple among the connections; otherwise it
+ * is filed by local port among the listeners.
+ */
+struct tcpHashEnt
+{
+    struct tcpHashEnt *next;    /**< Next entry in the same bucket */
+    struct tcb *tcbptr;         /**< TCB this entry locates */
+    ushort localpt;             /**< Local port number */
+    ushort remotept;            /**< Remote port number, NULL if any */
+    struct netaddr localip;     /**< Local IP address */
+    struct netaddr remoteip;    /**< Remote IP address, type NULL if any */
+};
+
+/**
+ * Demultiplexing hash tables
+ */
+struct tcpHashTab
+{
+    struct tcpHashEnt *conn[TCP_NHASH];     /**< Connected TCBs */
+    struct tcpHashEnt *listen[TCP_NLHASH];  /**< Listening TCBs */
+};
+
+extern struct tcpHashTab tcphash;
+
+/**
+ * Range of sequence numbers, such as data received ahead of a gap or data
+ * the remote side reports it holds past one.
+ */
+struct tcpRange
+{
+    tcpseq start;               /**< First sequence number in range */
+    tcpseq end;                 /**< Sequence number after the last */
+};
+
+/* Instrumentation: round trip histogram under 1, 4, 16, 64, 256 ms, 1 s,
+ * 4 s, and longer; trace of recent congestion samples */
+#define TCP_NRTTHIST 8
+#define TCP_NTRACE   16
+
+/* Events a congestion sample is taken on */
+#define TCP_TRC_RTT     1   /**< round trip measured */
+#define TCP_TRC_RTO     2   /**< retransmission timeout */
+#define TCP_TRC_FASTRXT 3   /**< fast retransmit */
+#define TCP_TRC_RECOVER 4   /**< fast recovery done */
+
+/**
+ * Congestion sample, taken on a round trip measurement or a change in
+ * the congestion window
+ */
+struct tcpTrace
+{
+    ulong tick;                 /**< tcpTimerNow() when taken */
+    uint event;                 /**< what the sample was taken on */
+    uint cwnd;                  /**< congestion window */
+    uint ssthresh;              /**< slow start threshold */
+    int srtt;                   /**< smoothed round trip time (us) */
+    int rttvar;                 /**< round trip deviation (us) */
+};
+
+/**
+ * Per-connection instrumentation, kept whole so it can be copied out as
+ * one block
+ */
+struct tcpInstr
+{
+    uint rttsamples;                /**< round trips measured */
+    int rttmin;                     /**< shortest round trip (us) */
+    int rttmax;                     /**< longest round trip (us) */
+    uint rtthist[TCP_NRTTHIST];     /**< round trips by length */
+    uint rtos;                      /**< retransmission timeouts */
+    uint fastrxts;                  /**< fast retransmits */
+    uint dupacks;                   /**< duplicate ACKs received */
+    uint probes;                    /**< zero window probes sent */
+    uint ooosegs;                   /**< segments held past a gap */
+    uint ntrace;                    /**< samples taken, oldest overwritten */
+    struct tcpTrace trace[TCP_NTRACE];  /**< recent samples, circular */
+};
 
 /**
  * Transmission control block 
@@ -116,6 +230,20 @@ struct tcb
     struct netaddr remoteip;    /**< Remote IP address */
     uchar opentype;             /**< Type of open call */
     semaphore openclose;
+    struct tcpHashEnt hash;     /**< Entry in demultiplexing hash */
+    struct rtCache rtcache;     /**< Next hop for remote address  */
+
+    /* Listening socket */
+    struct tcb *listener;       /**< Listener connection arrived on */
+    struct tcb *qnext;          /**< Next in listener's queue */
+    struct tcb *synq;           /**< Connections not yet established */
+    struct tcb *acceptq;        /**< Connections waiting for accept */
+    ushort synlen;              /**< Count of connections in synq */
+    ushort synmax;              /**< Most connections synq holds */
+    ushort acceptlen;           /**< Count of connections in acceptq */
+    ushort backlog;             /**< Most acceptq holds, 0 if no queue */
+    semaphore accepts;          /**< Count of connections to accept */
+    uint syndrops;              /**< Count of SYNs dropped or pushed out */
 
     /* Receive variables */
     tcpseq rcvnxt;              /**< receive next */
@@ -123,16 +251,21 @@ struct tcb
     tcpseq rcvup;               /**< receive urgent pointer */
     tcpseq rcvfin;              /**< sequence number for received FIN */
     ushort rcvmss;              /**< maximum receive segment size */
-    uchar rcvflg;               /**< receive flags */
+    uchar rcvwsc;               /**< shift of windows sent to remote */
+    ushort rcvflg;              /**< receive flags */
 
     /* Receive buffer */
     semaphore readers;          /**< Count of readers waiting for data */
     uint istart;                /**< Index of first octet ready for user */
     uint icount;                /**< Count of octets ready for user */
-    uint inxt;
-    uchar in[TCP_IBLEN];        /**< Input buffer */
-    uchar imark[TCP_IBLEN];
+    uchar *in;                  /**< Input buffer */
+    uint ilen;                  /**< Size of input buffer */
+    uint ilimit;                /**< Most input buffer grows to */
     uint ibytes;                /**< Count of bytes passed to user */
+    struct tcpRange ooo[TCP_NOOO];  /**< Out-of-order ranges, sorted */
+    uint nooo;                  /**< Count of out-of-order ranges */
+    tcpseq ooorecent;           /**< Start of range last added to */
+    uint rcvsegs;               /**< Count of data segments received */
 
     /* Send variables */
     tcpseq snduna;                  /**< send unacknowledged */
@@ -140,29 +273,68 @@ struct tcb
     uint sndwnd;                    /**< send window */
     uint sndcwn;                    /**< send congestion window */
     uint sndsst;                    /**< send slow start threshold */
+    uint dupacks;                   /**< duplicate ACKs in a row */
+    tcpseq recover;                 /**< sndnxt on entering recovery */
+    struct tcpRange sacked[TCP_NSACKED];    /**< Ranges peer holds, sorted */
+    uint nsacked;                   /**< count of ranges peer holds */
+    tcpseq rxtnxt;                  /**< seq num after last one resent */
+    uint sackrxt;                   /**< octets resent to fill SACK holes */
     tcpseq sndup;                   /**< send urgent pointer */
     tcpseq sndwl1;                  /**< seq num for last win update */
     tcpseq sndwl2;                  /**< ack num for last win update */
     tcpseq iss;                     /**< initial send seq num */
     tcpseq sndfin;                  /**< sequence number for sent FIN */
     ushort sndmss;                  /**< maximum send segment size */
-    uchar sndflg;                   /**< send flags */
-    int sndrtt;                     /**< smoothed sending round trip time */
-    int sndrtd;                     /**< sending round trip deviation */
-    int rxttime;                    /**< retransmission timer */
+    ushort peermss;                 /**< segment size remote accepts */
+    uchar sndwsc;                   /**< shift of windows remote sends */
+    ushort sndflg;                  /**< send flags */
+    int sndrtt;                     /**< smoothed round trip time (us) */
+    int sndrtd;                     /**< round trip deviation (us) */
+    int rxttime;                    /**< retransmission timer (ms) */
     uint rxtcount;                  /**< number of retransmissions */
     int psttime;                    /**< persist timer */
+    ushort delack;                  /**< ms to delay an ACK, 0 for none */
+    uint acksent;                   /**< count of ACK-only segments sent */
+    uint seghist[TCP_NSEGHIST];     /**< count of data segments by size */
+    struct tcpInstr instr;          /**< round trip and congestion counts */
 
     /* Send buffer */
     semaphore writers;         /**< Count of writers waiting for buffer */
     uint ostart;               /**< Index of first octet */
     uint ocount;               /**< Octets in buffer */
-    uchar out[TCP_OBLEN];      /**< Output buffer */
+    uchar *out;                /**< Output buffer */
+    uint olen;                 /**< Size of output buffer */
+    uint olimit;               /**< Most output buffer grows to */
     uint obytes;               /**< Count of bytes acknowledged by receiver */
+
+    /* File sent after the send buffer, straight from where it lies */
+    const uchar *sfdata;       /**< First unacknowledged octet of file */
+    uint sfcount;              /**< Octets of file unacknowledged */
 };
 
 extern struct tcb tcptab[];
 
+/* Connections waiting out TIME-WAIT, which hold no TCB */
+#define TCP_NTIMEWT (4*NTCP)    /**< Most connections in TIME-WAIT */
+
+/**
+ * Connection in TIME-WAIT
+ */
+struct tcpTimewait
+{
+    bool used;                  /**< Is entry in use? */
+    ushort localpt;             /**< Local port number */
+    ushort remotept;            /**< Remote port number */
+    struct netaddr localip;     /**< Local IP address */
+    struct netaddr remoteip;    /**< Remote IP address */
+    tcpseq sndnxt;              /**< Sequence number after our FIN */
+    tcpseq rcvnxt;              /**< Sequence number after remote FIN */
+    ulong expire;               /**< clktime when TIME-WAIT ends */
+};
+
+extern struct tcpTimewait tcptwtab[];
+extern uint tcptwcount;
+
 /* Local port allocation ranges */
 #define TCP_PSTART 10000     /**< start port for allocating */
 #define TCP_PMAX   65000        /**< max TCP port */
@@ -191,6 +363,14 @@ extern struct tcb tcptab[];
 #define TCP_FLG_SNDDATA  0x08   /**< Need to send data */
 #define TCP_FLG_SNDRST   0x10   /**< Need to send a RST */
 #define TCP_FLG_PERSIST  0x20   /**< In persist output state */
+#define TCP_FLG_RECOVER  0x40   /**< In fast recovery */
+#define TCP_FLG_SACK     0x80   /**< SACK permitted by both sides */
+#define TCP_FLG_WSCALE   0x100  /**< Window scaling offered by remote */
+#define TCP_FLG_DELACK   0x200  /**< ACK of received data is delayed */
+#define TCP_FLG_NODELAY  0x400  /**< Send small segments without waiting */
+#define TCP_FLG_CORK     0x800  /**< Send only full-sized segments */
+#define TCP_FLG_NONBLOCK 0x1000 /**< Read and write return at once */
+#define TCP_FLG_PUSH     0x2000 /**< Send what is held, once uncorked */
 
 #define TCP_SEQINCR 904 /**< amount to increment ISS each time */
 
@@ -207,47 +387,71 @@ extern struct tcb tcptab[];
 /* TCP Sequence Macros */
 #define seqlt(a, b) (((int)(a) - (int)(b)) < 0)
 #define seqlte(a, b) (((int)(a) - (int)(b)) <= 0)
-#define seqadd(a, b) (((a) + (b)) % TCP_MAXSEQ)
+#define seqadd(a, b) ((tcpseq)((a) + (b)))
 
 /* TCP Length Macros */
 #define tcpSeglen(tcppkt, len) (len - offset2octets(tcppkt->offset))
+#define tcpOutPending(tcbptr) ((tcbptr)->ocount + (tcbptr)->sfcount)
 
 /* TCP Timer Constants */
-#define TCP_NEVENTS     (3*NTCP)+1 /**< max number events (incl dummy head) */
-#define TCP_EVT_HEAD    0   /**< Head entry */
-#define TCP_FREQ        10  /**< milliseconds per timer tick */
-#define TCP_EVT_TIMEWT  1   /**< 2MSL time-wait timeout */
+#define TCP_NEVENTS     (4*NTCP)    /**< max number events */
+#define TCP_NWHEEL      128 /**< slots in timer wheel, power of 2 */
+#define TCP_FREQ        (1000 / CLKTICKS_PER_SEC) /**< ms per timer tick */
 #define TCP_EVT_RXT     2   /**< retransmit event */
 #define TCP_EVT_PERSIST 3   /**< persist event, for zero window */
+#define TCP_EVT_DELACK  4   /**< delayed ACK event */
 
-/* TCP Timer Durations */
-#define TCP_TWOMSL  (5*1000)
+/* TCP Timer Durations, in ms; events fire on timer ticks of TCP_FREQ ms,
+ * so shorter durations, such as TCP_DELACK_MIN, wait for the next tick */
+#define TCP_TWOMSL  (5*1000)    /**< length of TIME-WAIT */
 #define TCP_PST_INITTIME (3*1000)  /**< initial persist time */
 #define TCP_PST_MAXTIME  (64*1000) /**< maximum persist time */
+#define TCP_DELACK_TIME  (100)  /**< default time to delay an ACK */
+#define TCP_DELACK_MIN   (40)   /**< shortest delay for an ACK */
+#define TCP_DELACK_MAX   (200)  /**< longest delay for an ACK */
 
 /* TCP Retransmit */
 #define TCP_RXT_MAXCOUNT 10         /** maximum number of retransmissions */
 #define TCP_RXT_INITTIME (500)  /**< initial retransmission time */
 #define TCP_RXT_MINTIME  (100)    /**< minimum retransmission time */
 #define TCP_RXT_MAXTIME  (32*1000) /**< maximum retransmission time */
+#define TCP_DUPACK_THRESH 3         /**< dup ACKs that mean a lost segment */
 
-/* TCP Timer Event */
+/**
+ * TCP timer event, filed in the wheel slot for the tick it expires on.
+ * Events more than a turn of the wheel away wait in their slot for
+ * later turns.
+ */
 struct tcpEvent
 {
     bool used;                      /**< Is timer event record used? */
-    int time;                       /**< number of TCP timer ticks for event */
-    int remain;                     /**< TCP timer ticks remain */
+    ulong start;                    /**< tick event was scheduled */
+    ulong expire;                   /**< tick event triggers */
+    ulong stamp;                    /**< clkcount() when scheduled */
     uchar type;                     /**< Type of event */
     struct tcb *tcbptr;             /**< TCB for event */
-    struct tcpEvent *next;          /**< Next timer event */
+    struct tcpEvent *next;          /**< Next event in wheel slot */
+    struct tcpEvent *prev;          /**< Previous event in wheel slot */
 };
 
 extern struct tcpEvent tcptimertab[];
+extern struct tcpEvent *tcpwheel[];
 extern semaphore tcpmutex;
 
 /* TCP Control Functions */
 #define TCP_CTRL_RECVBYTES 2 /**< Get number of bytes recevied */
 #define TCP_CTRL_SENTBYTES 3 /**< Get number of bytes sent */
+#define TCP_CTRL_RCVBUF    4 /**< Set most octets input buffer grows to */
+#define TCP_CTRL_SNDBUF    5 /**< Set most octets output buffer grows to */
+#define TCP_CTRL_DELACK    6 /**< Set ms to delay ACKs, 0 for no delay */
+#define TCP_CTRL_NODELAY   7 /**< Turn Nagle coalescing off (TRUE) or on */
+#define TCP_CTRL_CORK      8 /**< Hold segments until they are full */
+#define TCP_CTRL_UNCORK    9 /**< Send what corking held back */
+#define TCP_CTRL_LISTEN   10 /**< Queue connections for accept */
+#define TCP_CTRL_ACCEPT   11 /**< Get device of next connection */
+#define TCP_CTRL_NONBLOCK 12 /**< Read and write what is available (TRUE) */
+#define TCP_CTRL_INSTR    13 /**< Copy instrumentation to a tcpInstr */
+#define TCP_CTRL_SENDFILE 14 /**< Send a file of the tar archive */
 
 /* TCP Ports */
 #define TCP_PORT_TELNET    23
@@ -263,21 +467,42 @@ devcall tcpGetc(device *);
 devcall tcpPutc(device *, char);
 devcall tcpControl(device *, int, long, long);
 
-ushort tcpAlloc(void);
+int tcpAlloc(void);
 ushort tcpChksum(struct packet *, ushort, struct netaddr *,
                  struct netaddr *);
 devcall tcpFree(struct tcb *);
 int tcpOpenActive(struct tcb *);
 void tcpAbort(struct tcb *, int);
 int tcpSetup(struct tcb *);
+int tcpBufAlloc(struct tcb *);
+void tcpBufFree(struct tcb *);
+int tcpBufGrowIn(struct tcb *);
+int tcpBufGrowOut(struct tcb *);
+void tcpBufTrim(struct tcb *);
+struct tcb *tcpListenSyn(struct tcb *, struct netaddr *, ushort);
+void tcpListenEstab(struct tcb *);
+void tcpListenRemove(struct tcb *);
+void tcpListenClose(struct tcb *);
+int tcpAccept(struct tcb *);
+void tcpTimewaitAdd(struct tcb *);
+bool tcpTimewaitRecv(struct packet *, struct netaddr *, struct netaddr *);
+void tcpTimewaitStat(void);
 
 struct tcb *tcpDemux(ushort, ushort, struct netaddr *, struct netaddr *);
+void tcpHashInsert(struct tcpHashTab *, struct tcpHashEnt *);
+void tcpHashRemove(struct tcpHashTab *, struct tcpHashEnt *);
+struct tcpHashEnt *tcpHashLookup(struct tcpHashTab *, ushort, ushort,
+                                 struct netaddr *, struct netaddr *);
+void tcpHashUpdate(struct tcb *);
 int tcpRecv(struct packet *, struct netaddr *, struct netaddr *);
 int tcpRecvOpts(struct packet *, struct tcb *);
 int tcpRecvListen(struct packet *, struct tcb *, struct netaddr *);
 int tcpRecvSynsent(struct packet *, struct tcb *);
 int tcpRecvOther(struct packet *, struct tcb *);
 int tcpRecvData(struct packet *, struct tcb *);
+uint tcpRecvQueue(struct tcb *, tcpseq, uchar *, uint);
+int tcpRangeAdd(struct tcpRange *, uint *, uint, tcpseq, tcpseq);
+void tcpRangeTrim(struct tcpRange *, uint *, tcpseq);
 bool tcpRecvValid(struct packet *, struct tcb *);
 int tcpRecvAck(struct packet *, struct tcb *);
 int tcpRecvRtt(struct tcb *);
@@ -285,19 +510,32 @@ int tcpRecvRtt(struct tcb *);
 int tcpSend(struct tcb *, uchar, uint, uint, uint, ushort);
 ushort tcpSendWindow(struct tcb *);
 int tcpSendAck(struct tcb *);
+void tcpDelack(struct tcb *);
+int tcpSendDelack(struct tcb *);
 int tcpSendSyn(struct tcb *);
 int tcpSendData(struct tcb *);
+void tcpSendMss(struct tcb *);
 int tcpSendRxt(struct tcb *);
+int tcpSendUna(struct tcb *);
+int tcpSendSack(struct tcb *);
 int tcpSendPersist(struct tcb *);
 int tcpSendRst(struct packet *, struct netaddr *, struct netaddr *);
+int tcpSendfile(struct tcb *, const uchar *, uint);
 
 void tcpStat(struct tcb *);
+void tcpStatInstr(struct tcb *, bool);
+void tcpInstrRtt(struct tcb *, int);
+void tcpInstrTrace(struct tcb *, uint);
 
 thread tcpTimer(void);
+ulong tcpTimerNow(void);
+void tcpTimerLink(struct tcpEvent *);
+void tcpTimerUnlink(struct tcpEvent *);
 void tcpTimerTrigger(uchar, struct tcb *);
 devcall tcpTimerSched(int, struct tcb *, uchar);
 devcall tcpTimerPurge(struct tcb *, uchar);
 devcall tcpTimerRemain(struct tcb *, uchar);
+int tcpTimerUsec(struct tcb *, uchar);
 
 tcpseq tcpSeqdiff(tcpseq, tcpseq);
 
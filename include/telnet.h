@@ -122,6 +122,6 @@ devcall telnetGetc(device *);
 devcall telnetPutc(device *, char);
 devcall telnetControl(device *, int, long, long);
 devcall telnetFlush(device *);
-thread telnetServer(int, int, ushort, char *);
+thread telnetServer(int, ushort, char *);
 
 #endif                          /* _TELNET_H_ */
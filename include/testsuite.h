@@ -42,6 +42,8 @@ thread test_snoop(bool);
 thread test_udp(bool);
 thread test_raw(bool);
 thread test_ip(bool);
+thread test_route(bool);
+thread test_tcp(bool);
 thread test_umemory(bool);
 thread test_tlb(bool);
 
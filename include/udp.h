@@ -11,6 +11,7 @@
 #include <stddef.h>
 #include <network.h>
 #include <ipv4.h>
+#include <route.h>
 #include <semaphore.h>
 #include <stdarg.h>
 
@@ -31,6 +32,8 @@
 #define UDP_PSEUDO_LEN      12
 #define UDP_MAX_PKTS        100
 #define UDP_MAX_DATALEN     1024
+#define UDP_MAX_RECVLEN     IPv4_REASM_MAXLEN   /**< Largest datagram kept */
+#define UDP_MAX_BIGPKTS     2   /**< Datagrams over NET_MAX_PKTLEN kept */
 #define UDP_TTL             64
 
 /* UDP standard ports */
@@ -112,6 +115,36 @@ struct udpPseudoHdr             /* Used for checksum */
     ushort len;                     /**< Length of UDP packet   */
 };
 
+/* UDP demultiplexing hash */
+#define UDP_NHASH   32  /**< Buckets for fully bound sockets, power of 2 */
+#define UDP_NLHASH  16  /**< Buckets for sockets by local port, power of 2 */
+
+/**
+ * Entry in the demultiplexing hash.  A socket whose remote port and IP
+ * are both set is filed by its 4-tuple in the exact table; otherwise it
+ * is filed by local port in the local table.
+ */
+struct udpHashEnt
+{
+    struct udpHashEnt *next;    /**< Next entry in the same bucket  */
+    struct udp *udpptr;         /**< Socket this entry locates      */
+    ushort localpt;             /**< Local port                     */
+    ushort remotept;            /**< Remote port, NULL if any       */
+    struct netaddr localip;     /**< Local IP address               */
+    struct netaddr remoteip;    /**< Remote IP, type NULL if any    */
+};
+
+/**
+ * Demultiplexing hash tables
+ */
+struct udpHashTab
+{
+    struct udpHashEnt *exact[UDP_NHASH];    /**< Fully bound sockets */
+    struct udpHashEnt *local[UDP_NLHASH];   /**< Sockets by local port */
+};
+
+extern struct udpHashTab udphash;
+
 /* UDP Control Block */
 
 struct udp
@@ -119,6 +152,7 @@ struct udp
     device *dev;                        /**< UDP device entry               */
     struct udpPkt *in[UDP_MAX_PKTS];    /**< Pointers to stored packets     */
     int inPool;                         /**< Pool of received UDP packets   */
+    int bigPool;                        /**< Pool of reassembled datagrams  */
     int icount;                         /**< Count value for input buffer   */
     int istart;                         /**< Start value for input buffer   */
     semaphore isem;                     /**< Semaphore for input buffer     */
@@ -130,6 +164,8 @@ struct udp
 
     uchar state;                        /**< UDP state                      */
     uchar flags;                        /**< UDP flags                      */
+    struct udpHashEnt hash;             /**< Entry in demultiplexing hash   */
+    struct rtCache rtcache;             /**< Next hop for remote address    */
 };
 
 extern struct udp udptab[];
@@ -144,10 +180,12 @@ ushort udpAlloc(void);
 ushort udpChksum(struct packet *, ushort, struct netaddr *,
                  struct netaddr *);
 struct udp *udpDemux(ushort, ushort, struct netaddr *, struct netaddr *);
+void udpHashRemove(struct udp *);
+void udpHashUpdate(struct udp *);
 syscall udpRecv(struct packet *, struct netaddr *, struct netaddr *);
 syscall udpSend(struct udp *, ushort, void *);
 devcall udpControl(device *, int, long, long);
-struct udpPkt *udpGetbuf(struct udp *);
+struct udpPkt *udpGetbuf(struct udp *, uint);
 syscall udpFreebuf(struct udpPkt *);
 
 #endif                          /* __ASSEMBLER__ */
@@ -6,6 +6,8 @@
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
+#include "wordscan.h"
+
 /** 
  * Returns a pointer to the location in  memory at which which a particular
  * character appears.
@@ -16,11 +18,30 @@
  */
 void *memchr(const void *cs, int c, int n)
 {
-    char *cp = (char *)cs;
+    const uchar *cp = (const uchar *)cs;
+    const ulong *w;
+    ulong mask;
+
+    c = (uchar)c;
+
+    /* Walk bytes up to a word boundary */
+    for (; n > 0 && !WORD_ALIGNED(cp); cp++, n--)
+    {
+        if (*cp == c)
+        {
+            return (void *)cp;
+        }
+    }
+
+    /* Skip whole words that do not contain c */
+    mask = WORD_REPEAT(c);
+    for (w = (const ulong *)cp; n >= (int)WORD_SIZE
+         && !WORD_HASZERO(*w ^ mask); w++, n -= WORD_SIZE)
+        ;
 
-    for (; *cp != '\0'; cp++)
+    for (cp = (const uchar *)w; n > 0; cp++, n--)
     {
-        if (*cp == (unsigned char)c)
+        if (*cp == c)
         {
             return (void *)cp;
         }
@@ -6,6 +6,8 @@
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
+#include "wordscan.h"
+
 /** 
  * Returns a pointer to the location in a string at which which a particular
  * character appears.
@@ -15,7 +17,29 @@
  */
 char *strchr(const char *s, int c)
 {
-    for (; *s != '\0'; s++)
+    const ulong *w;
+    ulong mask;
+
+    /* Walk bytes up to a word boundary */
+    for (; !WORD_ALIGNED(s); s++)
+    {
+        if (*s == (const char)c)
+        {
+            return (char *)s;
+        }
+        if ('\0' == *s)
+        {
+            return 0;
+        }
+    }
+
+    /* Skip whole words holding neither c nor the terminator */
+    mask = WORD_REPEAT(c);
+    for (w = (const ulong *)s;
+         !WORD_HASZERO(*w) && !WORD_HASZERO(*w ^ mask); w++)
+        ;
+
+    for (s = (const char *)w; *s != '\0'; s++)
     {
         if (*s == (const char)c)
         {
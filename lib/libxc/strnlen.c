@@ -6,6 +6,8 @@
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
+#include "wordscan.h"
+
 /**
  * Returns the number of non-NULL bytes in a string or len.
  * @param *s string
@@ -14,11 +16,26 @@
  */
 int strnlen(const char *s, unsigned int len)
 {
-    int n;
+    const char *p = s;
+    const ulong *w;
+
+    /* Walk bytes up to a word boundary */
+    for (; len > 0 && !WORD_ALIGNED(p); p++, len--)
+    {
+        if ('\0' == *p)
+        {
+            return (p - s);
+        }
+    }
+
+    /* Skip whole words that contain no terminator */
+    for (w = (const ulong *)p; len >= WORD_SIZE && !WORD_HASZERO(*w);
+         w++, len -= WORD_SIZE)
+        ;
 
-    n = 0;
-    while (*s++ && n < len)
-        n++;
+    /* Locate the terminator (or the limit) in the final word */
+    for (p = (const char *)w; len > 0 && *p != '\0'; p++, len--)
+        ;
 
-    return (n);
+    return (p - s);
 }
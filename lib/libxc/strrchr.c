@@ -6,6 +6,9 @@
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
+#include <stddef.h>
+#include <string.h>
+
 /**
  * Returns a pointer to the location in a string at which which a particular
  * character last appears.
@@ -16,18 +19,18 @@
 char *strrchr(const char *s, int c)
 {
     char *r = 0;
+    char *p;
 
-    for (; *s != '\0'; s++)
+    if ('\0' == (const char)c)
     {
-        if (*s == (const char)c)
-        {
-            r = (char *)s;
-        }
+        return strchr(s, 0);
     }
 
-    if ((const char)c == *s)
+    /* Hop between occurrences using the word-at-a-time strchr */
+    while ((p = strchr(s, c)) != 0)
     {
-        return (char *)s;
+        r = p;
+        s = p + 1;
     }
 
     return r;
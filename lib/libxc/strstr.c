@@ -6,6 +6,20 @@
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
+#include <stddef.h>
+#include <string.h>
+
+#define MAX(a, b)   ((a) > (b) ? (a) : (b))
+
+/* Bitmap of bytes present in the needle */
+#define BITS_PER_WORD   (8 * sizeof(ulong))
+#define BYTESET_ADD(set, c) \
+    ((set)[(uchar)(c) / BITS_PER_WORD] |= 1UL << ((uchar)(c) % BITS_PER_WORD))
+#define BYTESET_HAS(set, c) \
+    ((set)[(uchar)(c) / BITS_PER_WORD] & (1UL << ((uchar)(c) % BITS_PER_WORD)))
+
+static char *twoway(const uchar *h, const uchar *n);
+
 /** 
  * Returns a pointer to the location in a string at which a particular
  * string appears.
@@ -15,29 +29,185 @@
  */
 char *strstr(const char *cs, const char *ct)
 {
-    char *cq;
-    char *cr;
+    /* Empty needle matches at the start */
+    if ('\0' == *ct)
+    {
+        return (char *)cs;
+    }
+
+    /* Jump to the first candidate with the word-at-a-time strchr */
+    cs = strchr(cs, *ct);
+    if ((NULL == cs) || ('\0' == ct[1]))
+    {
+        return (char *)cs;
+    }
+
+    return twoway((const uchar *)cs, (const uchar *)ct);
+}
+
+/**
+ * Crochemore-Perrin Two-Way string matching.  The needle is split at its
+ * critical factorization; the right half is matched left to right and the
+ * left half right to left, and memory of the matched period prevents
+ * re-examining haystack bytes, so the scan is linear in the haystack
+ * length with O(1) extra space.
+ * @param h haystack, positioned at a candidate first byte
+ * @param n needle, at least two bytes long
+ * @return the pointer in the haystack, NULL if needle not found
+ */
+static char *twoway(const uchar *h, const uchar *n)
+{
+    ulong byteset[256 / BITS_PER_WORD];
+    const uchar *z;             /* known end of haystack        */
+    const uchar *z2;
+    uint l, ip, jp, k, p, ms, p0, mem, mem0, grow;
+
+    memset(byteset, 0, sizeof(byteset));
+
+    /* Compute needle length, bailing if the haystack is shorter */
+    for (l = 0; n[l] && h[l]; l++)
+    {
+        BYTESET_ADD(byteset, n[l]);
+    }
+    if (n[l])
+    {
+        return NULL;
+    }
+
+    /* Maximal suffix under the natural byte order */
+    ip = -1;
+    jp = 0;
+    k = p = 1;
+    while (jp + k < l)
+    {
+        if (n[ip + k] == n[jp + k])
+        {
+            if (k == p)
+            {
+                jp += p;
+                k = 1;
+            }
+            else
+            {
+                k++;
+            }
+        }
+        else if (n[ip + k] > n[jp + k])
+        {
+            jp += k;
+            k = 1;
+            p = jp - ip;
+        }
+        else
+        {
+            ip = jp++;
+            k = p = 1;
+        }
+    }
+    ms = ip;
+    p0 = p;
 
-    for (; *cs != '\0'; cs++)
+    /* Maximal suffix under the reversed byte order */
+    ip = -1;
+    jp = 0;
+    k = p = 1;
+    while (jp + k < l)
     {
-        if (*cs == *ct)
+        if (n[ip + k] == n[jp + k])
         {
-            cq = (char *)cs;
-            cr = (char *)ct;
-            while ((*cq != '\0') && (*cr != '\0'))
+            if (k == p)
+            {
+                jp += p;
+                k = 1;
+            }
+            else
             {
-                if (*cq != *cr)
+                k++;
+            }
+        }
+        else if (n[ip + k] < n[jp + k])
+        {
+            jp += k;
+            k = 1;
+            p = jp - ip;
+        }
+        else
+        {
+            ip = jp++;
+            k = p = 1;
+        }
+    }
+
+    /* The critical factorization is the longer of the two suffixes */
+    if (ip + 1 > ms + 1)
+    {
+        ms = ip;
+    }
+    else
+    {
+        p = p0;
+    }
+
+    /* Periodic needles remember the matched prefix between shifts */
+    if (memcmp(n, n + p, ms + 1))
+    {
+        mem0 = 0;
+        p = MAX(ms, l - ms - 1) + 1;
+    }
+    else
+    {
+        mem0 = l - p;
+    }
+    mem = 0;
+
+    z = h;
+    for (;;)
+    {
+        /* Make sure at least l bytes of haystack are available */
+        if ((uint)(z - h) < l)
+        {
+            grow = l | 63;
+            z2 = memchr(z, 0, grow);
+            if (z2)
+            {
+                z = z2;
+                if ((uint)(z - h) < l)
                 {
-                    break;
+                    return NULL;
                 }
-                cq++;
-                cr++;
             }
-            if ('\0' == *cr)
+            else
             {
-                return (char *)cs;
+                z += grow;
             }
         }
+
+        /* Last byte of the window is not in the needle; skip it all */
+        if (!BYTESET_HAS(byteset, h[l - 1]))
+        {
+            h += l;
+            mem = 0;
+            continue;
+        }
+
+        /* Compare the right half */
+        for (k = MAX(ms + 1, mem); n[k] && n[k] == h[k]; k++)
+            ;
+        if (n[k])
+        {
+            h += k - ms;
+            mem = 0;
+            continue;
+        }
+
+        /* Compare the left half */
+        for (k = ms + 1; k > mem && n[k - 1] == h[k - 1]; k--)
+            ;
+        if (k <= mem)
+        {
+            return (char *)h;
+        }
+        h += p;
+        mem = mem0;
     }
-    return 0;
 }
@@ -0,0 +1,33 @@
+/**
+ * @file wordscan.h
+ * @provides WORD_ALIGNED, WORD_ONES, WORD_HASZERO, WORD_REPEAT.
+ *
+ * Helpers for scanning strings a machine word at a time.  A word
+ * containing a zero byte is detected with the classic "haszero" bit
+ * trick; searching for an arbitrary byte is reduced to a zero test by
+ * XORing the word with the byte replicated into every lane.
+ *
+ * Reads are always aligned, so a word read never crosses into a page
+ * that the string itself does not touch.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#ifndef _WORDSCAN_H_
+#define _WORDSCAN_H_
+
+#include <stddef.h>
+
+#define WORD_SIZE   sizeof(ulong)
+#define WORD_ONES   ((ulong)-1 / 0xFF)    /**< 0x01 in every byte       */
+#define WORD_HIGHS  (WORD_ONES * 0x80)    /**< 0x80 in every byte       */
+
+/** TRUE if pointer p lies on a word boundary */
+#define WORD_ALIGNED(p)     (0 == ((ulong)(p) & (WORD_SIZE - 1)))
+
+/** Replicate byte c into every byte of a word */
+#define WORD_REPEAT(c)      (WORD_ONES * (uchar)(c))
+
+/** Non-zero if any byte of word w is zero */
+#define WORD_HASZERO(w)     (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+
+#endif                          /* _WORDSCAN_H_ */
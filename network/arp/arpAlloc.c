@@ -8,10 +8,14 @@
 
 #include <stddef.h>
 #include <arp.h>
+#include <clock.h>
 #include <stdlib.h>
 
 /**
- * Allocates an entry from the ARP table.
+ * Allocates an entry from the ARP table.  Expired entries are reclaimed
+ * on the way, so packets held on an entry that never resolved are dropped
+ * once it times out.  The caller hashes the entry with arpHashInsert()
+ * after filling in its protocol address.
  * @return entry in ARP table, SYSERR if error occurs
  * @pre-condition interrupts are disabled
  * @post-condition interrupts are still disabled
@@ -19,18 +23,29 @@
 struct arpEntry *arpAlloc(void)
 {
     struct arpEntry *minexpires = NULL;
+    struct arpEntry *unused = NULL;
     int i = 0;
 
     ARP_TRACE("Allocating ARP entry");
 
     for (i = 0; i < ARP_NENTRY; i++)
     {
-        /* If entry is free, return entry */
+        /* Reclaim expired entries */
+        if ((ARP_USED & arptab[i].state) && (arptab[i].expires < clktime))
+        {
+            ARP_TRACE("\tEntry %d expired", i);
+            arpFree(&arptab[i]);
+        }
+
+        /* Remember the first free entry */
         if (ARP_FREE == arptab[i].state)
         {
-            arptab[i].state = ARP_USED;
-            ARP_TRACE("\tFree entry %d", i);
-            return &arptab[i];
+            if (NULL == unused)
+            {
+                ARP_TRACE("\tFree entry %d", i);
+                unused = &arptab[i];
+            }
+            continue;
         }
 
         if ((NULL == minexpires)
@@ -42,6 +57,12 @@ struct arpEntry *arpAlloc(void)
         }
     }
 
+    if (unused != NULL)
+    {
+        unused->state = ARP_USED;
+        return unused;
+    }
+
     /* If no free or minimum expires entry was found an error occured */
     if (NULL == minexpires)
     {
@@ -50,7 +71,7 @@ struct arpEntry *arpAlloc(void)
     }
 
     /* Return entry with minimum expires */
-    bzero(minexpires, sizeof(struct arpEntry));
+    arpFree(minexpires);
     minexpires->state = ARP_USED;
     return minexpires;
 }
@@ -9,14 +9,19 @@
 #include <stddef.h>
 #include <arp.h>
 #include <interrupt.h>
+#include <route.h>
 #include <stdlib.h>
 
 /**
- * Frees an entry from the ARP table.
+ * Frees an entry from the ARP table, dropping any packets still waiting
+ * for it to resolve.
  * @return SYSERR if error occurs, otherwise OK
  */
 syscall arpFree(struct arpEntry *entry)
 {
+    irqmask im;
+    int i;
+
     ARP_TRACE("Freeing ARP entry");
 
     /* Error check pointers */
@@ -32,9 +37,21 @@ syscall arpFree(struct arpEntry *entry)
         ARP_TRACE("Waiting threads notified");
     }
 
-    /* Clear ARP table entry */
+    /* Drop packets that were held for resolution, unhash and clear */
+    im = disable();
+    for (i = 0; i < entry->npending; i++)
+    {
+        netFreebuf(entry->pending[i]);
+    }
+    ARP_TRACE("Dropped %d pending packets", entry->npending);
+    arpHashRemove(entry);
+    if (ARP_RESOLVED == entry->state)
+    {
+        rtCacheFlush();
+    }
     bzero(entry, sizeof(struct arpEntry));
     entry->state = ARP_FREE;
+    restore(im);
     ARP_TRACE("Freed entry %d",
               ((int)entry - (int)arptab) / sizeof(struct arpEntry));
     return OK;
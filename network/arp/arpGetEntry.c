@@ -12,33 +12,30 @@
 #include <interrupt.h>
 
 /**
- * Obtains an entry from the ARP table given a protocol address.
+ * Obtains an entry from the ARP table given a protocol address.  Only the
+ * hash bucket for the address is searched; expired entries found there
+ * are freed.
  * @param praddr protocol address
  * @return entry for correspoding praddr in ARP table, NULL if none exists
  */
 struct arpEntry *arpGetEntry(struct netaddr *praddr)
 {
-    int i = 0;
     struct arpEntry *entry = NULL;  /**< pointer to ARP table entry   */
+    struct arpEntry *next = NULL;   /**< next entry in bucket         */
     irqmask im;                         /**< interrupt state              */
 
     ARP_TRACE("Getting ARP entry");
     im = disable();
 
-    /* Loop through ARP table */
-    for (i = 0; i < ARP_NENTRY; i++)
+    /* Loop through hash bucket */
+    for (entry = arphash[arpHash(praddr)]; entry != NULL; entry = next)
     {
-        /* If ARP entry is not used, skip to next entry */
-        if (!(ARP_USED & arptab[i].state))
-        {
-            continue;
-        }
+        next = entry->next;
 
-        entry = &arptab[i];
         /* Check if entry has timed out */
         if (entry->expires < clktime)
         {
-            ARP_TRACE("\tEntry %d expired", i);
+            ARP_TRACE("\tEntry %d expired", entry - arptab);
             arpFree(entry);
             continue;
         }
@@ -47,7 +44,7 @@ struct arpEntry *arpGetEntry(struct netaddr *praddr)
         if (netaddrequal(&entry->praddr, praddr))
         {
             restore(im);
-            ARP_TRACE("\tEntry %d matches", i);
+            ARP_TRACE("\tEntry %d matches", entry - arptab);
             return entry;
         }
     }
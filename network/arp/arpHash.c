@@ -0,0 +1,72 @@
+/**
+ * @file arpHash.c
+ * @provides arpHash, arpHashInsert, arpHashRemove
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <arp.h>
+#include <interrupt.h>
+
+struct arpEntry *arphash[ARP_NHASH];
+
+/**
+ * Compute the hash bucket for a protocol address.  Hosts on one subnet
+ * differ only in the low bytes, so every byte is folded in.
+ * @param praddr protocol address
+ * @return index into arphash
+ */
+uint arpHash(struct netaddr *praddr)
+{
+    uint h = 0;
+    int i;
+
+    for (i = 0; i < praddr->len; i++)
+    {
+        h = (h * 31) + praddr->addr[i];
+    }
+    h ^= h >> 8;
+    return h & (ARP_NHASH - 1);
+}
+
+/**
+ * Add an ARP table entry to the hash under its protocol address.  The
+ * address must not change until the entry is removed.
+ * @param entry ARP table entry, with praddr filled in
+ */
+void arpHashInsert(struct arpEntry *entry)
+{
+    struct arpEntry **head;
+    irqmask im;
+
+    im = disable();
+    head = &arphash[arpHash(&entry->praddr)];
+    entry->next = *head;
+    *head = entry;
+    restore(im);
+}
+
+/**
+ * Remove an ARP table entry from the hash, if it is present.
+ * @param entry ARP table entry
+ */
+void arpHashRemove(struct arpEntry *entry)
+{
+    struct arpEntry **link;
+    irqmask im;
+
+    im = disable();
+    for (link = &arphash[arpHash(&entry->praddr)]; NULL != *link;
+         link = &(*link)->next)
+    {
+        if (*link == entry)
+        {
+            *link = entry->next;
+            entry->next = NULL;
+            break;
+        }
+    }
+    restore(im);
+}
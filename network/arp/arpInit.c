@@ -29,6 +29,7 @@ syscall arpInit(void)
         bzero(&arptab[i], sizeof(struct arpEntry));
         arptab[i].state = ARP_FREE;
     }
+    bzero(arphash, sizeof(arphash));
 
     /* Initialize ARP queue */
     arpqueue = mailboxAlloc(ARP_NQUEUE);
@@ -42,5 +43,10 @@ syscall arpInit(void)
           ((void *)arpDaemon, ARP_THR_STK, ARP_THR_PRIO, "arpDaemon", 0),
           RESCHED_NO);
 
+    /* Spawn arpMonitor thread */
+    ready(create
+          ((void *)arpMonitor, ARP_THR_STK, ARP_THR_PRIO, "arpMonitor", 0),
+          RESCHED_NO);
+
     return OK;
 }
@@ -64,12 +64,14 @@ syscall arpLookup(struct netif *netptr, struct netaddr *praddr,
             netaddrcpy(&entry->praddr, praddr);
             entry->expires = clktime + ARP_TTL_UNRESOLVED;
             entry->count = 0;
+            arpHashInsert(entry);
         }
 
         /* Place hardware address in buffer if entry is resolved */
         if (ARP_RESOLVED == entry->state)
         {
             netaddrcpy(hwaddr, &entry->hwaddr);
+            restore(im);
             ARP_TRACE("Entry exists");
             return OK;
         }
@@ -0,0 +1,60 @@
+/**
+ * @file arpMonitor.c
+ * @provides arpMonitor
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <arp.h>
+#include <clock.h>
+#include <interrupt.h>
+#include <thread.h>
+
+/**
+ * ARP monitor to sweep the ARP table.  Expired entries are freed, with
+ * any packets still held on them, rather than waiting for a later lookup
+ * to reach them.  Requests are resent for unresolved entries that still
+ * hold packets, in case the request or its reply was lost.
+ */
+thread arpMonitor(void)
+{
+    struct arpEntry *entry = NULL;
+    irqmask im;
+    bool rqst;
+    int i;
+
+    while (TRUE)
+    {
+        sleep(ARP_MONITOR_MS);
+
+        for (i = 0; i < ARP_NENTRY; i++)
+        {
+            entry = &arptab[i];
+            rqst = FALSE;
+
+            im = disable();
+            if ((ARP_USED & entry->state) && (entry->expires < clktime))
+            {
+                ARP_TRACE("Monitor freeing expired entry %d", i);
+                arpFree(entry);
+            }
+            else if ((ARP_UNRESOLVED == entry->state)
+                     && (entry->npending > 0)
+                     && (clktime - entry->rqsttime >= ARP_RQST_INTERVAL))
+            {
+                entry->rqsttime = clktime;
+                rqst = TRUE;
+            }
+            restore(im);
+
+            if (rqst && (SYSERR == arpSendRqst(entry)))
+            {
+                ARP_TRACE("Monitor failed to resend request");
+            }
+        }
+    }
+
+    return OK;
+}
@@ -14,6 +14,7 @@
 #include <ipv4.h>
 #include <mailbox.h>
 #include <network.h>
+#include <route.h>
 #include <string.h>
 
 /**
@@ -29,6 +30,10 @@ syscall arpRecv(struct packet *pkt)
     struct netaddr sha;             /**< source hardware address        */
     struct netaddr spa;             /**< source protocol address        */
     struct netaddr dpa;             /**< destination protocol address   */
+    struct packet *pending[ARP_NPENDING]; /**< pkts held for resolution */
+    int npending = 0;               /**< count of held packets          */
+    struct etherPkt *ether;
+    int i;
     irqmask im;                     /**< interrupt state                */
 
     /* Error check pointers */
@@ -83,17 +88,36 @@ syscall arpRecv(struct packet *pkt)
     if (entry != NULL)
     {
         ARP_TRACE("Entry already exists");
+        if ((ARP_RESOLVED == entry->state)
+            && !netaddrequal(&entry->hwaddr, &sha))
+        {
+            rtCacheFlush();
+        }
         netaddrcpy(&entry->hwaddr, &sha);
         entry->expires = clktime + ARP_TTL_RESOLVED;
 
-        /* Notify threads waiting on resolution */
+        /* Notify threads waiting on resolution, take held packets */
         if (ARP_UNRESOLVED == entry->state)
         {
             entry->state = ARP_RESOLVED;
             arpNotify(entry, ARP_MSG_RESOLVED);
             ARP_TRACE("Notified waiting threads");
+            npending = entry->npending;
+            memcpy(pending, entry->pending, npending * sizeof(struct packet *));
+            entry->npending = 0;
         }
     }
+    restore(im);
+
+    /* Send packets that were held for resolution */
+    for (i = 0; i < npending; i++)
+    {
+        ether = (struct etherPkt *)pending[i]->curr;
+        memcpy(ether->dst, sha.addr, sha.len);
+        netSendFrame(pending[i]);
+        netFreebuf(pending[i]);
+    }
+    ARP_TRACE("Sent %d held packets", npending);
 
     /* Obtain destination protocol address */
     dpa.type = net2hs(arp->prtype);
@@ -101,6 +125,7 @@ syscall arpRecv(struct packet *pkt)
     memcpy(dpa.addr, &arp->addrs[arp->hwalen * 2 + arp->pralen], dpa.len);
 
     /* Verify protocol address is mine */
+    im = disable();
     if (netaddrequal(&netptr->ip, &dpa))
     {
         /* If entry did not already exist, then entry should be added */
@@ -119,6 +144,7 @@ syscall arpRecv(struct packet *pkt)
             netaddrcpy(&entry->hwaddr, &sha);
             netaddrcpy(&entry->praddr, &spa);
             entry->expires = clktime + ARP_TTL_RESOLVED;
+            arpHashInsert(entry);
             ARP_TRACE("Added entry %d (state = %d)",
                       ((int)entry -
                        (int)arptab) / sizeof(struct arpEntry),
@@ -0,0 +1,117 @@
+/**
+ * @file arpResolve.c
+ * @provides arpResolve
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <arp.h>
+#include <bufpool.h>
+#include <clock.h>
+#include <interrupt.h>
+#include <string.h>
+
+/**
+ * Obtains a hardware address from the ARP table without waiting.  If the
+ * address is not resolved yet, a copy of the packet is held on the ARP
+ * table entry until arpRecv() sees a reply or the entry expires.  A
+ * request is sent when the entry is first created, and again, no more
+ * often than ARP_RQST_INTERVAL, while packets are held, in case the
+ * request or its reply was lost.
+ * @param netptr network interface
+ * @param praddr protocol address
+ * @param hwaddr buffer into which hardware address should be placed
+ * @param pkt packet, with link-level header, to hold if unresolved
+ * @return OK if hwaddr was filled in, ARP_QUEUED if a copy of pkt is
+ *  waiting for resolution, otherwise SYSERR
+ */
+syscall arpResolve(struct netif *netptr, struct netaddr *praddr,
+                   struct netaddr *hwaddr, struct packet *pkt)
+{
+    struct arpEntry *entry = NULL;  /**< pointer to ARP table entry   */
+    struct packet *copy = NULL;     /**< copy of pkt held on entry    */
+    bool rqst = FALSE;              /**< request should be sent       */
+    irqmask im;                     /**< interrupt state              */
+
+    /* Error check pointers */
+    if ((NULL == netptr) || (NULL == praddr) || (NULL == hwaddr)
+        || (NULL == pkt))
+    {
+        ARP_TRACE("Invalid args");
+        return SYSERR;
+    }
+
+    ARP_TRACE("Resolving protocol address");
+
+    im = disable();
+    entry = arpGetEntry(praddr);
+
+    /* Place hardware address in buffer if entry is resolved */
+    if ((entry != NULL) && (ARP_RESOLVED == entry->state))
+    {
+        netaddrcpy(hwaddr, &entry->hwaddr);
+        restore(im);
+        ARP_TRACE("Entry exists");
+        return OK;
+    }
+
+    /* If ARP entry does not exist; create an unresolved entry */
+    if (NULL == entry)
+    {
+        ARP_TRACE("Entry does not exist");
+        entry = arpAlloc();
+        if (SYSERR == (int)entry)
+        {
+            restore(im);
+            return SYSERR;
+        }
+
+        entry->state = ARP_UNRESOLVED;
+        entry->nif = netptr;
+        netaddrcpy(&entry->praddr, praddr);
+        entry->expires = clktime + ARP_TTL_UNRESOLVED;
+        arpHashInsert(entry);
+        rqst = TRUE;
+    }
+
+    /* Hold a copy of the packet, without waiting for a free buffer */
+    if ((entry->npending >= ARP_NPENDING)
+        || (semcount(bfptab[netpool].freebuf) <= 0))
+    {
+        restore(im);
+        ARP_TRACE("No room to hold packet");
+        return SYSERR;
+    }
+    copy = netGetbuf();
+    if (SYSERR == (int)copy)
+    {
+        restore(im);
+        return SYSERR;
+    }
+    copy->nif = netptr;
+    copy->len = pkt->len;
+    copy->curr = copy->data;
+    memcpy(copy->curr, pkt->curr, pkt->len);
+    entry->pending[entry->npending] = copy;
+    entry->npending++;
+    ARP_TRACE("Holding packet, %d pending", entry->npending);
+    if (clktime - entry->rqsttime >= ARP_RQST_INTERVAL)
+    {
+        rqst = TRUE;
+    }
+    if (rqst)
+    {
+        entry->rqsttime = clktime;
+    }
+    restore(im);
+
+    /* Send an ARP request for a new entry, or resend one */
+    if (rqst && (SYSERR == arpSendRqst(entry)))
+    {
+        ARP_TRACE("Failed to send request");
+    }
+
+    return ARP_QUEUED;
+}
@@ -10,6 +10,7 @@
 #include <arp.h>
 #include <ethernet.h>
 #include <network.h>
+#include <stdlib.h>
 
 /**
  * Sends an ARP request for an ARP table entry over a network interface. 
@@ -59,6 +60,7 @@ syscall arpSendRqst(struct arpEntry *entry)
     memcpy(&arp->addrs[ARP_ADDR_SHA(arp)], netptr->hwaddr.addr,
            arp->hwalen);
     memcpy(&arp->addrs[ARP_ADDR_SPA(arp)], netptr->ip.addr, arp->pralen);
+    bzero(&arp->addrs[ARP_ADDR_DHA(arp)], arp->hwalen);
     memcpy(&arp->addrs[ARP_ADDR_DPA(arp)], entry->praddr.addr,
            arp->pralen);
     ARP_TRACE("Filled in addrs");
@@ -14,6 +14,8 @@
 #include <stdio.h>
 #include <udp.h>
 
+short emudrop = 0;              /* Percent of packets to drop */
+
 /**
  * Drop packets based on user settings
  * @param pkt pointer to the incoming packet
@@ -21,11 +23,8 @@
  */
 syscall emuDrop(struct packet *pkt)
 {
-    /* TODO: make this user specifiable */
-    short dropPercent = 0;
-
     /* drop packet when random value < percent to drop */
-    if ((rand() % 100) < dropPercent)
+    if ((rand() % 100) < emudrop)
     {
         RT_TRACE("Dropped by Emulator: %d\n");
         netFreebuf(pkt);
@@ -38,7 +38,7 @@ syscall icmpEchoReply(struct packet *pkt, struct netif *nif)
     memcpy(dst.addr, ip->src, dst.len);
 
     ICMP_TRACE("Sending Echo Reply");
-    ipv4Send(pkt, &nif->ip, &dst, IPv4_PROTO_ICMP);
+    ipv4Send(pkt, &nif->ip, &dst, IPv4_PROTO_ICMP, NULL);
 
     return OK;
 }
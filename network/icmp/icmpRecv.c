@@ -15,6 +15,7 @@
 #include <mailbox.h>
 #include <thread.h>
 #include <network.h>
+#include <route.h>
 #include <string.h>
 
 /**
@@ -27,6 +28,8 @@ syscall icmpRecv(struct packet *pkt)
     struct icmpPkt *icmp = NULL;
     struct icmpEcho *echo = NULL;
     struct icmpEchoQueue *eq = NULL;
+    struct ipv4Pkt *ip = NULL;
+    struct netaddr dst;
     int id = 0, i = 0;
     irqmask im;
 
@@ -84,6 +87,24 @@ syscall icmpRecv(struct packet *pkt)
         return OK;
 
     case ICMP_UNREACH:
+        /* Fragmentation needed quotes the header of the datagram that
+         * was too big, after the next hop MTU (RFC 1191) */
+        if ((ICMP_FOFF_DFSET == icmp->code)
+            && (pkt->len - (pkt->curr - pkt->linkhdr)
+                >= ICMP_HEADER_LEN + 4 + IPv4_HDR_LEN))
+        {
+            ip = (struct ipv4Pkt *)(icmp->data + 4);
+            dst.type = NETADDR_IPv4;
+            dst.len = IPv4_ADDR_LEN;
+            memcpy(dst.addr, ip->dst, IPv4_ADDR_LEN);
+            ICMP_TRACE("Fragmentation needed");
+            rtPmtuUpdate(&dst, net2hs(*((ushort *)(icmp->data + 2))),
+                         net2hs(ip->len));
+            break;
+        }
+        ICMP_TRACE("ICMP message type %d not handled", icmp->type);
+        break;
+
     case ICMP_SRCQNCH:
     case ICMP_REDIRECT:
     case ICMP_TIMEEXCD:
@@ -40,5 +40,5 @@ syscall icmpSend(struct packet *pkt, uchar type, uchar code,
     src.type = NULL;
 
     ICMP_TRACE("Sending ICMP packet type %d, code %d", type, code);
-    return ipv4Send(pkt, &src, dst, IPv4_PROTO_ICMP);
+    return ipv4Send(pkt, &src, dst, IPv4_PROTO_ICMP, NULL);
 }
@@ -0,0 +1,331 @@
+/**
+ * @file ipv4Reasm.c
+ * @provides ipv4ReasmInit, ipv4Reasm, ipv4ReasmExpire, ipv4ReasmTimer
+ *
+ * Fragments are copied straight into place in a reassembly buffer and
+ * the gaps still missing are tracked with hole descriptors (RFC 815).
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <bufpool.h>
+#include <clock.h>
+#include <icmp.h>
+#include <ipv4.h>
+#include <network.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread.h>
+
+/* Room ahead of the payload for the largest header, keeping the header
+ * word aligned */
+#define IPv4_REASM_ROOM     (2 + IPv4_MAX_HDRLEN)
+#define reasmdata(pkt)      ((pkt)->data + IPv4_REASM_ROOM)
+
+struct ipv4ReasmEnt ipv4reasmtab[IPv4_REASM_NBUF];
+int ipv4reasmpool;
+static semaphore reasmlock;
+
+uint ipv4reasmok = 0;
+uint ipv4reasmtimeout = 0;
+uint ipv4reasmoverflow = 0;
+
+/**
+ * Set up the reassembly table and buffer pool and start the timer that
+ * gives up on incomplete datagrams.
+ * @return OK if initialization is successful, otherwise SYSERR
+ */
+syscall ipv4ReasmInit(void)
+{
+    bzero(ipv4reasmtab, sizeof(ipv4reasmtab));
+
+    ipv4reasmpool = bfpalloc(sizeof(struct packet) + IPv4_REASM_ROOM
+                             + IPv4_REASM_MAXLEN + sizeof(struct ipv4Hole),
+                             IPv4_REASM_NBUF);
+    if (SYSERR == ipv4reasmpool)
+    {
+        return SYSERR;
+    }
+
+    reasmlock = semcreate(1);
+    if (SYSERR == (int)reasmlock)
+    {
+        return SYSERR;
+    }
+
+    ready(create((void *)ipv4ReasmTimer, IPv4_REASM_THR_STK,
+                 IPv4_REASM_THR_PRIO, "ipv4Reasm", 0), RESCHED_NO);
+
+    return OK;
+}
+
+/**
+ * Find the datagram a fragment belongs to, starting a new one if there
+ * is a free entry and buffer.  Caller holds reasmlock.
+ */
+static struct ipv4ReasmEnt *reasmfind(struct ipv4Pkt *ip)
+{
+    struct ipv4ReasmEnt *ent;
+    struct ipv4ReasmEnt *unused = NULL;
+    struct ipv4Hole *hole;
+    struct packet *pkt;
+    int i;
+
+    for (i = 0; i < IPv4_REASM_NBUF; i++)
+    {
+        ent = &ipv4reasmtab[i];
+        if (NULL == ent->pkt)
+        {
+            if (NULL == unused)
+            {
+                unused = ent;
+            }
+            continue;
+        }
+        if ((ent->id == ip->id) && (ent->proto == ip->proto)
+            && (0 == memcmp(ent->src, ip->src, IPv4_ADDR_LEN))
+            && (0 == memcmp(ent->dst, ip->dst, IPv4_ADDR_LEN)))
+        {
+            return ent;
+        }
+    }
+
+    /* Reassembled datagrams still being read hold buffers too */
+    if ((NULL == unused)
+        || (semcount(bfptab[ipv4reasmpool].freebuf) <= 0))
+    {
+        return NULL;
+    }
+    pkt = bufget(ipv4reasmpool);
+    if (SYSERR == (int)pkt)
+    {
+        return NULL;
+    }
+
+    ent = unused;
+    ent->pkt = pkt;
+    memcpy(ent->src, ip->src, IPv4_ADDR_LEN);
+    memcpy(ent->dst, ip->dst, IPv4_ADDR_LEN);
+    ent->id = ip->id;
+    ent->proto = ip->proto;
+    ent->hdrlen = 0;
+    ent->total = 0;
+    ent->expires = clktime + IPv4_REASM_TIMEOUT;
+
+    /* Everything is missing */
+    hole = (struct ipv4Hole *)reasmdata(pkt);
+    hole->first = 0;
+    hole->last = IPv4_REASM_INF;
+    hole->next = IPv4_REASM_NOHOLE;
+    ent->holes = 0;
+
+    return ent;
+}
+
+/**
+ * Write a hole descriptor and link it in where link points.
+ * @return link to the hole that follows the new one
+ */
+static ushort *holeput(uchar *data, ushort *link, uint first, uint last)
+{
+    struct ipv4Hole *hole;
+
+    hole = (struct ipv4Hole *)(data + first);
+    hole->first = first;
+    hole->last = last;
+    hole->next = *link;
+    *link = first;
+    return &hole->next;
+}
+
+/**
+ * Put the first fragment's header in front of the collected payload.
+ */
+static void reasmhdr(struct ipv4ReasmEnt *ent, struct packet *pkt)
+{
+    pkt->nethdr = reasmdata(pkt) - ent->hdrlen;
+    memcpy(pkt->nethdr, ent->hdr, ent->hdrlen);
+}
+
+/**
+ * Add an incoming fragment to the datagram it belongs to.  The fragment
+ * is always consumed.
+ * @param pkt fragment, with nethdr at its IPv4 header
+ * @return the whole datagram once its last missing piece arrives, with
+ *  nethdr at its header and no link header, otherwise NULL
+ */
+struct packet *ipv4Reasm(struct packet *pkt)
+{
+    struct ipv4ReasmEnt *ent;
+    struct ipv4Pkt *ip;
+    struct ipv4Hole *hole;
+    struct packet *whole;
+    ushort *link;
+    uchar *data;
+    uint ihl, len, first, last, hfirst, hlast, hnext;
+    bool more;
+
+    ip = (struct ipv4Pkt *)pkt->nethdr;
+    ihl = (ip->ver_ihl & IPv4_IHL) << 2;
+    len = net2hs(ip->len) - ihl;
+    first = (net2hs(ip->flags_froff) & IPv4_FROFF) << 3;
+    last = first + len - 1;
+    more = (net2hs(ip->flags_froff) & IPv4_FLAG_MF) ? TRUE : FALSE;
+
+    /* Only the last fragment may end part way through an 8 byte block */
+    if ((0 == len) || (more && (len & 0x7)))
+    {
+        IPv4_TRACE("Malformed fragment");
+        netFreebuf(pkt);
+        return NULL;
+    }
+    if (last >= IPv4_REASM_MAXLEN)
+    {
+        IPv4_TRACE("Fragment past largest reassembled datagram");
+        ipv4reasmoverflow++;
+        netFreebuf(pkt);
+        return NULL;
+    }
+
+    wait(reasmlock);
+    ent = reasmfind(ip);
+    if (NULL == ent)
+    {
+        IPv4_TRACE("No room to reassemble");
+        ipv4reasmoverflow++;
+        signal(reasmlock);
+        netFreebuf(pkt);
+        return NULL;
+    }
+
+    /* Fragments must agree on where the datagram ends */
+    if ((0 != ent->total)
+        && ((last >= ent->total) || (!more && (last + 1 != ent->total))))
+    {
+        IPv4_TRACE("Fragment disagrees on datagram length");
+        signal(reasmlock);
+        netFreebuf(pkt);
+        return NULL;
+    }
+
+    /* Replace each hole the fragment touches with what it leaves */
+    data = reasmdata(ent->pkt);
+    link = &ent->holes;
+    while (IPv4_REASM_NOHOLE != *link)
+    {
+        hole = (struct ipv4Hole *)(data + *link);
+        hfirst = hole->first;
+        hlast = hole->last;
+        hnext = hole->next;
+        if ((first > hlast) || (last < hfirst))
+        {
+            link = &hole->next;
+            continue;
+        }
+        *link = hnext;
+        if (first > hfirst)
+        {
+            link = holeput(data, link, hfirst, first - 1);
+        }
+        if (more && (last < hlast))
+        {
+            link = holeput(data, link, last + 1, hlast);
+        }
+    }
+
+    /* Descriptors inside the fragment are no longer needed */
+    memcpy(data + first, ((uchar *)ip) + ihl, len);
+    if (!more)
+    {
+        ent->total = last + 1;
+    }
+    if (0 == first)
+    {
+        ent->hdrlen = ihl;
+        memcpy(ent->hdr, ip, ihl);
+    }
+    ent->pkt->nif = pkt->nif;
+    netFreebuf(pkt);
+
+    if (IPv4_REASM_NOHOLE != ent->holes)
+    {
+        signal(reasmlock);
+        return NULL;
+    }
+
+    /* Complete, so hand up a datagram that was never fragmented */
+    whole = ent->pkt;
+    ent->pkt = NULL;
+    reasmhdr(ent, whole);
+    ip = (struct ipv4Pkt *)whole->nethdr;
+    ip->len = hs2net(ent->hdrlen + ent->total);
+    ip->flags_froff = 0;
+    ip->chksum = 0;
+    ip->chksum = netChksum((uchar *)ip, ent->hdrlen);
+    whole->linkhdr = whole->nethdr;
+    whole->curr = whole->nethdr;
+    whole->len = ent->hdrlen + ent->total;
+    ipv4reasmok++;
+    signal(reasmlock);
+
+    IPv4_TRACE("Reassembled %d bytes", whole->len);
+    return whole;
+}
+
+/**
+ * Give up on datagrams whose fragments have not all arrived in time.
+ * If the first fragment did arrive, its source is sent an ICMP time
+ * exceeded (RFC 792).
+ */
+void ipv4ReasmExpire(void)
+{
+    struct ipv4ReasmEnt *ent;
+    struct packet *expired[IPv4_REASM_NBUF];
+    int i, n;
+
+    n = 0;
+    wait(reasmlock);
+    for (i = 0; i < IPv4_REASM_NBUF; i++)
+    {
+        ent = &ipv4reasmtab[i];
+        if ((NULL == ent->pkt) || (clktime < ent->expires))
+        {
+            continue;
+        }
+        IPv4_TRACE("Reassembly timed out");
+        ipv4reasmtimeout++;
+        if (0 != ent->hdrlen)
+        {
+            reasmhdr(ent, ent->pkt);
+            expired[n++] = ent->pkt;
+        }
+        else
+        {
+            netFreebuf(ent->pkt);
+        }
+        ent->pkt = NULL;
+    }
+    signal(reasmlock);
+
+    for (i = 0; i < n; i++)
+    {
+        icmpTimeExceeded(expired[i], ICMP_FRA_EXC);
+        netFreebuf(expired[i]);
+    }
+}
+
+/**
+ * Thread that expires incomplete datagrams once a second.
+ */
+thread ipv4ReasmTimer(void)
+{
+    while (TRUE)
+    {
+        sleep(1000);
+        ipv4ReasmExpire();
+    }
+
+    return OK;
+}
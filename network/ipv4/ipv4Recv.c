@@ -68,16 +68,17 @@ syscall ipv4Recv(struct packet *pkt)
 #endif
     }
 
-    /* Check if packet is fragmented */
+    /* Hold fragments until the whole datagram has arrived */
     if ((IPv4_FLAG_MF & net2hs(ip->flags_froff))
         || (0 != (net2hs(ip->flags_froff) & IPv4_FROFF)))
     {
-        // TODO: Handle fragmenting of packet
-        // TODO: Should send icmp time exceeded
-        // return ipRecvSendFrag(pkt, &dst);
         IPv4_TRACE("Packet fragmented");
-        netFreebuf(pkt);
-        return SYSERR;
+        pkt = ipv4Reasm(pkt);
+        if (NULL == pkt)
+        {
+            return OK;
+        }
+        ip = (struct ipv4Pkt *)pkt->nethdr;
     }
 
     /* The Ethernet driver pads packets less than 60 bytes in length.
@@ -11,6 +11,10 @@
 #include <network.h>
 #include <string.h>
 #include <route.h>
+#include <interrupt.h>
+
+/* Identification for datagrams that have to be fragmented */
+static ushort ipv4id = 0;
 
 /**
  * Send an outgoing IPv4 packet.
@@ -18,16 +22,18 @@
  * @param src source IP address
  * @param dst destination IP address
  * @param proto the protocol of the ip pkt
+ * @param cache destination cache kept by the caller, NULL if none
  * @return OK if packet was sent, TIMEOUT if ARP request timed out,
  * IPv4_NO_INTERFACE if interface does not exist, IPv4_NO_HOP if next hop
  * is unknown, SYSERR otherwise.
  */
 syscall ipv4Send(struct packet *pkt, struct netaddr *src,
-                 struct netaddr *dst, uchar proto)
+                 struct netaddr *dst, uchar proto, struct rtCache *cache)
 {
-    struct rtEntry *rtptr;
+    struct rtCache local;
     struct ipv4Pkt *ip;
-    struct netaddr *nxthop;
+    ushort mtu;
+    irqmask im;
 
     /* Error check pointers */
     if ((NULL == pkt) || (NULL == dst))
@@ -41,26 +47,19 @@ syscall ipv4Send(struct packet *pkt, struct netaddr *src,
         return SYSERR;
     }
 
-    /* Lookup destination in route table */
-    rtptr = rtLookup(dst);
-    if (NULL == rtptr)
+    /* Find next hop, from the caller's destination cache if current */
+    if (NULL == cache)
     {
-        IPv4_TRACE("No route");
-        return SYSERR;
+        local.gen = 0;
+        local.pmtud = FALSE;
+        cache = &local;
     }
-
-    /* Packet has next hop in route table */
-    pkt->nif = rtptr->nif;
-    if (NULL == rtptr->gateway.type)
+    if (SYSERR == rtCacheLookup(cache, dst))
     {
-        IPv4_TRACE("Next hop is dst");
-        nxthop = dst;
-    }
-    else
-    {
-        IPv4_TRACE("Next hop is gateway");
-        nxthop = &rtptr->gateway;
+        IPv4_TRACE("No route");
+        return SYSERR;
     }
+    pkt->nif = cache->nif;
 
     /* Set up outgoing packet header */
     pkt->len += IPv4_HDR_LEN;
@@ -75,6 +74,22 @@ syscall ipv4Send(struct packet *pkt, struct netaddr *src,
     ip->len = hs2net(pkt->len);
     ip->id = 0;
     ip->flags_froff = 0;
+    if (cache->pmtud)
+    {
+        /* Routers report where it is too big instead of fragmenting */
+        ip->flags_froff = hs2net(IPv4_FLAG_DF);
+        mtu = pkt->nif->mtu;
+    }
+    else
+    {
+        mtu = cache->mtu;
+    }
+    if (pkt->len > mtu)
+    {
+        im = disable();
+        ip->id = hs2net(++ipv4id);
+        restore(im);
+    }
     ip->ttl = IPv4_TTL;
     ip->proto = proto;
     if (NULL == src->type)
@@ -95,5 +110,9 @@ syscall ipv4Send(struct packet *pkt, struct netaddr *src,
     IPv4_TRACE("Setup IPv4 header");
 
     /* Fragment and send packet */
-    return ipv4SendFrag(pkt, nxthop);
+    if (NULL == cache->hwaddr.type)
+    {
+        return ipv4SendFrag(pkt, &cache->nxthop, NULL, mtu);
+    }
+    return ipv4SendFrag(pkt, &cache->nxthop, &cache->hwaddr, mtu);
 }
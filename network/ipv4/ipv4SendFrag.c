@@ -17,9 +17,13 @@
 /**
  * Fragments packet into maximum transmission unit sized chunks.
  * @param pkt the packet to fragment
+ * @param nxthop protocol address of the next hop
+ * @param hwaddr hardware address of the next hop, NULL if should lookup
+ * @param mtu largest datagram to send, at most the interface MTU
  * @return OK
  */
-syscall ipv4SendFrag(struct packet *pkt, struct netaddr *nxthop)
+syscall ipv4SendFrag(struct packet *pkt, struct netaddr *nxthop,
+                     struct netaddr *hwaddr, uint mtu)
 {
     uint ihl;
     uchar *data;
@@ -45,7 +49,7 @@ syscall ipv4SendFrag(struct packet *pkt, struct netaddr *nxthop)
     // Setup incoming packet structures
     ip = (struct ipv4Pkt *)pkt->curr;
 
-    if (net2hs(ip->len) <= pkt->nif->mtu)
+    if (net2hs(ip->len) <= mtu)
     {
         IPv4_TRACE("NetSend");
 
@@ -55,7 +59,7 @@ syscall ipv4SendFrag(struct packet *pkt, struct netaddr *nxthop)
             return netSend(pkt, &NETADDR_GLOBAL_ETH_BRC,
                            nxthop, ETHER_TYPE_IPv4);
         }
-        return netSend(pkt, NULL, nxthop, ETHER_TYPE_IPv4);
+        return netSend(pkt, hwaddr, nxthop, ETHER_TYPE_IPv4);
     }
 
     // Verify header does not have DF
@@ -75,19 +79,19 @@ syscall ipv4SendFrag(struct packet *pkt, struct netaddr *nxthop)
 
     // Length of data in this packet will be MTU - header length,
     //  rounded down to nearest multiple of 8 bytes.
-    dLen = (pkt->nif->mtu - ihl) & ~0x7;
+    dLen = (mtu - ihl) & ~0x7;
 
     pkt->len = ihl + dLen;
     ip->len = hs2net(pkt->len);
 
     // Set more fragments flag
-    ip->flags_froff = IPv4_FLAG_MF & froff;
+    ip->flags_froff = IPv4_FLAG_MF | froff;
     ip->flags_froff = hs2net(ip->flags_froff);
 
     ip->chksum = 0;
     ip->chksum = netChksum((uchar *)ip, ihl);
 
-    netSend(pkt, NULL, nxthop, ETHER_TYPE_IPv4);
+    netSend(pkt, hwaddr, nxthop, ETHER_TYPE_IPv4);
     dRem -= dLen;
     data += dLen;
     froff += (dLen / 8);
@@ -102,18 +106,20 @@ syscall ipv4SendFrag(struct packet *pkt, struct netaddr *nxthop)
     }
 
     // Set up outgoing packet pointers and variables
-    outpkt->curr -= pkt->nif->mtu;
+    outpkt->curr -= mtu;
     outip = (struct ipv4Pkt *)outpkt->curr;
     outpkt->nif = pkt->nif;
 
+    // Options are not copied into later fragments
     memcpy(outip, ip, IPv4_HDR_LEN);
+    outip->ver_ihl = (IPv4_VERSION << 4) | IPv4_MIN_IHL;
 
     // While packet must be fragmented
     while (dRem > 0)
     {
-        if (((dRem + 7) & ~0x7) > pkt->nif->mtu + IPv4_HDR_LEN)
+        if (dRem > mtu - IPv4_HDR_LEN)
         {
-            dLen = (pkt->nif->mtu - IPv4_HDR_LEN) & ~0x7;
+            dLen = (mtu - IPv4_HDR_LEN) & ~0x7;
         }
         else
         {
@@ -125,11 +131,11 @@ syscall ipv4SendFrag(struct packet *pkt, struct netaddr *nxthop)
         // Set more fragments flag
         if (dLen == dRem)
         {
-            outip->flags_froff = lastFlag & froff;
+            outip->flags_froff = lastFlag | froff;
         }
         else
         {
-            outip->flags_froff = IPv4_FLAG_MF & froff;
+            outip->flags_froff = IPv4_FLAG_MF | froff;
         }
         outip->flags_froff = hs2net(outip->flags_froff);
 
@@ -138,11 +144,12 @@ syscall ipv4SendFrag(struct packet *pkt, struct netaddr *nxthop)
         outip->chksum = 0;
         outip->chksum = netChksum((uchar *)outip, IPv4_HDR_LEN);
 
-        // Update outgoing packet length
+        // Update outgoing packet, which netSend moved to the link header
+        outpkt->curr = (uchar *)outip;
         outpkt->len = net2hs(outip->len);
 
         // Send fragment
-        netSend(outpkt, NULL, nxthop, ETHER_TYPE_IPv4);
+        netSend(outpkt, hwaddr, nxthop, ETHER_TYPE_IPv4);
 
         dRem -= dLen;
         data += dLen;
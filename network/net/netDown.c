@@ -71,6 +71,30 @@ syscall netDown(int descrp)
     }
 
 
+    /* Stop the device from receiving into the packet pool */
+    if (netptr->rxhandoff)
+    {
+        control(netptr->dev, NET_SET_RXPOOL, SYSERR, NULL);
+    }
+
+    /* Stop the transmit thread and drop frames still waiting for it */
+    if (!isbadtid(netptr->xmitthr))
+    {
+        kill(netptr->xmitthr);
+    }
+    if (netptr->txbatch)
+    {
+        control(netptr->dev, NET_SET_TXWAKE, SYSERR, NULL);
+    }
+    while (netptr->txqcount > 0)
+    {
+        netFreebuf(netptr->txq[netptr->txqstart]);
+        netptr->txqstart = (netptr->txqstart + 1) % NET_TXQ_DEPTH;
+        netptr->txqcount--;
+    }
+    semfree(netptr->txlock);
+    semfree(netptr->txwake);
+
     /* Clear all entries in the route table for this network interface */
     if (SYSERR == rtClear(netptr))
     {
@@ -78,7 +102,7 @@ syscall netDown(int descrp)
     }
 
     /* Clear and make the network interface free */
-    bzero(&netiftab[i], sizeof(struct netif));
+    bzero(netptr, sizeof(struct netif));
     netptr->state = NET_FREE;
 
     restore(im);
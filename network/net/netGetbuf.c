@@ -10,9 +10,12 @@
 #include <bufpool.h>
 #include <network.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
- * Provides a buffer for storing a packet.
+ * Provides a buffer for storing a packet.  Only the packet header is
+ * initialized; the data area holds whatever the previous user left, so
+ * every protocol layer must write each byte of its header and payload.
  * @return pointer to a packet buffer, SYSERR if an error occured
  */
 struct packet *netGetbuf(void)
@@ -26,11 +29,16 @@ struct packet *netGetbuf(void)
         return (struct packet *)SYSERR;
     }
 
-    bzero(pkt, sizeof(struct packet) + NET_MAX_PKTLEN);
+#ifdef NET_POISON
+    /* Fill data with a pattern to expose readers of unwritten bytes */
+    memset(pkt->data, NET_POISON, NET_MAX_PKTLEN);
+#endif
 
     /* Initialize packet buffer */
     pkt->nif = NULL;
     pkt->len = 0;
+    pkt->linkhdr = NULL;
+    pkt->nethdr = NULL;
     /* Initialize curr to point to end of buffer */
     pkt->curr = pkt->data + NET_MAX_PKTLEN;
 
@@ -17,98 +17,149 @@
 #include <string.h>
 #include <thread.h>
 
+static void netRecvPkt(struct netif *, struct packet *);
+
 /**
- * Receive thread to handle one incoming packet at a time
+ * Receive thread to handle incoming packets.  Devices that support
+ * receive handoff are polled for a batch of up to NET_RECV_BUDGET packets
+ * they filled in place; others are read() into a freshly allocated packet
+ * one at a time.
  * @param network interface device to open netRecv on
  */
 thread netRecv(struct netif *netptr)
 {
     uint maxlen;                            /**< maximum packet length */
     maxlen = netptr->linkhdrlen + netptr->mtu;
+    struct packet *pkts[NET_RECV_BUDGET];
     struct packet *pkt;
-    struct etherPkt *ether;
-    struct netaddr dst;
+    int npkts, i;
 
     enable();
 
     /* Processing incoming packets */
     while (TRUE)
     {
-        /* Get a buffer for incoming packet */
-        pkt = netGetbuf();
-        if (SYSERR == (int)pkt)
+        if (netptr->rxhandoff)
         {
-            continue;
+            /* Take ownership of the packets the driver received in
+             * place.  This thread will wait until the driver has at
+             * least one frame; the driver keeps its receive interrupt
+             * masked until a poll leaves its ring empty. */
+            npkts = control(netptr->dev, NET_RECV_POLL,
+                            (long)pkts, NET_RECV_BUDGET);
+            if (SYSERR == npkts || 0 == npkts)
+            {
+                continue;
+            }
+            netptr->npoll++;
+            if (NET_RECV_BUDGET == npkts)
+            {
+                netptr->nbudget++;
+            }
+            for (i = 0; i < npkts; i++)
+            {
+                pkts[i]->nethdr = NULL;
+                netRecvPkt(netptr, pkts[i]);
+            }
         }
-
-        /* Read in packet from the underlying network device. 
-         * This thread will wait until there is a packet to read.
-         * It is the responsibility of the network driver to tell this
-         * thread to run, signifying that there is a packet to read
-         */
-        pkt->len = read(netptr->dev, pkt->data, maxlen);
-        if (0 == pkt->len || SYSERR == (short)pkt->len)
+        else
         {
-            continue;
+            /* Get a buffer for incoming packet */
+            pkt = netGetbuf();
+            if (SYSERR == (int)pkt)
+            {
+                continue;
+            }
+
+            /* Read in packet from the underlying network device. 
+             * This thread will wait until there is a packet to read.
+             * It is the responsibility of the network driver to tell this
+             * thread to run, signifying that there is a packet to read
+             */
+            pkt->len = read(netptr->dev, pkt->data, maxlen);
+            netRecvPkt(netptr, pkt);
         }
+    }
 
-        pkt->curr = pkt->data;
-        pkt->nif = netptr;
-        netptr->nin++;
+    return SYSERR;
 
-        /* Point to packet location in the incoming packet buffer */
-        pkt->linkhdr = pkt->curr;
-        ether = (struct etherPkt *)pkt->curr;
+}
 
-        /* Snoop if we are in promiscuous mode */
-        if (netptr->capture != NULL)
-        {
-            snoopCapture(netptr->capture, pkt);
-        }
+/**
+ * Demultiplex one received frame to the network layer.  The packet is
+ * always consumed, either by the protocol handler or by being freed.
+ * @param netptr interface the frame arrived on
+ * @param pkt received frame, with len set and data holding the frame
+ */
+static void netRecvPkt(struct netif *netptr, struct packet *pkt)
+{
+    struct etherPkt *ether;
+    struct netaddr dst;
+
+    if (0 == pkt->len || SYSERR == (short)pkt->len)
+    {
+        netFreebuf(pkt);
+        return;
+    }
+
+    pkt->curr = pkt->data;
+    pkt->nif = netptr;
+    netptr->nin++;
 
-        /* Obtain destination hardware address */
-        dst.type = NETADDR_ETHERNET;
-        dst.len = ETH_ADDR_LEN;
-        memcpy(dst.addr, ether->dst, ETH_ADDR_LEN);
+    /* Point to packet location in the incoming packet buffer */
+    pkt->linkhdr = pkt->curr;
+    ether = (struct etherPkt *)pkt->curr;
+
+    /* Snoop if we are in promiscuous mode */
+    if (netptr->capture != NULL)
+    {
+        snoopCapture(netptr->capture, pkt);
+    }
+
+    /* Obtain destination hardware address */
+    dst.type = NETADDR_ETHERNET;
+    dst.len = ETH_ADDR_LEN;
+    memcpy(dst.addr, ether->dst, ETH_ADDR_LEN);
 
 #ifdef TRACE_NET
-        char str[20];
-        NET_TRACE("Read packet len %d", pkt->len);
-        netaddrsprintf(str, &dst);
-        NET_TRACE("\tPacket dst %s", str);
-        NET_TRACE("\tPacket proto 0x%04X", net2hs(ether->type));
+    char str[20];
+    NET_TRACE("Read packet len %d", pkt->len);
+    netaddrsprintf(str, &dst);
+    NET_TRACE("\tPacket dst %s", str);
+    NET_TRACE("\tPacket proto 0x%04X", net2hs(ether->type));
 #endif
 
-        /* Verify that packet belongs to our mac or is broadcast mac */
-        if ((netaddrequal(&dst, &netptr->hwaddr))
-            || (netaddrequal(&dst, &netptr->hwbrc)))
-        {
-            /* Move current pointer to network level header */
-            pkt->curr = pkt->data + netptr->linkhdrlen;
-
-            /* Call necessary routine based on packet type */
-            switch (net2hs(ether->type))
-            {
-                /* IP Packet */
-            case ETHER_TYPE_IPv4:
-                ipv4Recv(pkt);
-                netptr->nproc++;
-                break;
-
-                /* ARP Packet */
-            case ETHER_TYPE_ARP:
-                arpRecv(pkt);
-                netptr->nproc++;
-                break;
-
-                /* Unknown ether packet type */
-            default:
-                break;
-            }
+    /* Verify that packet belongs to our mac or is broadcast mac */
+    if ((netaddrequal(&dst, &netptr->hwaddr))
+        || (netaddrequal(&dst, &netptr->hwbrc)))
+    {
+        /* Move current pointer to network level header */
+        pkt->curr = pkt->data + netptr->linkhdrlen;
 
+        /* Call necessary routine based on packet type */
+        switch (net2hs(ether->type))
+        {
+            /* IP Packet */
+        case ETHER_TYPE_IPv4:
+            ipv4Recv(pkt);
+            netptr->nproc++;
+            break;
+
+            /* ARP Packet */
+        case ETHER_TYPE_ARP:
+            arpRecv(pkt);
+            netptr->nproc++;
+            break;
+
+            /* Unknown ether packet type */
+        default:
+            netFreebuf(pkt);
+            break;
         }
-    }
-
-    return SYSERR;
 
+    }
+    else
+    {
+        netFreebuf(pkt);
+    }
 }
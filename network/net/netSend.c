@@ -1,6 +1,6 @@
 /**
  * file netSend.c
- * @provides netSend
+ * @provides netSend, netSendFrame
  * 
  * $Id: netSend.c 2024 2009-08-13 18:50:40Z brylow $
  */
@@ -16,13 +16,14 @@
 
 /**
  * Appends the Link-Level header to a packet and writes to the 
- * underlying interface.
+ * underlying interface.  If the destination must be looked up and is
+ * not resolved yet, a copy of the packet waits in the ARP table and this
+ * returns without blocking.
  * @param pkt packet to send
  * @param hwaddr hardware address of the destination, NULL if should lookup
  * @param praddr protocol address of the destination, NULL if hwaddr is known
  * @param type type of the packet to put in link level header
- * @return OK if packet was sent, TIMEOUT if ARP request timed out,
- * 	otherwise SYSERR
+ * @return OK if packet was sent or is waiting on ARP, otherwise SYSERR
  */
 syscall netSend(struct packet *pkt, struct netaddr *hwaddr,
                 struct netaddr *praddr, ushort type)
@@ -64,7 +65,12 @@ syscall netSend(struct packet *pkt, struct netaddr *hwaddr,
     {
         NET_TRACE("Hardware address lookup required");
         hwaddr = &addr;
-        result = arpLookup(netptr, praddr, hwaddr);
+        result = arpResolve(netptr, praddr, hwaddr, pkt);
+        if (ARP_QUEUED == result)
+        {
+            NET_TRACE("Held for ARP resolution");
+            return OK;
+        }
         if (result != OK)
         {
             return result;
@@ -74,8 +80,34 @@ syscall netSend(struct packet *pkt, struct netaddr *hwaddr,
     /* Copy destination hardware address into link-level header */
     memcpy(ether->dst, hwaddr->addr, hwaddr->len);
 
-    /* Write the packet to the underlying device */
-    if (SYSERR == write(netptr->dev, pkt->curr, pkt->len))
+    return netSendFrame(pkt);
+}
+
+/**
+ * Writes a packet that already carries its complete Link-Level header to
+ * the underlying interface.  The caller keeps ownership of pkt.
+ * @param pkt packet to send, with curr at the Link-Level header
+ * @return OK if packet was sent, otherwise SYSERR
+ */
+syscall netSendFrame(struct packet *pkt)
+{
+    struct netif *netptr = pkt->nif;
+
+    if ((NULL == netptr) || (netptr->state != NET_ALLOC))
+    {
+        return SYSERR;
+    }
+
+    /* Hand the packet to the underlying device, queueing behind a full
+     * transmit ring if the device takes batched frames */
+    if (netptr->txbatch)
+    {
+        if (SYSERR == netTxQueue(netptr, pkt))
+        {
+            return SYSERR;
+        }
+    }
+    else if (SYSERR == write(netptr->dev, pkt->curr, pkt->len))
     {
         return SYSERR;
     }
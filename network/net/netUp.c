@@ -134,6 +134,21 @@ syscall netUp(int descrp, struct netaddr *ip, struct netaddr *mask,
 #endif
 
 
+    /* Offer the packet pool to the device so it can receive in place */
+    netptr->rxpool = netpool;
+    netptr->rxhandoff =
+        (OK == control(descrp, NET_SET_RXPOOL, netptr->rxpool, NULL));
+
+    /* Give the device a way to wake the transmit thread; devices that
+     * take it accept batched frames and senders may queue behind them */
+    netptr->txlock = semcreate(1);
+    netptr->txwake = semcreate(0);
+    netptr->txqstart = 0;
+    netptr->txqcount = 0;
+    netptr->xmitthr = BADTID;
+    netptr->txbatch =
+        (OK == control(descrp, NET_SET_TXWAKE, netptr->txwake, NULL));
+
     /* TODO: Get hostname from nvram */
 
     /* Add subnet address and gateway to the route table */
@@ -153,6 +168,13 @@ syscall netUp(int descrp, struct netaddr *ip, struct netaddr *mask,
         netptr->recvthr[i] = tid;
         ready(tid, RESCHED_NO);
     }
+    if (netptr->txbatch)
+    {
+        sprintf(thrname, "%sxmit", devptr->name);
+        netptr->xmitthr = create((void *)netXmit, NET_XMIT_STK,
+                                 NET_XMIT_PRIO, thrname, 1, netptr);
+        ready(netptr->xmitthr, RESCHED_NO);
+    }
     restore(im);
 
     return OK;
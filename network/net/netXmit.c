@@ -0,0 +1,125 @@
+/**
+ * @file     netXmit.c
+ * @provides netTxQueue, netTxFlush, netXmit
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <bufpool.h>
+#include <device.h>
+#include <network.h>
+#include <string.h>
+#include <thread.h>
+
+/**
+ * Hand a framed packet to a device that takes batched frames.  If the
+ * transmit ring has room (and nothing is queued ahead of it) the frame
+ * goes straight onto the ring; otherwise a copy waits on the interface
+ * transmit queue for netXmit.  The caller keeps ownership of pkt.
+ * @param netptr interface to send on
+ * @param pkt packet with curr at the link header and len set
+ * @return OK if the frame was sent or queued, SYSERR if it was dropped
+ */
+syscall netTxQueue(struct netif *netptr, struct packet *pkt)
+{
+    struct packet *copy;
+    int index;
+
+    wait(netptr->txlock);
+
+    /* Nothing ahead of this frame, so offer it to the device directly */
+    if ((0 == netptr->txqcount)
+        && (1 == control(netptr->dev, NET_SEND_BATCH, (long)&pkt, 1)))
+    {
+        netptr->nout++;
+        signal(netptr->txlock);
+        return OK;
+    }
+
+    /* Ring is full; queue a copy, without waiting for a free buffer */
+    if ((netptr->txqcount >= NET_TXQ_DEPTH)
+        || (semcount(bfptab[netpool].freebuf) <= 0))
+    {
+        netptr->ntxdrop++;
+        signal(netptr->txlock);
+        return SYSERR;
+    }
+    copy = netGetbuf();
+    if (SYSERR == (int)copy)
+    {
+        netptr->ntxdrop++;
+        signal(netptr->txlock);
+        return SYSERR;
+    }
+    copy->nif = netptr;
+    copy->len = pkt->len;
+    copy->curr = copy->data;
+    memcpy(copy->curr, pkt->curr, pkt->len);
+
+    index = (netptr->txqstart + netptr->txqcount) % NET_TXQ_DEPTH;
+    netptr->txq[index] = copy;
+    netptr->txqcount++;
+    netptr->ntxqueued++;
+
+    signal(netptr->txlock);
+    return OK;
+}
+
+/**
+ * Submit as much of the interface transmit queue as the device ring will
+ * take, in one batch.  Frames the device consumed are freed.
+ * @param netptr interface to flush
+ */
+void netTxFlush(struct netif *netptr)
+{
+    struct packet *batch[NET_TXQ_DEPTH];
+    int i, n, sent;
+
+    wait(netptr->txlock);
+
+    n = netptr->txqcount;
+    for (i = 0; i < n; i++)
+    {
+        batch[i] = netptr->txq[(netptr->txqstart + i) % NET_TXQ_DEPTH];
+    }
+
+    sent = 0;
+    if (n > 0)
+    {
+        sent = control(netptr->dev, NET_SEND_BATCH, (long)batch, n);
+    }
+    for (i = 0; i < sent; i++)
+    {
+        netptr->txq[netptr->txqstart] = NULL;
+        netptr->txqstart = (netptr->txqstart + 1) % NET_TXQ_DEPTH;
+        netptr->txqcount--;
+        netFreebuf(batch[i]);
+    }
+    if (sent > 0)
+    {
+        netptr->nout += sent;
+    }
+
+    signal(netptr->txlock);
+}
+
+/**
+ * Transmit thread for an interface.  Sleeps until the device reports
+ * ring space (or a sender has queued behind a full ring) and flushes the
+ * interface transmit queue.
+ * @param netptr interface to serve
+ */
+thread netXmit(struct netif *netptr)
+{
+    enable();
+
+    while (TRUE)
+    {
+        wait(netptr->txwake);
+        netTxFlush(netptr);
+    }
+
+    return SYSERR;
+}
@@ -10,16 +10,26 @@
 #include <network.h>
 #include <route.h>
 
+/**
+ * Adds a route to the route table.  The mask is taken to be contiguous.
+ * @param dst destination network
+ * @param gate gateway, NULL if destination is directly attached
+ * @param mask destination network mask
+ * @param nif network interface for route
+ * @return OK if added successfully, otherwise SYSERR
+ */
 syscall rtAdd(struct netaddr *dst, struct netaddr *gate,
               struct netaddr *mask, struct netif *nif)
 {
     struct rtEntry *rtptr;
+    struct rtEntry **link;
     uchar octet;
     ushort length;
     int i;
 
     /* Error check pointers */
-    if ((NULL == dst) || (NULL == mask) || (NULL == nif))
+    if ((NULL == dst) || (NULL == mask) || (NULL == nif)
+        || (NETADDR_IPv4 != dst->type))
     {
         return SYSERR;
     }
@@ -33,9 +43,11 @@ syscall rtAdd(struct netaddr *dst, struct netaddr *gate,
     RT_TRACE("nif = %d", nif - netiftab);
 
     /* Allocate an entry in the route table */
+    wait(rtlock);
     rtptr = rtAlloc();
     if ((SYSERR == (int)rtptr) || (NULL == rtptr))
     {
+        signal(rtlock);
         return SYSERR;
     }
 
@@ -70,6 +82,21 @@ syscall rtAdd(struct netaddr *dst, struct netaddr *gate,
     }
     rtptr->masklen = length;
 
+    /* Append to the route list and index in the trie */
+    for (link = &rtlist; NULL != *link; link = &(*link)->next)
+    {
+        ;
+    }
+    *link = rtptr;
     rtptr->state = RT_USED;
+    if (SYSERR == rtTrieInsert(&rttrie, rtptr))
+    {
+        rtFree(rtptr);
+        signal(rtlock);
+        return SYSERR;
+    }
+
+    rtCacheFlush();
+    signal(rtlock);
     return OK;
 }
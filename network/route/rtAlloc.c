@@ -1,39 +1,91 @@
 /**
  * @file rtAlloc.c
- * @provides rtAlloc
+ * @provides rtAlloc, rtFree
  *
  * $Id: rtAlloc.c 2118 2009-11-05 05:22:51Z mschul $
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
-#include <interrupt.h>
+#include <memory.h>
+#include <network.h>
 #include <route.h>
+#include <stdlib.h>
 
-/* Allocates an entry from the route table.
- * @return entry in route table, NULL if all used, SYSERR if error occurs
+/* Entries returned by rtFree, for reuse */
+static struct rtEntry *rtfree = NULL;
+
+/**
+ * Allocates an entry for the route table, reusing one rtFree removed if
+ * there is one, otherwise taking it from memory.  Entries are never
+ * returned to memory, so a pointer a lookup holds always points at a
+ * route entry.  An entry removed while a lookup holds it may be cleared
+ * and reused for another route at once, so the lookup may then see it
+ * pending or describing a different route.
+ * @return entry for route table, NULL if out of memory
+ * @pre-condition rtlock is held
  */
 struct rtEntry *rtAlloc(void)
 {
-    int i;
-    irqmask im;
+    struct rtEntry *rtptr;
 
     RT_TRACE("Allocating route entry");
 
-    im = disable();
-    for (i = 0; i < RT_NENTRY; i++)
+    rtptr = rtfree;
+    if (NULL != rtptr)
+    {
+        rtfree = rtptr->next;
+    }
+    else
+    {
+        rtptr = memget(sizeof(struct rtEntry));
+        if (SYSERR == (int)rtptr)
+        {
+            RT_TRACE("No memory for entry");
+            return NULL;
+        }
+    }
+
+    bzero(rtptr, sizeof(struct rtEntry));
+    rtptr->state = RT_PEND;
+    return rtptr;
+}
+
+/**
+ * Removes an entry from the route table and keeps it for reuse.  If
+ * another route has the same prefix it takes the entry's place.
+ * @param rtptr entry to remove
+ * @pre-condition rtlock is held
+ */
+void rtFree(struct rtEntry *rtptr)
+{
+    struct rtEntry **link;
+    struct rtEntry *repl;
+
+    /* Unlink from the route list */
+    for (link = &rtlist; NULL != *link; link = &(*link)->next)
+    {
+        if (*link == rtptr)
+        {
+            *link = rtptr->next;
+            break;
+        }
+    }
+
+    /* Oldest remaining route for the same prefix */
+    for (repl = rtlist; NULL != repl; repl = repl->next)
     {
-        /* If entry is free, return entry */
-        if (RT_FREE == rttab[i].state)
+        if ((repl->masklen == rtptr->masklen)
+            && netaddrequal(&repl->dst, &rtptr->dst))
         {
-            rttab[i].state = RT_PEND;
-            RT_TRACE("Free entry %d", i);
-            restore(im);
-            return &rttab[i];
+            break;
         }
     }
 
-    restore(im);
-    RT_TRACE("No free entry");
-    return NULL;
+    rtTrieRemove(&rttrie, rtptr, repl);
+    rtCacheFlush();
+    rtptr->state = RT_FREE;
+    rtptr->nif = NULL;
+    rtptr->next = rtfree;
+    rtfree = rtptr;
 }
@@ -0,0 +1,108 @@
+/**
+ * @file rtCache.c
+ * @provides rtCacheFlush, rtCacheLookup
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <arp.h>
+#include <clock.h>
+#include <interrupt.h>
+#include <network.h>
+#include <route.h>
+
+volatile uint rtcachegen = 1;
+
+/**
+ * Mark every destination cache stale.  Called whenever a route is added
+ * or removed, an ARP table entry changes or goes away, or a path MTU is
+ * lowered.
+ */
+void rtCacheFlush(void)
+{
+    irqmask im;
+
+    im = disable();
+    rtcachegen++;
+    if (0 == rtcachegen)
+    {
+        rtcachegen = 1;
+    }
+    restore(im);
+}
+
+/**
+ * Bring a destination cache up to date.  A current cache is used as it
+ * is; otherwise the route and path MTU are looked up again.  If the
+ * hardware address of the next hop is not known it is taken from the ARP
+ * table when resolved there, and otherwise left for netSend to resolve.
+ * @param cache destination cache
+ * @param dst destination IP address
+ * @return OK if cache holds a route to dst, SYSERR if there is no route
+ */
+syscall rtCacheLookup(struct rtCache *cache, struct netaddr *dst)
+{
+    struct rtEntry *rtptr;
+    struct arpEntry *entry;
+    irqmask im;
+
+    if ((NULL == cache) || (NULL == dst))
+    {
+        return SYSERR;
+    }
+
+    /* Route part */
+    if ((cache->gen != rtcachegen) || !netaddrequal(&cache->dst, dst))
+    {
+        cache->gen = rtcachegen;
+        rtptr = rtLookup(dst);
+        if (NULL == rtptr)
+        {
+            RT_TRACE("No route");
+            cache->gen = 0;
+            return SYSERR;
+        }
+        netaddrcpy(&cache->dst, dst);
+        cache->nif = rtptr->nif;
+        if (NULL == rtptr->gateway.type)
+        {
+            netaddrcpy(&cache->nxthop, dst);
+        }
+        else
+        {
+            netaddrcpy(&cache->nxthop, &rtptr->gateway);
+        }
+        cache->hwaddr.type = NULL;
+        cache->mtu = rtPmtuLookup(dst, cache->nif->mtu,
+                                  &cache->mtuexpires);
+        RT_TRACE("Filled destination cache");
+    }
+
+    /* Path MTU part */
+    if ((0 != cache->mtuexpires) && (cache->mtuexpires <= clktime))
+    {
+        cache->mtu = rtPmtuLookup(dst, cache->nif->mtu, &cache->mtuexpires);
+    }
+
+    /* Neighbor part */
+    if ((NULL != cache->hwaddr.type) && (cache->expires < clktime))
+    {
+        cache->hwaddr.type = NULL;
+    }
+    if (NULL == cache->hwaddr.type)
+    {
+        im = disable();
+        entry = arpGetEntry(&cache->nxthop);
+        if ((NULL != entry) && (ARP_RESOLVED == entry->state)
+            && (cache->gen == rtcachegen))
+        {
+            netaddrcpy(&cache->hwaddr, &entry->hwaddr);
+            cache->expires = entry->expires;
+        }
+        restore(im);
+    }
+
+    return OK;
+}
@@ -7,7 +7,6 @@
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
-#include <interrupt.h>
 #include <network.h>
 #include <route.h>
 
@@ -18,8 +17,8 @@
  */
 syscall rtClear(struct netif *nif)
 {
-    int i;
-    irqmask im;
+    struct rtEntry *rtptr;
+    struct rtEntry *next;
 
     /* Error check pointers */
     if (NULL == nif)
@@ -27,15 +26,17 @@ syscall rtClear(struct netif *nif)
         return SYSERR;
     }
 
-    im = disable();
-    for (i = 0; i < RT_NENTRY; i++)
+    wait(rtlock);
+    rtptr = rtlist;
+    while (NULL != rtptr)
     {
-        if ((RT_USED == rttab[i].state) && (nif == rttab[i].nif))
+        next = rtptr->next;
+        if (nif == rtptr->nif)
         {
-            rttab[i].state = RT_FREE;
-            rttab[i].nif = NULL;
+            rtFree(rtptr);
         }
+        rtptr = next;
     }
-    restore(im);
+    signal(rtlock);
     return OK;
 }
@@ -32,6 +32,7 @@ thread rtDaemon(void)
         }
 
         rtSend(pkt);
+        rtnfwdslow++;
         if (SYSERR == netFreebuf(pkt))
         {
             RT_TRACE("Failed to free packet buffer");
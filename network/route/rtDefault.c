@@ -20,7 +20,7 @@
 syscall rtDefault(struct netaddr *gate, struct netif *nif)
 {
     struct rtEntry *rtptr;
-    int i;
+    struct rtEntry **link;
     struct netaddr mask;
 
     /* Error check pointers */
@@ -36,13 +36,13 @@ syscall rtDefault(struct netaddr *gate, struct netif *nif)
     bzero(mask.addr, mask.len);
 
     /* Check if a default route already exists */
-    rtptr = NULL;
-    for (i = 0; i < RT_NENTRY; i++)
+    wait(rtlock);
+    for (link = &rtlist; NULL != *link; link = &(*link)->next)
     {
-        if ((RT_USED == rttab[i].state)
-            && (netaddrequal(&rttab[i].mask, &mask)))
+        if (netaddrequal(&(*link)->mask, &mask))
         {
-            RT_TRACE("Default route exists, entry %d", i);
+            RT_TRACE("Default route exists");
+            signal(rtlock);
             return OK;
         }
     }
@@ -52,6 +52,7 @@ syscall rtDefault(struct netaddr *gate, struct netif *nif)
     if ((SYSERR == (int)rtptr) || (NULL == rtptr))
     {
         RT_TRACE("Failed to allocate route entry");
+        signal(rtlock);
         return SYSERR;
     }
 
@@ -64,7 +65,18 @@ syscall rtDefault(struct netaddr *gate, struct netif *nif)
     /* Calculate mask length */
     rtptr->masklen = 0;
 
+    /* Append to the route list and index in the trie */
+    *link = rtptr;
     rtptr->state = RT_USED;
+    if (SYSERR == rtTrieInsert(&rttrie, rtptr))
+    {
+        rtFree(rtptr);
+        signal(rtlock);
+        return SYSERR;
+    }
+
+    rtCacheFlush();
+    signal(rtlock);
     RT_TRACE("Populated default route");
     return OK;
 }
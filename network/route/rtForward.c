@@ -0,0 +1,91 @@
+/**
+ * @file rtForward.c
+ * @provides rtForward
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <ethernet.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <network.h>
+#include <route.h>
+#include <string.h>
+
+/* Destination caches for forwarded traffic, indexed by destination */
+static struct rtCache rtfwdcache[RT_NFWDCACHE];
+
+uint rtnfwdfast = 0;
+uint rtnfwdslow = 0;
+
+/**
+ * Forward a packet from the receiving thread, without a trip through the
+ * route daemon, when its route and next hop hardware address are cached.
+ * Anything needing more work (an ARP miss, an ICMP error or redirect, or
+ * fragmentation) is left to the daemon.
+ * @param pkt incoming packet, with nethdr at the IPv4 header
+ * @return OK if the packet was forwarded and freed, SYSERR if it should
+ *  take the slow path
+ */
+syscall rtForward(struct packet *pkt)
+{
+    struct ipv4Pkt *ip;
+    struct rtCache *cache;
+    struct netif *nif;
+    struct netaddr dst;
+    struct netaddr hwaddr;
+    ushort oldword, newword;
+    uint h, sum;
+    irqmask im;
+
+    ip = (struct ipv4Pkt *)pkt->nethdr;
+
+    /* TTL expiring here needs an ICMP error */
+    if (ip->ttl <= 1)
+    {
+        return SYSERR;
+    }
+
+    dst.type = NETADDR_IPv4;
+    dst.len = IPv4_ADDR_LEN;
+    memcpy(dst.addr, ip->dst, dst.len);
+    h = (((dst.addr[0] * 31 + dst.addr[1]) * 31 + dst.addr[2]) * 31)
+        + dst.addr[3];
+    h ^= h >> 8;
+    cache = &rtfwdcache[h & (RT_NFWDCACHE - 1)];
+
+    /* Caches are shared by every receiving thread */
+    im = disable();
+    if ((SYSERR == rtCacheLookup(cache, &dst))
+        || (NULL == cache->hwaddr.type) || (cache->nif == pkt->nif)
+        || (net2hs(ip->len) > cache->nif->mtu))
+    {
+        restore(im);
+        RT_TRACE("Forward slow path");
+        return SYSERR;
+    }
+    nif = cache->nif;
+    netaddrcpy(&hwaddr, &cache->hwaddr);
+    restore(im);
+
+    /* Decrement TTL, updating the checksum incrementally (RFC 1624) */
+    oldword = (ip->ttl << 8) | ip->proto;
+    ip->ttl--;
+    newword = (ip->ttl << 8) | ip->proto;
+    sum = (~net2hs(ip->chksum) & 0xFFFF) + (~oldword & 0xFFFF) + newword;
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    ip->chksum = hs2net(~sum & 0xFFFF);
+
+    /* Hand to the egress interface, trimming any link-level padding */
+    pkt->nif = nif;
+    pkt->curr = pkt->nethdr;
+    pkt->len = net2hs(ip->len);
+    netSend(pkt, &hwaddr, NULL, ETHER_TYPE_IPv4);
+    rtnfwdfast++;
+
+    netFreebuf(pkt);
+    return OK;
+}
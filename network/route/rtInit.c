@@ -13,7 +13,9 @@
 #include <stdlib.h>
 #include <thread.h>
 
-struct rtEntry rttab[RT_NENTRY];
+struct rtEntry *rtlist;
+struct rtTrie rttrie;
+semaphore rtlock;
 mailbox rtqueue;
 
 /**
@@ -22,13 +24,13 @@ mailbox rtqueue;
  */
 syscall rtInit(void)
 {
-    int i = 0;
-
     /* Initialize route table */
-    for (i = 0; i < RT_NENTRY; i++)
+    rtlist = NULL;
+    bzero(&rttrie, sizeof(struct rtTrie));
+    rtlock = semcreate(1);
+    if (SYSERR == rtlock)
     {
-        bzero(&rttab[i], sizeof(struct rtEntry));
-        rttab[i].state = RT_FREE;
+        return SYSERR;
     }
 
     /* Initialize route queue */
@@ -0,0 +1,141 @@
+/**
+ * @file rtPmtu.c
+ * @provides rtPmtuLookup, rtPmtuUpdate
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <clock.h>
+#include <interrupt.h>
+#include <network.h>
+#include <route.h>
+
+struct rtPmtu rtpmtutab[RT_NPMTU];
+
+/* Common MTUs to try when a router does not report its own (RFC 1191) */
+static const ushort plateaus[] = {
+    32000, 17914, 8166, 4352, 2002, 1492, 1006, 508, 296, RT_PMTU_MIN
+};
+
+/**
+ * Find the path MTU to a destination.
+ * @param dst destination IP address
+ * @param mtu MTU of the outgoing interface
+ * @param expires set to the clktime the result goes stale, 0 if never
+ * @return smaller of the learned path MTU and mtu
+ */
+ushort rtPmtuLookup(struct netaddr *dst, ushort mtu, uint *expires)
+{
+    struct rtPmtu *pmtu;
+    irqmask im;
+    int i;
+
+    *expires = 0;
+    im = disable();
+    for (i = 0; i < RT_NPMTU; i++)
+    {
+        pmtu = &rtpmtutab[i];
+        if ((NULL == pmtu->dst.type) || !netaddrequal(&pmtu->dst, dst))
+        {
+            continue;
+        }
+        if (pmtu->expires <= clktime)
+        {
+            /* Aged out, so try the interface MTU again */
+            pmtu->dst.type = NULL;
+        }
+        else if (pmtu->mtu < mtu)
+        {
+            mtu = pmtu->mtu;
+            *expires = pmtu->expires;
+        }
+        break;
+    }
+    restore(im);
+
+    return mtu;
+}
+
+/**
+ * Record that a datagram to a destination was too big for a hop on the
+ * way.  The path MTU only goes down here; it goes back up when the entry
+ * ages out.
+ * @param dst destination of the datagram that was too big
+ * @param mtu MTU reported for the next hop, 0 if not reported
+ * @param len total length of the datagram that was too big
+ * @return OK if the path MTU was lowered, otherwise SYSERR
+ */
+syscall rtPmtuUpdate(struct netaddr *dst, ushort mtu, ushort len)
+{
+    struct rtPmtu *pmtu;
+    struct rtPmtu *oldest;
+    irqmask im;
+    int i;
+
+    if ((NULL == dst) || (NETADDR_IPv4 != dst->type))
+    {
+        return SYSERR;
+    }
+
+    /* Guess from the datagram's length if the router did not say */
+    if (0 == mtu)
+    {
+        for (i = 0; plateaus[i] > RT_PMTU_MIN; i++)
+        {
+            if (plateaus[i] < len)
+            {
+                break;
+            }
+        }
+        mtu = plateaus[i];
+    }
+    if (mtu < RT_PMTU_MIN)
+    {
+        mtu = RT_PMTU_MIN;
+    }
+    if (mtu >= len)
+    {
+        RT_TRACE("PMTU report would not have helped");
+        return SYSERR;
+    }
+
+    im = disable();
+    oldest = &rtpmtutab[0];
+    for (i = 0; i < RT_NPMTU; i++)
+    {
+        pmtu = &rtpmtutab[i];
+        if ((NULL != pmtu->dst.type) && (pmtu->expires <= clktime))
+        {
+            pmtu->dst.type = NULL;
+        }
+        if ((NULL != pmtu->dst.type) && netaddrequal(&pmtu->dst, dst))
+        {
+            break;
+        }
+        if ((NULL == pmtu->dst.type)
+            || ((NULL != oldest->dst.type)
+                && (pmtu->expires < oldest->expires)))
+        {
+            oldest = pmtu;
+        }
+    }
+    if (RT_NPMTU == i)
+    {
+        pmtu = oldest;
+        netaddrcpy(&pmtu->dst, dst);
+    }
+    else if (pmtu->mtu <= mtu)
+    {
+        restore(im);
+        return SYSERR;
+    }
+    pmtu->mtu = mtu;
+    pmtu->expires = clktime + RT_PMTU_AGE;
+    restore(im);
+
+    RT_TRACE("Lowered PMTU to %d", mtu);
+    rtCacheFlush();
+    return OK;
+}
@@ -22,6 +22,12 @@ syscall rtRecv(struct packet *pkt)
         return SYSERR;
     }
 
+    /* Forward straight away if route and neighbor are cached */
+    if (OK == rtForward(pkt))
+    {
+        return OK;
+    }
+
     /* If route queue is full, then drop packet */
     im = disable();
     if (mailboxCount(rtqueue) >= RT_NQUEUE)
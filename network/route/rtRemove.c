@@ -7,7 +7,6 @@
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
-#include <interrupt.h>
 #include <network.h>
 #include <route.h>
 
@@ -18,8 +17,8 @@
  */
 syscall rtRemove(struct netaddr *dst)
 {
-    int i;
-    irqmask im;
+    struct rtEntry *rtptr;
+    struct rtEntry *next;
 
     /* Error check pointers */
     if (NULL == dst)
@@ -27,16 +26,17 @@ syscall rtRemove(struct netaddr *dst)
         return SYSERR;
     }
 
-    im = disable();
-    for (i = 0; i < RT_NENTRY; i++)
+    wait(rtlock);
+    rtptr = rtlist;
+    while (NULL != rtptr)
     {
-        if ((RT_USED == rttab[i].state)
-            && netaddrequal(dst, &rttab[i].dst))
+        next = rtptr->next;
+        if (netaddrequal(dst, &rtptr->dst))
         {
-            rttab[i].state = RT_FREE;
-            rttab[i].nif = NULL;
+            rtFree(rtptr);
         }
+        rtptr = next;
     }
-    restore(im);
+    signal(rtlock);
     return OK;
 }
@@ -81,7 +81,7 @@ syscall rtSend(struct packet *pkt)
         nxthop = &route->gateway;
     }
 
-    if (SYSERR == ipv4SendFrag(pkt, nxthop))
+    if (SYSERR == ipv4SendFrag(pkt, nxthop, NULL, pkt->nif->mtu))
     {
         RT_TRACE("Routed packet: Host unreachable.");
         icmpDestUnreach(pkt, ICMP_HST_UNR);
@@ -0,0 +1,347 @@
+/**
+ * @file rtTrie.c
+ * @provides rtTrieInsert, rtTrieRemove, rtTrieLookup, rtTrieDestroy
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <interrupt.h>
+#include <memory.h>
+#include <network.h>
+#include <route.h>
+
+#define prefixmask(len) \
+    ((0 == (len)) ? 0 : (0xFFFFFFFF << (RT_KEYBITS - (len))))
+#define bitat(key, pos)  (((key) >> (RT_KEYBITS - 1 - (pos))) & 0x01)
+
+/**
+ * Convert an IPv4 address to a trie key.
+ */
+static uint rtkey(struct netaddr *addr)
+{
+    return ((uint)addr->addr[0] << 24) | ((uint)addr->addr[1] << 16)
+        | ((uint)addr->addr[2] << 8) | addr->addr[3];
+}
+
+/**
+ * Number of leading bits two keys have in common.
+ */
+static uint common(uint a, uint b)
+{
+    uint diff = a ^ b;
+    uint n = 0;
+
+    while ((n < RT_KEYBITS) && !(diff & (0x80000000 >> n)))
+    {
+        n++;
+    }
+    return n;
+}
+
+/**
+ * Take a node from the trie's free list, or from memory if it is empty.
+ */
+static struct rtNode *nodeget(struct rtTrie *trie)
+{
+    struct rtNode *node;
+
+    node = trie->free;
+    if (NULL != node)
+    {
+        trie->free = node->child[0];
+        return node;
+    }
+    node = memget(sizeof(struct rtNode));
+    if (SYSERR == (int)node)
+    {
+        return NULL;
+    }
+    return node;
+}
+
+/**
+ * Put a node that readers may still be looking at on the free list.
+ */
+static void nodeput(struct rtTrie *trie, struct rtNode *node)
+{
+    if (NULL != node)
+    {
+        node->route = NULL;
+        node->child[1] = NULL;
+        node->child[0] = trie->free;
+        trie->free = node;
+    }
+}
+
+static void nodeset(struct rtNode *node, uint key, ushort len,
+                    struct rtEntry *route)
+{
+    node->key = key;
+    node->len = len;
+    node->route = route;
+    node->child[0] = NULL;
+    node->child[1] = NULL;
+}
+
+/**
+ * Add a route to a trie.  If the trie already has a route for the same
+ * prefix that route is kept, so the route added first wins.
+ * @param trie trie to add to, whose writers the caller serializes
+ * @param rtptr route, with dst and masklen filled in
+ * @return OK if the route is indexed, SYSERR if out of memory
+ */
+syscall rtTrieInsert(struct rtTrie *trie, struct rtEntry *rtptr)
+{
+    struct rtNode *volatile *link;
+    struct rtNode *node, *fresh, *glue;
+    uint key, len, c;
+    irqmask im;
+
+    if ((NULL == rtptr) || (rtptr->masklen > RT_KEYBITS))
+    {
+        return SYSERR;
+    }
+    len = rtptr->masklen;
+    key = rtkey(&rtptr->dst) & prefixmask(len);
+
+    /* A new prefix needs at most a leaf and a node where it branches */
+    fresh = nodeget(trie);
+    glue = nodeget(trie);
+    if ((NULL == fresh) || (NULL == glue))
+    {
+        nodeput(trie, fresh);
+        nodeput(trie, glue);
+        return SYSERR;
+    }
+
+    link = &trie->root;
+    while (NULL != (node = *link))
+    {
+        c = common(key, node->key);
+        if (c > len)
+        {
+            c = len;
+        }
+        if (c > node->len)
+        {
+            c = node->len;
+        }
+
+        /* Node's prefix covers the new one, go down or stop here */
+        if (c == node->len)
+        {
+            if (node->len == len)
+            {
+                im = disable();
+                if (NULL == node->route)
+                {
+                    node->route = rtptr;
+                    trie->gen++;
+                }
+                restore(im);
+                nodeput(trie, fresh);
+                nodeput(trie, glue);
+                return OK;
+            }
+            link = &node->child[bitat(key, node->len)];
+            continue;
+        }
+
+        /* New prefix covers the node, put it above */
+        if (c == len)
+        {
+            nodeset(fresh, key, len, rtptr);
+            fresh->child[bitat(node->key, len)] = node;
+            im = disable();
+            *link = fresh;
+            trie->gen++;
+            restore(im);
+            nodeput(trie, glue);
+            return OK;
+        }
+
+        /* Prefixes part ways at bit c, branch there */
+        nodeset(fresh, key, len, rtptr);
+        nodeset(glue, key & prefixmask(c), c, NULL);
+        glue->child[bitat(key, c)] = fresh;
+        glue->child[bitat(node->key, c)] = node;
+        im = disable();
+        *link = glue;
+        trie->gen++;
+        restore(im);
+        return OK;
+    }
+
+    nodeset(fresh, key, len, rtptr);
+    im = disable();
+    *link = fresh;
+    trie->gen++;
+    restore(im);
+    nodeput(trie, glue);
+    return OK;
+}
+
+/**
+ * Remove a route from a trie, pruning nodes that no longer branch.
+ * Nothing changes unless rtptr is the route indexed for its prefix.
+ * @param trie trie to remove from, whose writers the caller serializes
+ * @param rtptr route to remove
+ * @param repl route for the same prefix to index instead, or NULL
+ */
+void rtTrieRemove(struct rtTrie *trie, struct rtEntry *rtptr,
+                  struct rtEntry *repl)
+{
+    struct rtNode *volatile *link;
+    struct rtNode *volatile *plink = NULL;
+    struct rtNode *node, *parent, *child;
+    struct rtNode *dead = NULL;
+    struct rtNode *deadparent = NULL;
+    uint key, len;
+    irqmask im;
+
+    if ((NULL == rtptr) || (rtptr->masklen > RT_KEYBITS))
+    {
+        return;
+    }
+    len = rtptr->masklen;
+    key = rtkey(&rtptr->dst) & prefixmask(len);
+
+    link = &trie->root;
+    while (NULL != (node = *link))
+    {
+        if ((node->len > len) || ((key & prefixmask(node->len)) != node->key))
+        {
+            return;
+        }
+        if (node->len == len)
+        {
+            break;
+        }
+        plink = link;
+        link = &node->child[bitat(key, node->len)];
+    }
+    if ((NULL == node) || (node->route != rtptr))
+    {
+        return;
+    }
+
+    im = disable();
+    node->route = repl;
+    if ((NULL == repl) && ((NULL == node->child[0])
+                           || (NULL == node->child[1])))
+    {
+        /* Splice the node out in favour of its only child, if any */
+        child = node->child[0];
+        if (NULL == child)
+        {
+            child = node->child[1];
+        }
+        *link = child;
+        dead = node;
+
+        /* A leaf's parent without a route is left with one child */
+        if ((NULL == child) && (NULL != plink))
+        {
+            parent = *plink;
+            if (NULL == parent->route)
+            {
+                child = parent->child[0];
+                if (NULL == child)
+                {
+                    child = parent->child[1];
+                }
+                *plink = child;
+                deadparent = parent;
+            }
+        }
+    }
+    trie->gen++;
+    restore(im);
+
+    nodeput(trie, dead);
+    nodeput(trie, deadparent);
+}
+
+/**
+ * Find the route with the longest prefix matching an address.  Takes no
+ * locks; the walk is retried if the trie changes during it.
+ * @param trie trie to search
+ * @param addr IPv4 address
+ * @return best matching route, NULL if none matches
+ */
+struct rtEntry *rtTrieLookup(struct rtTrie *trie, struct netaddr *addr)
+{
+    struct rtNode *node;
+    struct rtEntry *best;
+    uint key, gen;
+    int last;
+
+    if ((NULL == addr) || (NETADDR_IPv4 != addr->type))
+    {
+        return NULL;
+    }
+    key = rtkey(addr);
+
+    do
+    {
+        gen = trie->gen;
+        best = NULL;
+        last = -1;
+        for (node = trie->root; NULL != node;
+             node = node->child[bitat(key, node->len)])
+        {
+            /* Prefixes only grow on the way down; anything else means the
+             * node was recycled under us and gen will have moved */
+            if ((int)node->len <= last)
+            {
+                break;
+            }
+            last = node->len;
+            if ((key & prefixmask(node->len)) != node->key)
+            {
+                break;
+            }
+            if (NULL != node->route)
+            {
+                best = node->route;
+            }
+            if (node->len >= RT_KEYBITS)
+            {
+                break;
+            }
+        }
+    }
+    while (gen != trie->gen);
+
+    return best;
+}
+
+static void nodefree(struct rtNode *node)
+{
+    if (NULL != node)
+    {
+        nodefree(node->child[0]);
+        nodefree(node->child[1]);
+        memfree(node, sizeof(struct rtNode));
+    }
+}
+
+/**
+ * Return all of a trie's nodes to memory.  No reader may be using it.
+ * @param trie trie to empty
+ */
+void rtTrieDestroy(struct rtTrie *trie)
+{
+    struct rtNode *node;
+
+    nodefree(trie->root);
+    trie->root = NULL;
+    while (NULL != (node = trie->free))
+    {
+        trie->free = node->child[0];
+        memfree(node, sizeof(struct rtNode));
+    }
+    trie->gen++;
+}
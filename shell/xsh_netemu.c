@@ -7,8 +7,12 @@
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <date.h>
+#include <network.h>
+#include <netemu.h>
 
 /**
  * Shell command (netemu). Allows user to set network emulator options.
@@ -18,7 +22,42 @@
  */
 shellcmd xsh_netemu(int nargs, char *args[])
 {
-    srand(getRdate("192.168.6.10"));
-    return 0;
+    int percent;
+
+    /* Output help, if '--help' argument was supplied */
+    if (nargs == 2 && strncmp(args[1], "--help", 7) == 0)
+    {
+        printf("Usage: %s [drop <PERCENT>]\n\n", args[0]);
+        printf("Description:\n");
+        printf("\tSets network emulator options for routed packets\n");
+        printf("Options:\n");
+        printf("\tdrop <PERCENT>\tdrop this percent of packets\n");
+        printf("\t--help\t\tdisplay this help and exit\n");
+        return OK;
+    }
+
+    if (nargs == 3 && strncmp(args[1], "drop", 5) == 0)
+    {
+        percent = atoi(args[2]);
+        if ((percent < 0) || (percent > 100))
+        {
+            fprintf(stderr, "%s: drop percent must be 0 to 100\n",
+                    args[0]);
+            return SYSERR;
+        }
+        emudrop = percent;
+        return OK;
+    }
 
+    if (nargs != 1)
+    {
+        fprintf(stderr, "%s: invalid arguments\n", args[0]);
+        fprintf(stderr, "Try '%s --help' for more information\n",
+                args[0]);
+        return SYSERR;
+    }
+
+    srand(getRdate("192.168.6.10"));
+    printf("Dropping %d%% of routed packets\n", emudrop);
+    return OK;
 }
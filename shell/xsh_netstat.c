@@ -9,6 +9,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include <ipv4.h>
 #include <network.h>
 
 static void netStat(struct netif *);
@@ -61,6 +62,11 @@ shellcmd xsh_netstat(int nargs, char *args[])
     netStat(NULL);
 #endif
 
+    printf("IPv4 Reassembly:\n");
+    printf("\t");
+    printf("Complete: %-14d   Timed Out: %d   Overflow: %d\n",
+           ipv4reasmok, ipv4reasmtimeout, ipv4reasmoverflow);
+
     return OK;
 }
 
@@ -95,6 +101,19 @@ static void netStat(struct netif *netptr)
            netptr->linkhdrlen);
     printf("\t");
     printf("Num Rcv: %-15d   Num Proc: %d\n", netptr->nin, netptr->nproc);
+    if (netptr->npoll > 0)
+    {
+        printf("\t");
+        printf("Num Poll: %-14d   Full Budget: %d   Frames/Poll: %d\n",
+               netptr->npoll, netptr->nbudget,
+               netptr->nin / netptr->npoll);
+    }
+    if (netptr->txbatch)
+    {
+        printf("\t");
+        printf("Num Xmit: %-14d   Tx Queued: %d   Tx Drop: %d\n",
+               netptr->nout, netptr->ntxqueued, netptr->ntxdrop);
+    }
 
     return;
 }
@@ -25,6 +25,7 @@ shellcmd xsh_route(int nargs, char *args[])
     char c[32];
     device *pdev;
     struct netif *netptr;
+    struct rtEntry *rtptr;
 
     struct netaddr dst;
     struct netaddr mask;
@@ -133,29 +134,30 @@ shellcmd xsh_route(int nargs, char *args[])
     printf
         ("Destination     Gateway         Mask            Interface\r\n");
 
-    for (i = 0; i < RT_NENTRY; i++)
+    wait(rtlock);
+    for (rtptr = rtlist; NULL != rtptr; rtptr = rtptr->next)
     {
-        if (RT_USED == rttab[i].state)
-        {
-            if (0 == rttab[i].masklen)
-                sprintf(c, "default");
-            else
-                netaddrsprintf(c, &rttab[i].dst);
-            printf("%-16s", c);
-
-            netaddrsprintf(c, &rttab[i].gateway);
-            if (strncmp(c, "NULL", 5) == 0)
-                sprintf(c, "*");
-            printf("%-16s", c);
-
-            netaddrsprintf(c, &rttab[i].mask);
-            printf("%-16s", c);
-
-            netptr = rttab[i].nif;
-            pdev = (device *)&devtab[netptr->dev];
-            printf("%s\r\n", pdev->name);
-        }
+        if (0 == rtptr->masklen)
+            sprintf(c, "default");
+        else
+            netaddrsprintf(c, &rtptr->dst);
+        printf("%-16s", c);
+
+        netaddrsprintf(c, &rtptr->gateway);
+        if (strncmp(c, "NULL", 5) == 0)
+            sprintf(c, "*");
+        printf("%-16s", c);
+
+        netaddrsprintf(c, &rtptr->mask);
+        printf("%-16s", c);
+
+        netptr = rtptr->nif;
+        pdev = (device *)&devtab[netptr->dev];
+        printf("%s\r\n", pdev->name);
     }
+    signal(rtlock);
+    printf("\nForwarded: %u fast path, %u via route daemon\r\n",
+           rtnfwdfast, rtnfwdslow);
 
     return 0;
 }
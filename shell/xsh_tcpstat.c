@@ -22,31 +22,59 @@ shellcmd xsh_tcpstat(int nargs, char *args[])
 {
 
     int i;
+#if NTCP
+    bool verbose, dump;
+#endif
 
     /* Output help, if '--help' argument was supplied */
     if (nargs == 2 && strncmp(args[1], "--help", 7) == 0)
     {
-        printf("Usage: %s\n\n", args[0]);
+        printf("Usage: %s [-v | -d]\n\n", args[0]);
         printf("Description:\n");
         printf("\tDisplays TCP socket information\n");
         printf("Options:\n");
+        printf("\t-v\talso display round trip and congestion counts\n");
+        printf("\t-d\tdump round trip and congestion counts in hex\n");
         printf("\t--help\tdisplay this help and exit\n");
         return OK;
     }
 
     /* Check for correct number of arguments */
-    if (nargs > 1)
+    if (nargs > 2)
     {
         fprintf(stderr, "%s: too many arguments\n", args[0]);
         fprintf(stderr, "Try '%s --help' for more information\n",
                 args[0]);
         return SYSERR;
     }
+    if ((nargs == 2) && (0 != strncmp(args[1], "-v", 3))
+        && (0 != strncmp(args[1], "-d", 3)))
+    {
+        fprintf(stderr, "%s: invalid argument\n", args[0]);
+        fprintf(stderr, "Try '%s --help' for more information\n",
+                args[0]);
+        return SYSERR;
+    }
 
 #if NTCP
+    verbose = ((nargs == 2) && (0 == strncmp(args[1], "-v", 3)));
+    dump = ((nargs == 2) && (0 == strncmp(args[1], "-d", 3)));
     for (i = 0; i < NTCP; i++)
     {
+        if (dump)
+        {
+            tcpStatInstr(&tcptab[i], TRUE);
+            continue;
+        }
         tcpStat(&tcptab[i]);
+        if (verbose)
+        {
+            tcpStatInstr(&tcptab[i], FALSE);
+        }
+    }
+    if (!dump)
+    {
+        tcpTimewaitStat();
     }
 #else
     i = 0;
@@ -17,6 +17,10 @@
 #include <ipv4.h>
 #include <network.h>
 #include <ether.h>
+#include <tcp.h>
+
+/* Listening TCP device the telnet servers accept connections from */
+static int listener = SYSERR;
 
 int argErr(char *command, char *arg)
 {
@@ -35,6 +39,7 @@ shellcmd xsh_telnetserver(int nargs, char *args[])
 {
     int descrp, port, i, spawntelnet;
     struct thrent *thrptr;
+    struct netif *interface;
     char thrname[TNMLEN];
 
     spawntelnet = 0;
@@ -78,6 +83,13 @@ shellcmd xsh_telnetserver(int nargs, char *args[])
         semfree(telnettab[0].killswitch);
         telnettab[0].killswitch = semcreate(0);
 #endif                          /* NTELNET */
+
+        /* Stop listening, resetting connections not yet served */
+        if (SYSERR != listener)
+        {
+            close(listener);
+            listener = SYSERR;
+        }
         return 0;
     }
 
@@ -131,15 +143,47 @@ shellcmd xsh_telnetserver(int nargs, char *args[])
         return SHELL_ERROR;
     }
 
-    /* spawn three servers */
+    if (SYSERR != listener)
+    {
+        fprintf(stderr, "%s: server already running\n", args[0]);
+        return SHELL_ERROR;
+    }
+
+    interface = netLookup(descrp);
+    if (NULL == interface)
+    {
+        fprintf(stderr, "%s: no network interface\n", args[0]);
+        return SHELL_ERROR;
+    }
+
+    /* spawn servers sharing one listening socket, which queues
+     * connections while every server is busy */
 #if NTELNET
+    listener = tcpAlloc();
+    if (SYSERR == (short)listener)
+    {
+        listener = SYSERR;
+        fprintf(stderr, "%s: failed to allocate TCP device\n", args[0]);
+        return SHELL_ERROR;
+    }
+    if ((SYSERR == control(listener, TCP_CTRL_LISTEN, NTELNET, 0))
+        || (SYSERR == open(listener, &interface->ip, NULL, port, NULL,
+                           TCP_PASSIVE)))
+    {
+        close(listener);
+        listener = SYSERR;
+        fprintf(stderr, "%s: failed to listen on port %d\n", args[0],
+                port);
+        return SHELL_ERROR;
+    }
+
     for (i = 0; i < NTELNET; i++)
     {
         spawntelnet = telnetAlloc();
         sprintf(thrname, "telnetServ_%d\0", (spawntelnet - TELNET0));
         TELNET_TRACE("Spawning %s on %d", thrname, spawntelnet - TELNET0);
         ready(create((void *)telnetServer, INITSTK, INITPRIO, thrname,
-                     4, descrp, port, spawntelnet, "SHELL2"),
+                     3, listener, spawntelnet, "SHELL2"),
               RESCHED_YES);
     }
 #endif
@@ -79,6 +79,13 @@ shellcmd xsh_xweb(int nargs, char *args[])
             signal(httptab[i].closeall);
         }
 
+        /* Stop listening, resetting connections not yet served */
+        if (SYSERR != httplisten)
+        {
+            close(httplisten);
+            httplisten = SYSERR;
+        }
+
         oldsem = activeXWeb;
         activeXWeb = semcreate(1);
         semfree(oldsem);
@@ -1,6 +1,6 @@
 /**
  * @file     tar.c
- * @provides tarGetData.
+ * @provides tarGetData, tarGetDataAddr.
  *
  * $Id: tar.c 2020 2009-08-13 17:50:08Z mschul $
  */
@@ -118,18 +118,11 @@ int tarGetData(struct tar *file, char *buffer, uint size)
     char *data;
 
     /* point to data section of file */
-    data = file->type.data;
+    data = tarGetDataAddr(file);
 
     /* determine the file size (stored in octal string) */
     filesize = tarFilesize(file->filesize);
 
-    /* is the file ustar format? */
-    if (0 == strncmp((void *)&(file->type.ustar.isustar), "ustar", 5))
-    {
-        /* update data pointer and file size */
-        data = file->type.ustar.data;
-    }
-
     /* check bounds */
     if (size > filesize)
     {
@@ -142,6 +135,22 @@ int tarGetData(struct tar *file, char *buffer, uint size)
     return size;
 }
 
+/**
+ * Given a pointer to the tar header of a file, get where the data stored
+ * in the file lies in the archive, so it can be used without a copy.
+ * @param file pointer to tar header of file
+ * @return pointer to first byte of data
+ */
+char *tarGetDataAddr(struct tar *file)
+{
+    /* is the file ustar format? */
+    if (0 == strncmp((void *)&(file->type.ustar.isustar), "ustar", 5))
+    {
+        return file->type.ustar.data;
+    }
+    return file->type.data;
+}
+
 /**
  * Decode the filesize of a tar file.  Filesize is stored as an octal
  * string.
@@ -8,6 +8,7 @@
 
 #include <stddef.h>
 #include <arp.h>
+#include <bufpool.h>
 #include <clock.h>
 #include <ethloop.h>
 #include <interrupt.h>
@@ -70,6 +71,8 @@ thread test_arp(bool verbose)
     struct ethloop *pelp;
     uchar *data;
     uchar *request;
+    uchar *reply;
+    int rplen;
     struct arpPkt *arp;
     struct arpEntry *entry;
     uchar buf[ELOOP_BUFSIZE];
@@ -343,6 +346,7 @@ thread test_arp(bool verbose)
         netaddrcpy(&entry->hwaddr, &hwaddr);
         netaddrcpy(&entry->praddr, &praddr);
         entry->expires = clktime + ARP_TTL_RESOLVED;
+        arpHashInsert(entry);
     }
     for (i = 1; i < nout; i++)
     {
@@ -384,6 +388,8 @@ thread test_arp(bool verbose)
     {
         phdr.caplen = endswap(phdr.caplen);
     }
+    reply = data;
+    rplen = phdr.caplen;
     praddr.addr[3] = 3;
     hwaddr.addr[5] = 0xCC;
     nout = pelp->nout;
@@ -715,6 +721,7 @@ thread test_arp(bool verbose)
     netaddrcpy(&entry->hwaddr, &hwaddr);
     netaddrcpy(&entry->praddr, &praddr);
     entry->expires = clktime + ARP_TTL_UNRESOLVED;
+    arpHashInsert(entry);
     i = arpLookup(netptr, &praddr, &addrbuf);
     if ((SYSERR == i) || (TIMEOUT == i))
     {
@@ -736,6 +743,7 @@ thread test_arp(bool verbose)
     netaddrcpy(&entry->hwaddr, &hwaddr);
     netaddrcpy(&entry->praddr, &praddr);
     entry->expires = clktime + ARP_TTL_UNRESOLVED;
+    arpHashInsert(entry);
     control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
     request = data;
     wait = phdr.caplen;
@@ -817,6 +825,106 @@ thread test_arp(bool verbose)
     control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_DROPALL, NULL);
     failif((SYSERR != arpLookup(netptr, &praddr, &addrbuf)), "");
 
+    /* Test arpResolve */
+    testPrint(verbose, "Send to unresolved address (held)");
+    for (i = 0; i < ARP_NENTRY; i++)
+    {
+        arpFree(&arptab[i]);
+    }
+    control(ELOOP, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_DROPALL, NULL);
+    praddr.addr[3] = 3;
+    hwaddr.addr[5] = 0xCC;
+    pkt->nif = netptr;
+    control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+    if (SYSERR == netSend(pkt, NULL, &praddr, ETHER_TYPE_ARP))
+    {
+        failif(TRUE, "Returned SYSERR");
+    }
+    else
+    {
+        /* Discard the request that went out for the new entry */
+        control(ELOOP, ELOOP_CTRL_GETHOLD, (int)buf, ELOOP_BUFSIZE);
+        entry = arpGetEntry(&praddr);
+        failif(((NULL == entry) || (entry->state != ARP_UNRESOLVED)
+                || (entry->npending != 1)), "");
+    }
+
+    /* Test arpResolve */
+    testPrint(verbose, "Request resent while packets held");
+    if (NULL == entry)
+    {
+        failif(TRUE, "No entry");
+    }
+    else
+    {
+        entry->rqsttime = clktime - ARP_RQST_INTERVAL;
+        control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+        arpResolve(netptr, &praddr, &addrbuf, pkt);
+        if (semcount(pelp->hsem) <= 0)
+        {
+            control(ELOOP, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+            failif(TRUE, "Request not resent");
+        }
+        else
+        {
+            control(ELOOP, ELOOP_CTRL_GETHOLD, (int)buf, ELOOP_BUFSIZE);
+            failif(((entry->npending != 2)
+                    || (entry->rqsttime != clktime)), "");
+        }
+    }
+
+    /* Test arpResolve */
+    testPrint(verbose, "Hold bounded per entry");
+    for (i = 1; i < ARP_NPENDING; i++)
+    {
+        arpResolve(netptr, &praddr, &addrbuf, pkt);
+    }
+    failif(((SYSERR != arpResolve(netptr, &praddr, &addrbuf, pkt))
+            || (NULL == entry) || (entry->npending != ARP_NPENDING)), "");
+
+    /* Test arpFree */
+    testPrint(verbose, "Free entry drops held packets");
+    nout = semcount(bfptab[netpool].freebuf);
+    arpFree(entry);
+    failif((semcount(bfptab[netpool].freebuf) != nout + ARP_NPENDING),
+           "");
+
+    /* Test arpRecv */
+    testPrint(verbose, "Reply sends held packet");
+    control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+    arpResolve(netptr, &praddr, &addrbuf, pkt);
+    control(ELOOP, ELOOP_CTRL_GETHOLD, (int)buf, ELOOP_BUFSIZE);
+    nproc = netptr->nproc;
+    im = disable();
+    write(ELOOP, reply, rplen);
+    control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+    restore(im);
+    wait = 0;
+    while ((wait < MAX_WAIT) && (netptr->nproc == nproc))
+    {
+        wait++;
+        sleep(10);
+    }
+    entry = arpGetEntry(&praddr);
+    if ((MAX_WAIT == wait) || (NULL == entry))
+    {
+        failif(TRUE, "Reply not processed");
+    }
+    else if ((entry->state != ARP_RESOLVED) || (entry->npending != 0)
+             || (semcount(pelp->hsem) <= 0))
+    {
+        failif(TRUE, "Held packet not sent");
+    }
+    else
+    {
+        control(ELOOP, ELOOP_CTRL_GETHOLD, (int)buf, ELOOP_BUFSIZE);
+        failif(((0 != memcmp(buf, hwaddr.addr, ETH_ADDR_LEN))
+                || (0 != memcmp(buf + ETH_ADDR_LEN,
+                                pkt->curr + ETH_ADDR_LEN,
+                                pkt->len - ETH_ADDR_LEN))), "");
+    }
+    control(ELOOP, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+
     /* Stop loopback ethernet and network interface */
     testPrint(verbose, "Test case cleanup");
     for (i = 0; i < ARP_NENTRY; i++)
@@ -72,6 +72,9 @@ static int ethloopn_test(bool verbose, int dev)
     int devminor;
     struct ethloop *pelp;
     struct netaddr addr;
+    struct packet *pkt;
+    struct packet *pkts[NET_RECV_BUDGET];
+    semaphore wake;
     device *pdev;
 
     pdev = (device *)&devtab[dev];
@@ -205,6 +208,95 @@ static int ethloopn_test(bool verbose, int dev)
     len = read(dev, inpkt, 700);
     failif((0 != memcmp(outpkt, inpkt, 700)), "");
 
+    /* receive handoff: frames land in packets owned by the caller */
+    sprintf(str, "%s  700 byte packet (handoff)", pelp->dev->name);
+    testPrint(verbose, str);
+    if (SYSERR == control(dev, NET_SET_RXPOOL, netpool, NULL))
+    {
+        failif(TRUE, "Pool not accepted");
+    }
+    else
+    {
+        write(dev, outpkt, 700);
+        len = control(dev, NET_RECV_POLL, (long)pkts, NET_RECV_BUDGET);
+        if (1 != len)
+        {
+            failif(TRUE, "No packet handed off");
+        }
+        else
+        {
+            pkt = pkts[0];
+            failif(((700 != pkt->len)
+                    || (0 != memcmp(outpkt, pkt->data, 700))), "");
+            netFreebuf(pkt);
+        }
+    }
+
+    /* a poll takes every queued frame up to its budget, no more */
+    sprintf(str, "%s  polled batch within budget", pelp->dev->name);
+    testPrint(verbose, str);
+    for (i = 0; i < 3; i++)
+    {
+        write(dev, outpkt, 700);
+    }
+    len = control(dev, NET_RECV_POLL, (long)pkts, 2);
+    value = control(dev, NET_RECV_POLL, (long)&pkts[2], NET_RECV_BUDGET);
+    failif(((2 != len) || (1 != value) || (0 != pelp->count)), "");
+    for (i = 0; i < len; i++)
+    {
+        netFreebuf(pkts[i]);
+    }
+    for (i = 0; i < value; i++)
+    {
+        netFreebuf(pkts[2 + i]);
+    }
+
+    /* queued handoff frames are still readable by a plain read */
+    sprintf(str, "%s  700 byte packet (handoff read)", pelp->dev->name);
+    testPrint(verbose, str);
+    write(dev, outpkt, 700);
+    bzero(inpkt, memsize);
+    len = read(dev, inpkt, 700);
+    failif((0 != memcmp(outpkt, inpkt, 700)), "");
+
+    sprintf(str, "%s  detach recv pool", pelp->dev->name);
+    testPrint(verbose, str);
+    write(dev, outpkt, 700);
+    failif(((SYSERR == control(dev, NET_SET_RXPOOL, SYSERR, NULL))
+            || (0 != pelp->count)), "");
+
+    /* batched transmit stops at a full queue and wakes on free space */
+    sprintf(str, "%s  batch submit to full queue", pelp->dev->name);
+    testPrint(verbose, str);
+    wake = semcreate(0);
+    control(dev, NET_SET_TXWAKE, wake, NULL);
+    while (pelp->count < ELOOP_NBUF - 1)
+    {
+        write(dev, outpkt, 64);
+    }
+    for (i = 0; i < 3; i++)
+    {
+        pkts[i] = netGetbuf();
+        memcpy(pkts[i]->data, outpkt, 64);
+        pkts[i]->curr = pkts[i]->data;
+        pkts[i]->len = 64;
+    }
+    len = control(dev, NET_SEND_BATCH, (long)pkts, 3);
+    subpass = ((1 == len) && (ELOOP_NBUF == pelp->count)
+               && (0 == semcount(wake)));
+    read(dev, inpkt, 64);
+    failif((!subpass || (1 != semcount(wake))), "");
+    control(dev, NET_SET_TXWAKE, SYSERR, NULL);
+    semfree(wake);
+    for (i = 0; i < 3; i++)
+    {
+        netFreebuf(pkts[i]);
+    }
+    while (pelp->count > 0)
+    {
+        read(dev, inpkt, 64);
+    }
+
     /* memfree */
     memfree(outpkt, memsize);
     memfree(inpkt, memsize);
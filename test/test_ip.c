@@ -6,8 +6,11 @@
  */
 
 #include <stddef.h>
+#include <bufpool.h>
+#include <clock.h>
 #include <device.h>
 #include <ethloop.h>
+#include <icmp.h>
 #include <ipv4.h>
 #include <snoop.h>
 #include <pcap.h>
@@ -29,6 +32,13 @@ extern int _binary_data_testip_pcap_start;
 #define NNETIF (-1)
 #endif
 
+#define REASM_MTU       576
+#define REASM_DATALEN   1400
+#define REASM_PORT      9000
+
+static struct packet *fragment(struct netif *, ushort, uint, uint, bool);
+static bool reasmCheck(struct packet *, uint);
+
 thread test_ip(bool verbose)
 {
     struct netaddr dst;
@@ -41,6 +51,12 @@ thread test_ip(bool verbose)
     struct packet *pktB;
     uchar *data;
     uchar buf[500];
+    struct packet *pkt;
+    struct ipv4Pkt *ip;
+    struct icmpPkt *icmp;
+    struct udpPkt *udppkt;
+    uint count;
+    int nread;
     int i;
     int nproc;
     int wait;
@@ -152,7 +168,7 @@ thread test_ip(bool verbose)
 
         control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
 
-        if (OK != ipv4Send(pktB, &src, &dst, IPv4_PROTO_UDP))
+        if (OK != ipv4Send(pktB, &src, &dst, IPv4_PROTO_UDP, NULL))
         {
             failif(TRUE, "ipv4Send didn't return okay");
         }
@@ -163,6 +179,138 @@ thread test_ip(bool verbose)
         }
     }
 
+    /* Fragments arriving out of order, one of them twice */
+    testPrint(verbose, "Reassemble out of order");
+    count = ipv4reasmok;
+    pkt = ipv4Reasm(fragment(netptr, 1, 64, 40, FALSE));
+    if (NULL == pkt)
+    {
+        pkt = ipv4Reasm(fragment(netptr, 1, 32, 32, TRUE));
+    }
+    if (NULL == pkt)
+    {
+        pkt = ipv4Reasm(fragment(netptr, 1, 32, 32, TRUE));
+    }
+    if (NULL == pkt)
+    {
+        pkt = ipv4Reasm(fragment(netptr, 1, 0, 32, TRUE));
+    }
+    failif(((NULL == pkt) || (count + 1 != ipv4reasmok)
+            || !reasmCheck(pkt, 104)), "");
+    if (NULL != pkt)
+    {
+        netFreebuf(pkt);
+    }
+
+    /* Fill every reassembly buffer with a datagram missing its start */
+    testPrint(verbose, "Reassembly overflow");
+    count = ipv4reasmoverflow;
+    for (i = 0; i < IPv4_REASM_NBUF; i++)
+    {
+        ipv4Reasm(fragment(netptr, 100 + i, 8, 8, TRUE));
+    }
+    ipv4Reasm(fragment(netptr, 99, 0, 8, TRUE));
+    ipv4Reasm(fragment(netptr, 1, IPv4_REASM_MAXLEN, 8, FALSE));
+    failif((count + 2 != ipv4reasmoverflow), "");
+
+    testPrint(verbose, "Reassembly timeout");
+    count = ipv4reasmtimeout;
+    for (i = 0; i < IPv4_REASM_NBUF; i++)
+    {
+        ipv4reasmtab[i].expires = clktime;
+    }
+    ipv4ReasmExpire();
+    failif(((count + IPv4_REASM_NBUF != ipv4reasmtimeout)
+            || (IPv4_REASM_NBUF != semcount(bfptab[ipv4reasmpool].freebuf))),
+           "");
+
+    /* Source learns of a timeout once the first fragment was seen */
+    testPrint(verbose, "Reassembly time exceeded");
+    ipv4Reasm(fragment(netptr, 2, 0, 8, TRUE));
+    for (i = 0; i < IPv4_REASM_NBUF; i++)
+    {
+        ipv4reasmtab[i].expires = clktime;
+    }
+    control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+    ipv4ReasmExpire();
+    if (semcount(elooptab[devtab[ELOOP].minor].hsem) <= 0)
+    {
+        control(ELOOP, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+        failif(TRUE, "No ICMP sent");
+    }
+    else
+    {
+        control(ELOOP, ELOOP_CTRL_GETHOLD, (long)buf, 500);
+        ip = (struct ipv4Pkt *)(buf + ETH_HDR_LEN);
+        icmp = (struct icmpPkt *)(buf + ETH_HDR_LEN + IPv4_HDR_LEN);
+        failif(((IPv4_PROTO_ICMP != ip->proto)
+                || (ICMP_TIMEEXCD != icmp->type)
+                || (ICMP_FRA_EXC != icmp->code)), "");
+    }
+
+#if UDP0
+    /* Fragments from ipv4SendFrag looped back through the stack */
+    testPrint(verbose, "Reassemble ipv4SendFrag fragments");
+    count = ipv4reasmok;
+    if (SYSERR == open(UDP0, &src, NULL, REASM_PORT, NULL))
+    {
+        failif(TRUE, "Open returned SYSERR");
+    }
+    else
+    {
+        control(UDP0, UDP_CTRL_SETFLAG, UDP_FLAG_NOBLOCK, NULL);
+        pkt = netGetbuf();
+        pkt->nif = netptr;
+        pkt->len = UDP_HDR_LEN + REASM_DATALEN;
+        pkt->curr -= pkt->len;
+        udppkt = (struct udpPkt *)pkt->curr;
+        udppkt->srcPort = hs2net(REASM_PORT + 1);
+        udppkt->dstPort = hs2net(REASM_PORT);
+        udppkt->len = hs2net(pkt->len);
+        udppkt->chksum = 0;
+        for (i = 0; i < REASM_DATALEN; i++)
+        {
+            udppkt->data[i] = i & 0xFF;
+        }
+        udppkt->chksum = udpChksum(pkt, pkt->len, &dst, &src);
+
+        pkt->curr -= IPv4_HDR_LEN;
+        pkt->len += IPv4_HDR_LEN;
+        ip = (struct ipv4Pkt *)pkt->curr;
+        ip->ver_ihl = (IPv4_VERSION << 4) | IPv4_MIN_IHL;
+        ip->tos = IPv4_TOS_ROUTINE;
+        ip->len = hs2net(pkt->len);
+        ip->id = hs2net(3);
+        ip->flags_froff = 0;
+        ip->ttl = IPv4_TTL;
+        ip->proto = IPv4_PROTO_UDP;
+        memcpy(ip->src, dst.addr, IPv4_ADDR_LEN);
+        memcpy(ip->dst, src.addr, IPv4_ADDR_LEN);
+        ip->chksum = 0;
+        ip->chksum = netChksum((uchar *)ip, IPv4_HDR_LEN);
+
+        ipv4SendFrag(pkt, &netptr->ip, &netptr->hwaddr, REASM_MTU);
+        netFreebuf(pkt);
+
+        nread = 0;
+        for (wait = 0; (wait < MAX_WAIT) && (0 == nread); wait++)
+        {
+            sleep(10);
+            nread = read(UDP0, buf, sizeof(buf));
+        }
+        for (i = 0; i < nread; i++)
+        {
+            if (buf[i] != (i & 0xFF))
+            {
+                break;
+            }
+        }
+        failif(((sizeof(buf) != nread) || (i != nread)
+                || (count + 1 != ipv4reasmok)), "");
+        close(UDP0);
+    }
+#endif                          /* UDP0 */
+
     /* ipv4Recv Testing */
     //TODO: Finish ipv4Recv
 /*	testPrint(verbose, "ipv4Recv");
@@ -198,3 +346,73 @@ thread test_ip(bool verbose)
 
     return OK;
 }
+
+/**
+ * Build a fragment from 192.168.1.1 of a datagram whose payload byte at
+ * each offset is the offset.
+ */
+static struct packet *fragment(struct netif *netptr, ushort id, uint off,
+                               uint len, bool more)
+{
+    struct packet *pkt;
+    struct ipv4Pkt *ip;
+    uint i;
+
+    pkt = netGetbuf();
+    if (SYSERR == (int)pkt)
+    {
+        return NULL;
+    }
+    pkt->nif = netptr;
+    pkt->linkhdr = pkt->data;
+    pkt->nethdr = pkt->linkhdr + ETH_HDR_LEN;
+    pkt->len = ETH_HDR_LEN + IPv4_HDR_LEN + len;
+
+    ip = (struct ipv4Pkt *)pkt->nethdr;
+    ip->ver_ihl = (IPv4_VERSION << 4) | IPv4_MIN_IHL;
+    ip->tos = IPv4_TOS_ROUTINE;
+    ip->len = hs2net(IPv4_HDR_LEN + len);
+    ip->id = hs2net(id);
+    ip->flags_froff = hs2net((more ? IPv4_FLAG_MF : 0) | (off >> 3));
+    ip->ttl = IPv4_TTL;
+    ip->proto = IPv4_PROTO_UDP;
+    ip->src[0] = 192;
+    ip->src[1] = 168;
+    ip->src[2] = 1;
+    ip->src[3] = 1;
+    memcpy(ip->dst, netptr->ip.addr, IPv4_ADDR_LEN);
+    ip->chksum = 0;
+    ip->chksum = netChksum((uchar *)ip, IPv4_HDR_LEN);
+    for (i = 0; i < len; i++)
+    {
+        ip->opts[i] = (off + i) & 0xFF;
+    }
+
+    return pkt;
+}
+
+/**
+ * Check a reassembled datagram built from fragment()s.
+ */
+static bool reasmCheck(struct packet *pkt, uint total)
+{
+    struct ipv4Pkt *ip;
+    uint i;
+
+    ip = (struct ipv4Pkt *)pkt->nethdr;
+    if ((IPv4_HDR_LEN + total != pkt->len)
+        || (IPv4_HDR_LEN + total != net2hs(ip->len))
+        || (0 != ip->flags_froff)
+        || (0 != netChksum((uchar *)ip, IPv4_HDR_LEN)))
+    {
+        return FALSE;
+    }
+    for (i = 0; i < total; i++)
+    {
+        if (ip->opts[i] != (i & 0xFF))
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
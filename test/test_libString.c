@@ -2,8 +2,177 @@
 #include <string.h>
 #include <stdio.h>
 #include <testsuite.h>
+#include <clock.h>
 
 #define LEN_STR 7
+#define BENCH_ROUNDS 200
+
+/* A representative HTTP request header buffer for the benchmark */
+static const char httphdrs[] =
+    "GET /cgi-bin/config.html HTTP/1.1\r\n"
+    "Host: 192.168.1.1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux mips) Gecko/20100101\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9\r\n"
+    "Accept-Language: en-us,en;q=0.5\r\n"
+    "Accept-Encoding: gzip,deflate\r\n"
+    "Connection: keep-alive\r\n"
+    "Referer: http://192.168.1.1/index.html\r\n"
+    "Content-Type: multipart/form-data; "
+    "boundary=---------------------------1234567890\r\n"
+    "Content-Length: 1024\r\n\r\n";
+
+/* Byte-at-a-time reference implementations to compare against */
+static char *refStrchr(const char *s, int c)
+{
+    for (; *s != (char)c; s++)
+    {
+        if ('\0' == *s)
+        {
+            return NULL;
+        }
+    }
+    return (char *)s;
+}
+
+static char *refStrrchr(const char *s, int c)
+{
+    char *r = NULL;
+
+    do
+    {
+        if (*s == (char)c)
+        {
+            r = (char *)s;
+        }
+    }
+    while (*s++ != '\0');
+    return r;
+}
+
+static void *refMemchr(const void *cs, int c, int n)
+{
+    const uchar *cp = cs;
+
+    for (; n > 0; cp++, n--)
+    {
+        if (*cp == (uchar)c)
+        {
+            return (void *)cp;
+        }
+    }
+    return NULL;
+}
+
+static int refStrnlen(const char *s, uint len)
+{
+    int n = 0;
+
+    while (n < len && s[n] != '\0')
+    {
+        n++;
+    }
+    return n;
+}
+
+static char *refStrstr(const char *cs, const char *ct)
+{
+    int i;
+
+    for (;; cs++)
+    {
+        for (i = 0; ct[i] != '\0' && cs[i] == ct[i]; i++)
+            ;
+        if ('\0' == ct[i])
+        {
+            return (char *)cs;
+        }
+        if ('\0' == *cs)
+        {
+            return NULL;
+        }
+    }
+}
+
+/**
+ * Checks the word-at-a-time search routines against the reference loops
+ * at every starting alignment and a range of lengths.
+ * @return TRUE if every result matches
+ */
+static bool stringScanMatches(void)
+{
+    char buf[sizeof(httphdrs) + 8];
+    char *s;
+    int off, len, c;
+
+    for (off = 0; off < 8; off++)
+    {
+        s = buf + off;
+        for (len = 0; len < 40; len++)
+        {
+            memcpy(s, httphdrs, len);
+            s[len] = '\0';
+            for (c = 0; c < 128; c += 13)
+            {
+                if ((strchr(s, c) != refStrchr(s, c))
+                    || (strrchr(s, c) != refStrrchr(s, c))
+                    || (memchr(s, c, len) != refMemchr(s, c, len))
+                    || (strnlen(s, c) != refStrnlen(s, c)))
+                {
+                    return FALSE;
+                }
+            }
+        }
+    }
+
+    /* Periodic and near-miss needles exercise the Two-Way shifts */
+    if ((strstr("aaaaaaaaab", "aaab") != refStrstr("aaaaaaaaab", "aaab"))
+        || (strstr("abababac", "ababac") !=
+            refStrstr("abababac", "ababac"))
+        || (NULL != strstr("abababab", "ababac"))
+        || (NULL != strstr("abc", "abcd"))
+        || (strstr(httphdrs, "boundary=") !=
+            refStrstr(httphdrs, "boundary="))
+        || (strstr(httphdrs, "\r\n\r\n") !=
+            refStrstr(httphdrs, "\r\n\r\n")))
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Times the library and reference search routines over an HTTP header
+ * buffer, reporting the CPU cycles each consumed.
+ */
+static void stringScanBench(void)
+{
+    ulong start, lib, ref;
+    int i;
+
+    start = clkcount();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        strstr(httphdrs, "boundary=");
+        strchr(httphdrs, ';');
+        memchr(httphdrs, '\n', sizeof(httphdrs));
+        strnlen(httphdrs, sizeof(httphdrs));
+    }
+    lib = clkcount() - start;
+
+    start = clkcount();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        refStrstr(httphdrs, "boundary=");
+        refStrchr(httphdrs, ';');
+        refMemchr(httphdrs, '\n', sizeof(httphdrs));
+        refStrnlen(httphdrs, sizeof(httphdrs));
+    }
+    ref = clkcount() - start;
+
+    printf("    %d header scans: libxc %u cycles, byte loop %u cycles\n",
+           BENCH_ROUNDS, lib, ref);
+}
 
 /**
  * Tests the string.h header in the Xinu Standard Library.
@@ -123,6 +292,10 @@ thread test_libString(bool verbose)
     s2 = memchr(sI, 'c', 6) + 1;
     failif((('c' != *s1) || ('d' != *s2)), "");
 
+    /* word-at-a-time scanning against reference byte loops */
+    testPrint(verbose, "Word scans match byte loops");
+    failif(!stringScanMatches(), "");
+
     /* memset */
     testPrint(verbose, "Memory set");
     char sJ[6] = "ABCDE";
@@ -130,6 +303,11 @@ thread test_libString(bool verbose)
     s1 = memset(sJ, 'F', 3);
     failif(((0 != memcmp(sJ, "FFFDE", 5)) || (s1 != sJ)), "");
 
+    if (verbose)
+    {
+        stringScanBench();
+    }
+
     if (passed)
     {
         testPass(TRUE, "");
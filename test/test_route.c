@@ -0,0 +1,502 @@
+/**
+ * @file     test_route.c
+ * @provides test_route
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <arp.h>
+#include <clock.h>
+#include <device.h>
+#include <ethernet.h>
+#include <ethloop.h>
+#include <icmp.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <memory.h>
+#include <network.h>
+#include <platform.h>
+#include <route.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <testsuite.h>
+#include <thread.h>
+
+#define RT_BENCH_PREFIXES  10000
+#define RT_BENCH_LOOKUPS   10000
+#define RT_BENCH_SWEEPS    50
+#define RT_BENCH_FRAMES    5000
+#define RT_FRAME_LEN       60
+
+static void setroute(struct rtEntry *, uchar, uchar, uchar, ushort);
+static void setip(struct netaddr *, uchar, uchar, uchar, uchar);
+static void lookupBench(void);
+#if defined(ELOOP) && defined(ELOOP1)
+static bool forwardTest(bool);
+#endif
+
+/**
+ * Tests longest prefix match route lookup.
+ * @return OK when testing is complete
+ */
+thread test_route(bool verbose)
+{
+    bool passed = TRUE;
+    struct rtTrie trie;
+    struct rtEntry dflt, net8, net16, net24, host, dup16;
+    struct netaddr ip, mask, gate;
+    struct rtCache cache;
+    struct netif nif;
+    struct packet *pkt;
+    struct icmpPkt *icmp;
+    struct ipv4Pkt *quoted;
+    uint gen;
+    int i;
+
+    bzero(&trie, sizeof(struct rtTrie));
+    setroute(&dflt, 0, 0, 0, 0);
+    setroute(&net8, 10, 0, 0, 8);
+    setroute(&net16, 10, 1, 0, 16);
+    setroute(&net24, 10, 1, 2, 24);
+    setroute(&host, 10, 1, 2, 32);
+    host.dst.addr[3] = 3;
+    setroute(&dup16, 10, 1, 0, 16);
+
+    /* Insert out of order so prefixes are split and pushed down */
+    testPrint(verbose, "Insert routes");
+    failif(((SYSERR == rtTrieInsert(&trie, &net24))
+            || (SYSERR == rtTrieInsert(&trie, &host))
+            || (SYSERR == rtTrieInsert(&trie, &net8))
+            || (SYSERR == rtTrieInsert(&trie, &dflt))
+            || (SYSERR == rtTrieInsert(&trie, &net16))
+            || (SYSERR == rtTrieInsert(&trie, &dup16))), "");
+
+    testPrint(verbose, "Longest prefix wins");
+    setip(&ip, 10, 1, 2, 3);
+    failif((&host != rtTrieLookup(&trie, &ip)), "");
+
+    testPrint(verbose, "Shorter prefixes match");
+    setip(&ip, 10, 1, 2, 4);
+    passed = passed && (&net24 == rtTrieLookup(&trie, &ip));
+    setip(&ip, 10, 1, 3, 1);
+    passed = passed && (&net16 == rtTrieLookup(&trie, &ip));
+    setip(&ip, 10, 2, 0, 1);
+    passed = passed && (&net8 == rtTrieLookup(&trie, &ip));
+    setip(&ip, 192, 168, 1, 1);
+    passed = passed && (&dflt == rtTrieLookup(&trie, &ip));
+    failif(!passed, "");
+
+    testPrint(verbose, "Remove route");
+    rtTrieRemove(&trie, &net24, NULL);
+    rtTrieRemove(&trie, &host, NULL);
+    setip(&ip, 10, 1, 2, 3);
+    failif((&net16 != rtTrieLookup(&trie, &ip)), "");
+
+    testPrint(verbose, "Remove route with replacement");
+    rtTrieRemove(&trie, &net16, &dup16);
+    failif((&dup16 != rtTrieLookup(&trie, &ip)), "");
+
+    testPrint(verbose, "Remove all routes");
+    rtTrieRemove(&trie, &dup16, NULL);
+    rtTrieRemove(&trie, &net8, NULL);
+    rtTrieRemove(&trie, &dflt, NULL);
+    failif(((NULL != trie.root) || (NULL != rtTrieLookup(&trie, &ip))),
+           "");
+
+    rtTrieDestroy(&trie);
+
+    /* Destination cache against the live route table */
+    bzero(&cache, sizeof(struct rtCache));
+    bzero(&nif, sizeof(struct netif));
+    nif.mtu = 1500;
+    setip(&ip, 10, 9, 0, 0);
+    setip(&mask, 255, 255, 0, 0);
+    rtAdd(&ip, NULL, &mask, &nif);
+
+    testPrint(verbose, "Destination cache fill");
+    setip(&ip, 10, 9, 1, 1);
+    failif(((SYSERR == rtCacheLookup(&cache, &ip)) || (cache.nif != &nif)
+            || !netaddrequal(&cache.nxthop, &ip)), "");
+
+    testPrint(verbose, "Destination cache reuse");
+    gen = cache.gen;
+    failif(((SYSERR == rtCacheLookup(&cache, &ip))
+            || (cache.gen != gen) || (rtcachegen != gen)), "");
+
+    testPrint(verbose, "Destination cache route change");
+    setip(&ip, 10, 9, 1, 0);
+    setip(&mask, 255, 255, 255, 0);
+    setip(&gate, 10, 9, 0, 1);
+    rtAdd(&ip, &gate, &mask, &nif);
+    setip(&ip, 10, 9, 1, 1);
+    failif(((cache.gen == rtcachegen)
+            || (SYSERR == rtCacheLookup(&cache, &ip))
+            || !netaddrequal(&cache.nxthop, &gate)), "");
+
+    /* Path MTU learned for 10.9.1.1, cached along with the route */
+    testPrint(verbose, "Path MTU lowered by report");
+    failif(((OK != rtPmtuUpdate(&ip, 1400, 1500))
+            || (cache.gen == rtcachegen)
+            || (SYSERR == rtCacheLookup(&cache, &ip))
+            || (1400 != cache.mtu) || (0 == cache.mtuexpires)), "");
+
+    testPrint(verbose, "Path MTU only goes down");
+    failif(((SYSERR != rtPmtuUpdate(&ip, 1450, 1500))
+            || (1400 != rtPmtuLookup(&ip, nif.mtu, &gen))
+            || (1000 != rtPmtuLookup(&ip, 1000, &gen))), "");
+
+    testPrint(verbose, "Path MTU guessed from plateau");
+    failif(((OK != rtPmtuUpdate(&ip, 0, 1400))
+            || (1006 != rtPmtuLookup(&ip, nif.mtu, &gen))), "");
+
+    testPrint(verbose, "Path MTU ages out");
+    rtCacheLookup(&cache, &ip);
+    for (i = 0; i < RT_NPMTU; i++)
+    {
+        if (netaddrequal(&rtpmtutab[i].dst, &ip))
+        {
+            rtpmtutab[i].expires = clktime;
+        }
+    }
+    cache.mtuexpires = clktime;
+    failif(((SYSERR == rtCacheLookup(&cache, &ip))
+            || (nif.mtu != cache.mtu) || (0 != cache.mtuexpires)), "");
+
+    /* Router reports a 1300 byte hop for a datagram to 10.9.1.2 */
+    testPrint(verbose, "ICMP fragmentation needed");
+    setip(&ip, 10, 9, 1, 2);
+    pkt = netGetbuf();
+    if (SYSERR == (int)pkt)
+    {
+        failif(TRUE, "No packet buffer");
+    }
+    else
+    {
+        pkt->len = IPv4_HDR_LEN + ICMP_HEADER_LEN + 4 + IPv4_HDR_LEN;
+        pkt->curr -= pkt->len;
+        pkt->linkhdr = pkt->curr;
+        pkt->nethdr = pkt->curr;
+        pkt->curr += IPv4_HDR_LEN;
+        icmp = (struct icmpPkt *)pkt->curr;
+        icmp->type = ICMP_UNREACH;
+        icmp->code = ICMP_FOFF_DFSET;
+        icmp->chksum = 0;
+        *((ushort *)icmp->data) = 0;
+        *((ushort *)(icmp->data + 2)) = hs2net(1300);
+        quoted = (struct ipv4Pkt *)(icmp->data + 4);
+        bzero(quoted, IPv4_HDR_LEN);
+        quoted->ver_ihl = (IPv4_VERSION << 4) | IPv4_MIN_IHL;
+        quoted->len = hs2net(1500);
+        quoted->flags_froff = hs2net(IPv4_FLAG_DF);
+        quoted->proto = IPv4_PROTO_TCP;
+        memcpy(quoted->dst, ip.addr, IPv4_ADDR_LEN);
+        icmpRecv(pkt);
+        failif((1300 != rtPmtuLookup(&ip, nif.mtu, &gen)), "");
+    }
+    for (i = 0; i < RT_NPMTU; i++)
+    {
+        if (netaddrequal(&rtpmtutab[i].dst, &ip))
+        {
+            rtpmtutab[i].dst.type = NULL;
+        }
+    }
+
+    testPrint(verbose, "Destination cache route removed");
+    setip(&ip, 10, 9, 1, 0);
+    rtRemove(&ip);
+    setip(&ip, 10, 9, 0, 0);
+    rtRemove(&ip);
+    setip(&ip, 10, 9, 1, 1);
+    failif(((SYSERR != rtCacheLookup(&cache, &ip)) && (cache.nif == &nif)),
+           "");
+
+#if defined(ELOOP) && defined(ELOOP1)
+    passed = forwardTest(verbose) && passed;
+#endif
+
+    if (verbose)
+    {
+        lookupBench();
+    }
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+
+    return OK;
+}
+
+static void setip(struct netaddr *ip, uchar a, uchar b, uchar c, uchar d)
+{
+    ip->type = NETADDR_IPv4;
+    ip->len = IPv4_ADDR_LEN;
+    ip->addr[0] = a;
+    ip->addr[1] = b;
+    ip->addr[2] = c;
+    ip->addr[3] = d;
+}
+
+static void setroute(struct rtEntry *rtptr, uchar a, uchar b, uchar c,
+                     ushort masklen)
+{
+    bzero(rtptr, sizeof(struct rtEntry));
+    setip(&rtptr->dst, a, b, c, 0);
+    rtptr->masklen = masklen;
+    rtptr->state = RT_USED;
+}
+
+/**
+ * Compare trie lookup against a scan of every route, as rtLookup did
+ * over the old fixed table, with 10k synthetic prefixes of /8 to /32.
+ */
+static void lookupBench(void)
+{
+    struct rtTrie trie;
+    struct rtEntry *routes;
+    struct rtEntry *best;
+    struct rtEntry *found;
+    struct netaddr *addrs;
+    struct netaddr masked;
+    ulong start, lookup, sweep;
+    uint size;
+    int i, j, wrong;
+
+    size = RT_BENCH_PREFIXES * sizeof(struct rtEntry);
+    routes = memget(size);
+    addrs = memget(RT_BENCH_LOOKUPS * sizeof(struct netaddr));
+    if ((SYSERR == (int)routes) || (SYSERR == (int)addrs))
+    {
+        printf("    No memory for benchmark\n");
+        return;
+    }
+    bzero(&trie, sizeof(struct rtTrie));
+    srand(RT_BENCH_PREFIXES);
+
+    for (i = 0; i < RT_BENCH_PREFIXES; i++)
+    {
+        bzero(&routes[i], sizeof(struct rtEntry));
+        routes[i].masklen = 8 + (rand() % 25);
+        setip(&routes[i].dst, rand(), rand(), rand(), rand());
+        setip(&routes[i].mask, 0, 0, 0, 0);
+        for (j = 0; j < routes[i].masklen; j++)
+        {
+            routes[i].mask.addr[j / 8] |= 0x80 >> (j % 8);
+        }
+        netaddrmask(&routes[i].dst, &routes[i].mask);
+        routes[i].state = RT_USED;
+        if (SYSERR == rtTrieInsert(&trie, &routes[i]))
+        {
+            printf("    No memory for trie\n");
+            break;
+        }
+    }
+
+    /* Half the addresses fall inside a known prefix */
+    for (i = 0; i < RT_BENCH_LOOKUPS; i++)
+    {
+        if (i & 0x01)
+        {
+            setip(&addrs[i], rand(), rand(), rand(), rand());
+        }
+        else
+        {
+            netaddrcpy(&addrs[i], &routes[rand() % RT_BENCH_PREFIXES].dst);
+            addrs[i].addr[3] |= rand() & 0x01;
+        }
+    }
+
+    start = clkcount();
+    for (i = 0; i < RT_BENCH_LOOKUPS; i++)
+    {
+        rtTrieLookup(&trie, &addrs[i]);
+    }
+    lookup = clkcount() - start;
+
+    wrong = 0;
+    start = clkcount();
+    for (i = 0; i < RT_BENCH_SWEEPS; i++)
+    {
+        best = NULL;
+        for (j = 0; j < RT_BENCH_PREFIXES; j++)
+        {
+            netaddrcpy(&masked, &addrs[i]);
+            netaddrmask(&masked, &routes[j].mask);
+            if (netaddrequal(&masked, &routes[j].dst)
+                && ((NULL == best) || (best->masklen < routes[j].masklen)))
+            {
+                best = &routes[j];
+            }
+        }
+        found = rtTrieLookup(&trie, &addrs[i]);
+        if ((found != best) && ((NULL == found) || (NULL == best)
+                                || (found->masklen != best->masklen)))
+        {
+            wrong++;
+        }
+    }
+    sweep = clkcount() - start;
+
+    printf("    %d prefixes: trie %u cycles/lookup, scan %u cycles/lookup\n",
+           RT_BENCH_PREFIXES, lookup / RT_BENCH_LOOKUPS,
+           sweep / RT_BENCH_SWEEPS);
+    if (wrong > 0)
+    {
+        printf("    %d of %d lookups disagree with scan\n", wrong,
+               RT_BENCH_SWEEPS);
+    }
+
+    rtTrieDestroy(&trie);
+    memfree(addrs, RT_BENCH_LOOKUPS * sizeof(struct netaddr));
+    memfree(routes, size);
+}
+
+#if defined(ELOOP) && defined(ELOOP1)
+static struct netif *upnetif(int dev, uchar subnet)
+{
+    struct netaddr ip, mask;
+    int i;
+
+    setip(&ip, 10, 3, subnet, 1);
+    setip(&mask, 255, 255, 255, 0);
+    if ((SYSERR == open(dev)) || (SYSERR == netUp(dev, &ip, &mask, NULL)))
+    {
+        return NULL;
+    }
+    for (i = 0; i < NNETIF; i++)
+    {
+        if ((NET_ALLOC == netiftab[i].state) && (dev == netiftab[i].dev))
+        {
+            return &netiftab[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Forward between two loopback interfaces, 10.3.1.0/24 on ELOOP and
+ * 10.3.2.0/24 on ELOOP1, with the next hop already in the ARP table.
+ */
+static bool forwardTest(bool verbose)
+{
+    bool passed = TRUE;
+    struct netif *in, *out;
+    struct arpEntry *entry;
+    struct etherPkt *ether;
+    struct ipv4Pkt *ip;
+    uchar frame[RT_FRAME_LEN];
+    uchar buf[ELOOP_BUFSIZE];
+    uint nfast, nout, sent, wait;
+    ulong start, cycles, ms;
+    irqmask im;
+
+    testPrint(verbose, "Forward test initialization");
+    in = upnetif(ELOOP, 1);
+    out = upnetif(ELOOP1, 2);
+    entry = NULL;
+    if ((NULL != in) && (NULL != out))
+    {
+        im = disable();
+        entry = arpAlloc();
+        if (SYSERR != (int)entry)
+        {
+            entry->state = ARP_RESOLVED;
+            entry->nif = out;
+            setip(&entry->praddr, 10, 3, 2, 2);
+            entry->hwaddr.type = NETADDR_ETHERNET;
+            entry->hwaddr.len = ETH_ADDR_LEN;
+            memset(entry->hwaddr.addr, 0x22, ETH_ADDR_LEN);
+            entry->expires = clktime + ARP_TTL_RESOLVED;
+            arpHashInsert(entry);
+        }
+        restore(im);
+    }
+    if ((NULL == in) || (NULL == out) || (SYSERR == (int)entry))
+    {
+        failif(TRUE, "");
+        close(ELOOP);
+        close(ELOOP1);
+        return FALSE;
+    }
+    failif(FALSE, "");
+
+    /* UDP datagram from 10.3.1.2 to 10.3.2.2, padded to minimum frame */
+    bzero(frame, RT_FRAME_LEN);
+    ether = (struct etherPkt *)frame;
+    memcpy(ether->dst, in->hwaddr.addr, ETH_ADDR_LEN);
+    memset(ether->src, 0x11, ETH_ADDR_LEN);
+    ether->type = hs2net(ETHER_TYPE_IPv4);
+    ip = (struct ipv4Pkt *)ether->data;
+    ip->ver_ihl = (IPv4_VERSION << 4) | IPv4_MIN_IHL;
+    ip->len = hs2net(IPv4_HDR_LEN + 8);
+    ip->ttl = IPv4_TTL;
+    ip->proto = IPv4_PROTO_UDP;
+    ip->src[0] = 10;
+    ip->src[1] = 3;
+    ip->src[2] = 1;
+    ip->src[3] = 2;
+    ip->dst[0] = 10;
+    ip->dst[1] = 3;
+    ip->dst[2] = 2;
+    ip->dst[3] = 2;
+    ip->chksum = netChksum((uchar *)ip, IPv4_HDR_LEN);
+
+    testPrint(verbose, "Forward fast path");
+    nfast = rtnfwdfast;
+    control(ELOOP1, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+    write(ELOOP, frame, RT_FRAME_LEN);
+    control(ELOOP1, ELOOP_CTRL_GETHOLD, (long)buf, ELOOP_BUFSIZE);
+    ether = (struct etherPkt *)buf;
+    ip = (struct ipv4Pkt *)ether->data;
+    failif(((rtnfwdfast != nfast + 1)
+            || (0 != memcmp(ether->dst, entry->hwaddr.addr, ETH_ADDR_LEN))
+            || (IPv4_TTL - 1 != ip->ttl)
+            || (0 != netChksum((uchar *)ip, IPv4_HDR_LEN))), "");
+
+    /* Forwarding rate, with the egress dropping what it is given */
+    if (verbose)
+    {
+        control(ELOOP1, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_DROPALL, NULL);
+        nfast = rtnfwdfast;
+        nout = out->nout;
+        start = clkcount();
+        for (sent = 0; sent < RT_BENCH_FRAMES;)
+        {
+            if (SYSERR == write(ELOOP, frame, RT_FRAME_LEN))
+            {
+                yield();
+                continue;
+            }
+            sent++;
+        }
+        for (wait = 0; (wait < 100) && (out->nout - nout < sent); wait++)
+        {
+            sleep(10);
+        }
+        cycles = clkcount() - start;
+        ms = cycles / (platform.clkfreq / 1000);
+        if (0 == ms)
+        {
+            ms = 1;
+        }
+        printf("    Forwarded %u of %u frames (%u fast) in %u ms: %u pps\n",
+               out->nout - nout, sent, rtnfwdfast - nfast, ms,
+               ((out->nout - nout) * 1000) / ms);
+        control(ELOOP1, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_DROPALL, NULL);
+    }
+
+    arpFree(entry);
+    netDown(ELOOP);
+    netDown(ELOOP1);
+    close(ELOOP);
+    close(ELOOP1);
+    return passed;
+}
+#endif                          /* ELOOP && ELOOP1 */
@@ -0,0 +1,1125 @@
+/**
+ * @file     test_tcp.c
+ * @provides test_tcp
+ *
+ * $Id$
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <clock.h>
+#include <device.h>
+#include <memory.h>
+#include <network.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tcp.h>
+#include <testsuite.h>
+#include <thread.h>
+
+#if NTCP
+#define TCP_BENCH_LOOKUPS  2000
+#define TCP_TEST_SEQ       0xFFFFFF00   /* Wraps during the queue tests */
+#define TCP_TEST_ROUNDS    8            /* Round trips of paced transfer */
+#define TCP_BENCH_PORT     9000
+#define TCP_BENCH_CHUNK    4096
+#define TCP_BENCH_KBYTES   2048         /* Sent through ethloop */
+
+static void setip(struct netaddr *, uchar);
+static bool inCheck(struct tcb *, uchar *, uint);
+static void ackSeg(struct tcb *, struct packet *, tcpseq,
+                   struct tcpRange *, uint);
+static void synSeg(struct tcb *, struct packet *, int);
+static void dataSeg(struct tcb *, struct packet *, tcpseq, uint, uchar);
+static uint windowRounds(struct tcb *, struct packet *, uint);
+static struct tcb *synRecv(struct tcb *, struct netaddr *, ushort);
+static bool timewaitSeg(struct packet *, struct netaddr *, struct netaddr *,
+                        ushort, tcpseq, uchar);
+static void demuxBench(int);
+#ifdef ELOOP
+static thread benchWriter(int, uint, semaphore);
+static ulong benchTime(void);
+static void loopBench(void);
+#endif
+#endif
+
+/**
+ * Tests TCP connection demultiplexing, the receive queue, congestion
+ * control, selective acknowledgement, window scaling, buffer sizing,
+ * delayed acknowledgement, Nagle coalescing, listening sockets,
+ * TIME-WAIT, block copies through read and write, and sendfile.
+ * @return OK when testing is complete
+ */
+thread test_tcp(bool verbose)
+{
+#if NTCP
+    bool passed = TRUE;
+    struct tcpHashTab *tab;
+    struct tcpHashEnt any, bound, conn;
+    struct netaddr ipa, ipb, ipc;
+    struct tcb *tcbptr, *lsnptr, *twptr;
+    struct tcb *conns[3];
+    struct packet *pkt;
+    struct tcpRange blocks[2];
+    uchar data[512];
+    uchar back[512];
+    uint i, fixed, growing, acks, nfree;
+    device *devptr;
+    int dev;
+
+    tab = memget(sizeof(struct tcpHashTab));
+    bzero(tab, sizeof(struct tcpHashTab));
+    setip(&ipa, 1);
+    setip(&ipb, 2);
+    setip(&ipc, 3);
+
+    /* Listener on port 80 for any remote */
+    bzero(&any, sizeof(struct tcpHashEnt));
+    any.localpt = 80;
+    netaddrcpy(&any.localip, &ipa);
+    tcpHashInsert(tab, &any);
+
+    /* Listener on port 80 for remote port 5000 only */
+    bzero(&bound, sizeof(struct tcpHashEnt));
+    bound.localpt = 80;
+    bound.remotept = 5000;
+    netaddrcpy(&bound.localip, &ipa);
+    tcpHashInsert(tab, &bound);
+
+    /* Connection from ipb:5001 to port 80 */
+    bzero(&conn, sizeof(struct tcpHashEnt));
+    conn.localpt = 80;
+    conn.remotept = 5001;
+    netaddrcpy(&conn.localip, &ipa);
+    netaddrcpy(&conn.remoteip, &ipb);
+    tcpHashInsert(tab, &conn);
+
+    testPrint(verbose, "Demux exact 4-tuple");
+    failif((&conn != tcpHashLookup(tab, 80, 5001, &ipa, &ipb)), "");
+
+    testPrint(verbose, "Demux listener bound to remote port");
+    failif((&bound != tcpHashLookup(tab, 80, 5000, &ipa, &ipb)), "");
+
+    testPrint(verbose, "Demux listener on local port");
+    failif(((&any != tcpHashLookup(tab, 80, 6000, &ipa, &ipb))
+            || (&any != tcpHashLookup(tab, 80, 5001, &ipa, &ipc))), "");
+
+    testPrint(verbose, "Demux no match");
+    failif(((NULL != tcpHashLookup(tab, 81, 5001, &ipa, &ipb))
+            || (NULL != tcpHashLookup(tab, 80, 5001, &ipc, &ipb))), "");
+
+    testPrint(verbose, "Demux after connection removed");
+    tcpHashRemove(tab, &conn);
+    tcpHashRemove(tab, &conn);
+    failif((&any != tcpHashLookup(tab, 80, 5001, &ipa, &ipb)), "");
+
+    memfree(tab, sizeof(struct tcpHashTab));
+
+    /* Receive queue, wrapping around the end of the input buffer */
+    tcbptr = memget(sizeof(struct tcb));
+    bzero(tcbptr, sizeof(struct tcb));
+    tcpBufAlloc(tcbptr);
+    tcbptr->istart = tcbptr->ilen - 250;
+    tcbptr->rcvnxt = TCP_TEST_SEQ;
+    tcbptr->rcvwnd = TCP_TEST_SEQ + tcbptr->ilen;
+    for (i = 0; i < sizeof(data); i++)
+    {
+        data[i] = i * 7;
+    }
+
+    testPrint(verbose, "Receive in order");
+    failif(((100 != tcpRecvQueue(tcbptr, TCP_TEST_SEQ, data, 100))
+            || (TCP_TEST_SEQ + 100 != tcbptr->rcvnxt)
+            || (0 != tcbptr->nooo) || !inCheck(tcbptr, data, 100)), "");
+
+    testPrint(verbose, "Receive past a gap");
+    failif(((0 != tcpRecvQueue(tcbptr, TCP_TEST_SEQ + 200, &data[200], 100))
+            || (0 != tcpRecvQueue(tcbptr, TCP_TEST_SEQ + 400,
+                                  &data[400], 100))
+            || (TCP_TEST_SEQ + 100 != tcbptr->rcvnxt)
+            || (100 != tcbptr->icount) || (2 != tcbptr->nooo)), "");
+
+    testPrint(verbose, "Receive joining held ranges");
+    failif(((0 != tcpRecvQueue(tcbptr, TCP_TEST_SEQ + 250, &data[250], 200))
+            || (1 != tcbptr->nooo)
+            || (TCP_TEST_SEQ + 200 != tcbptr->ooo[0].start)
+            || (TCP_TEST_SEQ + 500 != tcbptr->ooo[0].end)), "");
+
+    testPrint(verbose, "Receive filling the gap");
+    failif(((400 != tcpRecvQueue(tcbptr, TCP_TEST_SEQ + 50, &data[50], 160))
+            || (TCP_TEST_SEQ + 500 != tcbptr->rcvnxt)
+            || (0 != tcbptr->nooo) || !inCheck(tcbptr, data, 500)), "");
+
+    testPrint(verbose, "Receive duplicate and past window");
+    tcbptr->rcvwnd = TCP_TEST_SEQ + 510;
+    failif(((0 != tcpRecvQueue(tcbptr, TCP_TEST_SEQ + 100, &data[100], 100))
+            || (0 != tcpRecvQueue(tcbptr, TCP_TEST_SEQ + 510, &data[10], 2))
+            || (10 != tcpRecvQueue(tcbptr, TCP_TEST_SEQ + 500, data, 12))
+            || (TCP_TEST_SEQ + 510 != tcbptr->rcvnxt)
+            || (510 != tcbptr->icount) || (0 != tcbptr->nooo)), "");
+
+    /* Congestion control, for 10 segments in flight that go nowhere */
+    tcpBufFree(tcbptr);
+    bzero(tcbptr, sizeof(struct tcb));
+    tcpBufAlloc(tcbptr);
+    tcbptr->state = TCP_ESTAB;
+    tcbptr->writers = semcreate(0);
+    tcbptr->peermss = 1000;
+    tcbptr->sndmss = 1000;
+    tcbptr->snduna = 1000;
+    tcbptr->sndnxt = 11000;
+    tcbptr->ocount = 14000;
+    tcbptr->sndwnd = 20000;
+    tcbptr->sndcwn = 10000;
+    tcbptr->sndsst = TCP_MAX_WND;
+    /* Keep the retransmission timer well clear of the test */
+    tcbptr->rxttime = TCP_RXT_MAXTIME;
+    tcbptr->sndrtd = 1 << 30;
+    pkt = netGetbuf();
+
+    testPrint(verbose, "Fast retransmit on third dup ACK");
+    ackSeg(tcbptr, pkt, 1000, NULL, 0);
+    ackSeg(tcbptr, pkt, 1000, NULL, 0);
+    failif((tcbptr->sndflg & TCP_FLG_RECOVER), "Early");
+    ackSeg(tcbptr, pkt, 1000, NULL, 0);
+    failif((!(tcbptr->sndflg & TCP_FLG_RECOVER)
+            || (5000 != tcbptr->sndsst) || (8000 != tcbptr->sndcwn)
+            || (11000 != tcbptr->recover)), "");
+
+    testPrint(verbose, "Fast recovery inflates and deflates");
+    ackSeg(tcbptr, pkt, 1000, NULL, 0);
+    failif((9000 != tcbptr->sndcwn), "Inflate");
+    ackSeg(tcbptr, pkt, 3000, NULL, 0);
+    failif((!(tcbptr->sndflg & TCP_FLG_RECOVER)
+            || (8000 != tcbptr->sndcwn)), "Partial ACK");
+    ackSeg(tcbptr, pkt, 11000, NULL, 0);
+    failif(((tcbptr->sndflg & TCP_FLG_RECOVER)
+            || (2000 != tcbptr->sndcwn)), "Full ACK");
+
+    testPrint(verbose, "Dup ACKs and fast retransmit counted");
+    failif(((4 != tcbptr->instr.dupacks) || (1 != tcbptr->instr.fastrxts)
+            || (2 != tcbptr->instr.ntrace)
+            || (TCP_TRC_FASTRXT != tcbptr->instr.trace[0].event)
+            || (8000 != tcbptr->instr.trace[0].cwnd)
+            || (5000 != tcbptr->instr.trace[0].ssthresh)
+            || (TCP_TRC_RECOVER != tcbptr->instr.trace[1].event)
+            || (2000 != tcbptr->instr.trace[1].cwnd)), "");
+
+    testPrint(verbose, "Round trips counted by length");
+    tcpInstrRtt(tcbptr, 500);
+    tcpInstrRtt(tcbptr, 20000);
+    tcpInstrRtt(tcbptr, 5000000);
+    failif(((3 != tcbptr->instr.rttsamples)
+            || (1 != tcbptr->instr.rtthist[0])
+            || (1 != tcbptr->instr.rtthist[3])
+            || (1 != tcbptr->instr.rtthist[TCP_NRTTHIST - 1])
+            || (500 != tcbptr->instr.rttmin)
+            || (5000000 != tcbptr->instr.rttmax)
+            || (5 != tcbptr->instr.ntrace)), "");
+
+    testPrint(verbose, "Slow start and congestion avoidance");
+    tcbptr->sndnxt = 15000;
+    ackSeg(tcbptr, pkt, 13000, NULL, 0);
+    failif((3000 != tcbptr->sndcwn), "Slow start");
+    tcbptr->sndcwn = tcbptr->sndsst;
+    ackSeg(tcbptr, pkt, 14000, NULL, 0);
+    failif((5201 != tcbptr->sndcwn), "Congestion avoidance");
+
+    testPrint(verbose, "Fast retransmit again once recovery point ACKed");
+    tcbptr->recover = 14000;
+    ackSeg(tcbptr, pkt, 14000, NULL, 0);
+    ackSeg(tcbptr, pkt, 14000, NULL, 0);
+    ackSeg(tcbptr, pkt, 14000, NULL, 0);
+    failif((!(tcbptr->sndflg & TCP_FLG_RECOVER)
+            || (15000 != tcbptr->recover)), "");
+
+    /* Selective acknowledgement, peer holding 3000-5000 and 7000-8000 */
+    tcbptr->sndflg = NULL;
+    tcbptr->rcvflg = TCP_FLG_SACK;
+    tcbptr->dupacks = 0;
+    tcbptr->snduna = 1000;
+    tcbptr->sndnxt = 11000;
+    tcbptr->ocount = 10000;
+    tcbptr->sndcwn = 10000;
+    tcbptr->recover = 0;
+    tcbptr->rxtnxt = 0;
+    blocks[0].start = 3000;
+    blocks[0].end = 5000;
+    blocks[1].start = 7000;
+    blocks[1].end = 8000;
+
+    testPrint(verbose, "SACK blocks fill scoreboard");
+    ackSeg(tcbptr, pkt, 1000, blocks, 2);
+    ackSeg(tcbptr, pkt, 1000, &blocks[1], 1);
+    failif(((2 != tcbptr->nsacked) || (3000 != tcbptr->sacked[0].start)
+            || (8000 != tcbptr->sacked[1].end)), "");
+
+    testPrint(verbose, "SACK resends only the holes");
+    ackSeg(tcbptr, pkt, 1000, blocks, 2);
+    failif(((2000 != tcbptr->rxtnxt) || (0 != tcbptr->sackrxt)),
+           "Fast retransmit");
+    ackSeg(tcbptr, pkt, 1000, blocks, 2);
+    ackSeg(tcbptr, pkt, 1000, blocks, 2);
+    ackSeg(tcbptr, pkt, 1000, blocks, 2);
+    failif(((7000 != tcbptr->rxtnxt) || (3000 != tcbptr->sackrxt)
+            || (8000 != tcbptr->sndcwn)), "Holes");
+    ackSeg(tcbptr, pkt, 1000, blocks, 2);
+    failif(((7000 != tcbptr->rxtnxt) || (9000 != tcbptr->sndcwn)),
+           "No holes left");
+
+    testPrint(verbose, "SACK scoreboard trimmed by ACK");
+    ackSeg(tcbptr, pkt, 4000, NULL, 0);
+    failif(((2 != tcbptr->nsacked) || (4000 != tcbptr->sacked[0].start)
+            || (7000 != tcbptr->rxtnxt)), "");
+
+    /* Window scaling, with a window that paces the transfer */
+    tcpTimerPurge(tcbptr, NULL);
+    semfree(tcbptr->writers);
+    tcpBufFree(tcbptr);
+    bzero(tcbptr, sizeof(struct tcb));
+    tcbptr->state = TCP_ESTAB;
+    tcbptr->writers = semcreate(0);
+    tcbptr->readers = semcreate(0);
+    tcbptr->rcvmss = 1000;
+    tcbptr->ilimit = TCP_IBLEN;
+    tcpBufAlloc(tcbptr);
+
+    testPrint(verbose, "Window scale from SYN options");
+    tcbptr->rcvwsc = 3;
+    synSeg(tcbptr, pkt, 16);
+    failif((!(tcbptr->rcvflg & TCP_FLG_WSCALE)
+            || (TCP_WSC_MAX != tcbptr->sndwsc) || (3 != tcbptr->rcvwsc)),
+           "Offered");
+    synSeg(tcbptr, pkt, -1);
+    failif(((tcbptr->rcvflg & TCP_FLG_WSCALE) || (0 != tcbptr->sndwsc)
+            || (0 != tcbptr->rcvwsc)), "Not offered");
+
+    testPrint(verbose, "Window scale applied to peer window");
+    tcbptr->sndwsc = 4;
+    tcbptr->snduna = 1000;
+    tcbptr->sndnxt = 1000;
+    tcbptr->sndwl2 = 1000;
+    tcbptr->sndwnd = 200000;
+    ackSeg(tcbptr, pkt, 1000, NULL, 0);
+    failif((200000 != tcbptr->sndwnd), "");
+
+    testPrint(verbose, "Window scale applied to our window");
+    tcbptr->rcvwsc = 3;
+    tcbptr->rcvnxt = TCP_TEST_SEQ;
+    tcbptr->rcvwnd = TCP_TEST_SEQ;
+    failif(((TCP_IBLEN >> 3) != tcpSendWindow(tcbptr))
+           || (TCP_TEST_SEQ + TCP_IBLEN != tcbptr->rcvwnd), "");
+
+    testPrint(verbose, "Input buffer grows when window is full");
+    fixed = windowRounds(tcbptr, pkt, TCP_TEST_ROUNDS);
+    failif((TCP_IBLEN != tcbptr->ilen), "Grew past limit");
+    tcbptr->ilimit = TCP_BUFLIM;
+    growing = windowRounds(tcbptr, pkt, TCP_TEST_ROUNDS);
+    failif(((TCP_BUFLIM != tcbptr->ilen) || (growing < fixed * 4)), "");
+    if (verbose)
+    {
+        printf("    %d round trips: %u KB with %u KB buffer, "
+               "%u KB growing to %u KB\n", TCP_TEST_ROUNDS,
+               fixed >> 10, TCP_IBLEN >> 10, growing >> 10,
+               TCP_BUFLIM >> 10);
+    }
+
+    testPrint(verbose, "Input buffer shrinks to lower limit");
+    tcbptr->ilimit = TCP_BUFMIN;
+    windowRounds(tcbptr, pkt, 1);
+    failif(((TCP_BUFMIN != tcbptr->ilen)
+            || ((TCP_BUFMIN >> 3) < tcpSendWindow(tcbptr))), "");
+
+    testPrint(verbose, "Output buffer grows keeping its data");
+    tcbptr->ostart = tcbptr->olen - 100;
+    tcbptr->ocount = tcbptr->olen;
+    for (i = 0; i < tcbptr->olen; i++)
+    {
+        tcbptr->out[(tcbptr->ostart + i) % tcbptr->olen] = i * 7;
+    }
+    i = tcbptr->olen;
+    tcbptr->olimit = TCP_BUFLIM;
+    failif((SYSERR == tcpBufGrowOut(tcbptr)), "");
+    failif(((i << 1 != tcbptr->olen) || (0 != tcbptr->ostart)
+            || ((uchar)(99 * 7) != tcbptr->out[99])
+            || ((uchar)(100 * 7) != tcbptr->out[100])
+            || ((uchar)((i - 1) * 7) != tcbptr->out[i - 1])), "Data");
+
+    /* Delayed ACK, with a delay long enough the timer stays out of it */
+    tcbptr->mutex = semcreate(1);
+    tcbptr->delack = TCP_DELACK_MAX;
+    tcbptr->rcvsegs = 0;
+    tcbptr->acksent = 0;
+
+    testPrint(verbose, "Delayed ACK for every second segment");
+    windowRounds(tcbptr, pkt, 2);
+    failif(((0 == tcbptr->acksent)
+            || (tcbptr->acksent * 2 > tcbptr->rcvsegs + 1)), "");
+    if (verbose)
+    {
+        printf("    %u ACKs for %u data segments\n", tcbptr->acksent,
+               tcbptr->rcvsegs);
+    }
+
+    testPrint(verbose, "Delayed ACK sent when delay runs out");
+    tcpSendDelack(tcbptr);
+    tcpSendWindow(tcbptr);
+    acks = tcbptr->acksent;
+    dataSeg(tcbptr, pkt, tcbptr->rcvnxt, 100, TCP_CTRL_ACK);
+    failif((!(tcbptr->sndflg & TCP_FLG_DELACK) || (acks != tcbptr->acksent)),
+           "Delayed");
+    tcpSendDelack(tcbptr);
+    failif(((tcbptr->sndflg & TCP_FLG_DELACK)
+            || (acks + 1 != tcbptr->acksent)), "Sent");
+
+    testPrint(verbose, "ACK at once for a gap");
+    acks = tcbptr->acksent;
+    dataSeg(tcbptr, pkt, tcbptr->rcvnxt + 200, 100, TCP_CTRL_ACK);
+    dataSeg(tcbptr, pkt, tcbptr->rcvnxt, 200, TCP_CTRL_ACK);
+    failif(((tcbptr->sndflg & TCP_FLG_DELACK)
+            || (acks + 2 != tcbptr->acksent)), "");
+
+    testPrint(verbose, "ACK at once for pushed data with window update");
+    dataSeg(tcbptr, pkt, tcbptr->rcvnxt, 100, TCP_CTRL_ACK | TCP_CTRL_PSH);
+    failif((!(tcbptr->sndflg & TCP_FLG_DELACK)
+            || (acks + 2 != tcbptr->acksent)), "No update");
+    tcbptr->istart = (tcbptr->istart + tcbptr->icount) % tcbptr->ilen;
+    tcbptr->icount = 0;
+    dataSeg(tcbptr, pkt, tcbptr->rcvnxt, 100, TCP_CTRL_ACK | TCP_CTRL_PSH);
+    failif(((tcbptr->sndflg & TCP_FLG_DELACK)
+            || (acks + 3 != tcbptr->acksent)), "Update");
+
+    testPrint(verbose, "ACK at once when delay is off");
+    tcbptr->delack = 0;
+    dataSeg(tcbptr, pkt, tcbptr->rcvnxt, 100, TCP_CTRL_ACK);
+    failif(((tcbptr->sndflg & TCP_FLG_DELACK)
+            || (acks + 4 != tcbptr->acksent)), "");
+
+    /* Nagle coalescing and corking, with a window that never fills */
+    tcbptr->sndflg = NULL;
+    tcbptr->peermss = 1000;
+    tcbptr->snduna = 1000;
+    tcbptr->sndnxt = 1000;
+    tcbptr->ostart = 0;
+    tcbptr->ocount = 0;
+    tcbptr->sndwnd = 20000;
+    tcbptr->sndcwn = 20000;
+    tcbptr->rxttime = TCP_RXT_MAXTIME;
+    bzero(tcbptr->seghist, sizeof(tcbptr->seghist));
+
+    testPrint(verbose, "Nagle sends small segment when idle");
+    tcbptr->ocount = 10;
+    tcpSendData(tcbptr);
+    failif((1010 != tcbptr->sndnxt), "");
+
+    testPrint(verbose, "Nagle holds small segment until ACK");
+    tcbptr->ocount = 30;
+    tcpSendData(tcbptr);
+    failif((1010 != tcbptr->sndnxt), "Held");
+    ackSeg(tcbptr, pkt, 1010, NULL, 0);
+    tcpSendData(tcbptr);
+    failif((1030 != tcbptr->sndnxt), "Sent");
+
+    testPrint(verbose, "Nagle sends full segments at once");
+    tcbptr->ocount += 2500;
+    tcpSendData(tcbptr);
+    failif((3030 != tcbptr->sndnxt), "");
+
+    testPrint(verbose, "No delay sends small segments at once");
+    tcbptr->sndflg |= TCP_FLG_NODELAY;
+    tcpSendData(tcbptr);
+    tcbptr->ocount += 10;
+    tcpSendData(tcbptr);
+    failif((3540 != tcbptr->sndnxt), "");
+
+    testPrint(verbose, "Cork holds small segment until uncorked");
+    ackSeg(tcbptr, pkt, 3540, NULL, 0);
+    tcbptr->sndflg &= ~TCP_FLG_NODELAY;
+    tcbptr->sndflg |= TCP_FLG_CORK;
+    tcbptr->ocount = 10;
+    tcpSendData(tcbptr);
+    failif((3540 != tcbptr->sndnxt), "Idle");
+    tcbptr->ocount = 1010;
+    tcpSendData(tcbptr);
+    failif((4540 != tcbptr->sndnxt), "Full");
+    tcbptr->sndflg &= ~TCP_FLG_CORK;
+    tcbptr->sndflg |= TCP_FLG_PUSH;
+    tcpSendData(tcbptr);
+    failif(((4550 != tcbptr->sndnxt) || (tcbptr->sndflg & TCP_FLG_PUSH)),
+           "Uncorked");
+
+    testPrint(verbose, "Segment sizes counted");
+    failif(((4 != tcbptr->seghist[0]) || (0 != tcbptr->seghist[1])
+            || (1 != tcbptr->seghist[2]) || (0 != tcbptr->seghist[3])
+            || (0 != tcbptr->seghist[4]) || (3 != tcbptr->seghist[5])), "");
+
+    /* Listening socket, taking free TCBs for connections from ipb */
+    nfree = 0;
+    for (i = 0; i < NTCP; i++)
+    {
+        if (TCP_FREE == tcptab[i].devstate)
+        {
+            nfree++;
+        }
+    }
+    lsnptr = memget(sizeof(struct tcb));
+    bzero(lsnptr, sizeof(struct tcb));
+    lsnptr->state = TCP_LISTEN;
+    lsnptr->localpt = 80;
+    netaddrcpy(&lsnptr->localip, &ipc);
+    lsnptr->backlog = 2;
+    lsnptr->synmax = 2;
+    lsnptr->accepts = semcreate(0);
+
+    /* Needs a TCB for each of three connections */
+    if (nfree >= 3)
+    {
+        testPrint(verbose, "Listener gives each SYN a TCB");
+        conns[0] = synRecv(lsnptr, &ipb, 6000);
+        conns[1] = synRecv(lsnptr, &ipb, 6001);
+        failif(((NULL == conns[0]) || (NULL == conns[1])), "No TCB");
+    }
+    if ((nfree >= 3) && (NULL != conns[0]) && (NULL != conns[1]))
+    {
+        failif(((2 != lsnptr->synlen) || (conns[0] == conns[1])
+                || (lsnptr != conns[1]->listener)
+                || (6001 != conns[1]->remotept)
+                || (TCP_ALLOC != conns[1]->devstate)
+                || (conns[0] != tcpDemux(80, 6000, &ipc, &ipb))), "");
+
+        testPrint(verbose, "Full SYN queue pushes out oldest");
+        conns[2] = synRecv(lsnptr, &ipb, 6002);
+        failif(((NULL == conns[2]) || (2 != lsnptr->synlen)
+                || (conns[1] != lsnptr->synq) || (1 != lsnptr->syndrops)
+                || (NULL != tcpDemux(80, 6000, &ipc, &ipb))), "");
+
+        testPrint(verbose, "Accept hands out established connection");
+        tcpListenEstab(conns[1]);
+        failif(((1 != lsnptr->acceptlen) || (1 != lsnptr->synlen)),
+               "Queued");
+        failif(((conns[1]->dev != tcpAccept(lsnptr))
+                || (NULL != conns[1]->listener)
+                || (0 != lsnptr->acceptlen)), "Accepted");
+
+        testPrint(verbose, "SYN dropped while accept queue is full");
+        lsnptr->backlog = 1;
+        if (NULL != conns[2])
+        {
+            tcpListenEstab(conns[2]);
+        }
+        failif(((NULL != tcpListenSyn(lsnptr, &ipb, 6003))
+                || (2 != lsnptr->syndrops)), "");
+
+        testPrint(verbose, "Closing listener frees queued connections");
+        tcpListenClose(lsnptr);
+        failif(((NULL != lsnptr->acceptq) || (0 != lsnptr->acceptlen)
+                || ((NULL != conns[2])
+                    && (TCP_FREE != conns[2]->devstate))), "");
+
+        wait(conns[1]->mutex);
+        tcpFree(conns[1]);
+    }
+    semfree(lsnptr->accepts);
+    memfree(lsnptr, sizeof(struct tcb));
+
+    /* TIME-WAIT, entered by a FIN in FIN-WAIT-2 from ipb:7000 */
+    twptr = memget(sizeof(struct tcb));
+    bzero(twptr, sizeof(struct tcb));
+    tcpBufAlloc(twptr);
+    twptr->state = TCP_FINWT2;
+    twptr->localpt = 80;
+    twptr->remotept = 7000;
+    netaddrcpy(&twptr->localip, &ipa);
+    netaddrcpy(&twptr->remoteip, &ipb);
+    twptr->rcvnxt = TCP_TEST_SEQ;
+    twptr->rcvwnd = TCP_TEST_SEQ + twptr->ilen;
+    twptr->sndnxt = 5000;
+    twptr->snduna = 5000;
+    twptr->rcvmss = TCP_INIT_MSS;
+    twptr->sndmss = TCP_INIT_MSS;
+    fixed = tcptwcount;
+
+    testPrint(verbose, "FIN in FIN-WAIT-2 leaves only TIME-WAIT entry");
+    dataSeg(twptr, pkt, TCP_TEST_SEQ, 0, TCP_CTRL_ACK | TCP_CTRL_FIN);
+    failif(((TCP_TIMEWT != twptr->state) || (fixed + 1 != tcptwcount)), "");
+    tcpBufFree(twptr);
+    memfree(twptr, sizeof(struct tcb));
+
+    testPrint(verbose, "TIME-WAIT answers FIN sent again");
+    failif((!timewaitSeg(pkt, &ipb, &ipa, 7000, TCP_TEST_SEQ,
+                         TCP_CTRL_ACK | TCP_CTRL_FIN)
+            || !timewaitSeg(pkt, &ipb, &ipa, 7000, TCP_TEST_SEQ + 1,
+                            TCP_CTRL_RST)
+            || timewaitSeg(pkt, &ipb, &ipa, 7001, TCP_TEST_SEQ,
+                           TCP_CTRL_ACK | TCP_CTRL_FIN)
+            || timewaitSeg(pkt, &ipc, &ipa, 7000, TCP_TEST_SEQ,
+                           TCP_CTRL_ACK | TCP_CTRL_FIN)), "");
+
+    testPrint(verbose, "New SYN ends TIME-WAIT");
+    failif((!timewaitSeg(pkt, &ipb, &ipa, 7000, TCP_TEST_SEQ,
+                         TCP_CTRL_SYN)
+            || timewaitSeg(pkt, &ipb, &ipa, 7000, TCP_TEST_SEQ + 5000,
+                           TCP_CTRL_SYN)
+            || (fixed != tcptwcount)
+            || timewaitSeg(pkt, &ipb, &ipa, 7000, TCP_TEST_SEQ,
+                           TCP_CTRL_ACK | TCP_CTRL_FIN)), "");
+
+    testPrint(verbose, "Full TIME-WAIT table drops oldest");
+    twptr = memget(sizeof(struct tcb));
+    bzero(twptr, sizeof(struct tcb));
+    twptr->localpt = 80;
+    netaddrcpy(&twptr->localip, &ipa);
+    netaddrcpy(&twptr->remoteip, &ipb);
+    twptr->rcvnxt = TCP_TEST_SEQ;
+    for (i = 0; i <= TCP_NTIMEWT; i++)
+    {
+        twptr->remotept = 7000 + i;
+        tcpTimewaitAdd(twptr);
+    }
+    failif(((TCP_NTIMEWT != tcptwcount)
+            || timewaitSeg(pkt, &ipb, &ipa, 7000, TCP_TEST_SEQ,
+                           TCP_CTRL_ACK | TCP_CTRL_FIN)
+            || !timewaitSeg(pkt, &ipb, &ipa, 7000 + TCP_NTIMEWT,
+                            TCP_TEST_SEQ, TCP_CTRL_ACK | TCP_CTRL_FIN)), "");
+    for (i = 0; i <= TCP_NTIMEWT; i++)
+    {
+        timewaitSeg(pkt, &ipb, &ipa, 7000 + i, TCP_TEST_SEQ + 5000,
+                    TCP_CTRL_SYN);
+    }
+    memfree(twptr, sizeof(struct tcb));
+
+    /* Non-blocking read and write on a TCB of its own, with data in its
+     * buffers wrapping around their ends */
+    dev = tcpAlloc();
+    if (SYSERR != dev)
+    {
+        devptr = (device *)&devtab[dev];
+        twptr = &tcptab[devptr->minor];
+        wait(twptr->mutex);
+        tcpSetup(twptr);
+        twptr->state = TCP_SYNRECV;
+        twptr->sndflg |= TCP_FLG_NONBLOCK;
+        twptr->istart = twptr->ilen - 100;
+        twptr->rcvwnd = seqadd(twptr->rcvnxt, twptr->ilen);
+        tcpRecvQueue(twptr, twptr->rcvnxt, data, 300);
+        signal(twptr->readers);
+        twptr->ostart = 200;
+        twptr->ocount = twptr->olen - 300;
+        signal(twptr->mutex);
+
+        testPrint(verbose, "Read copies across end of input buffer");
+        bzero(back, sizeof(back));
+        failif(((300 != tcpRead(devptr, back, sizeof(back)))
+                || (0 != memcmp(back, data, 300))
+                || (0 != twptr->icount) || (200 != twptr->istart)
+                || (0 != semcount(twptr->readers))), "");
+
+        testPrint(verbose, "Non-blocking read returns when empty");
+        failif((0 != tcpRead(devptr, back, sizeof(back))), "");
+
+        testPrint(verbose, "Write copies across end of output buffer");
+        failif(((300 != tcpWrite(devptr, data, sizeof(data)))
+                || (twptr->olen != twptr->ocount)
+                || (0 != memcmp(&twptr->out[twptr->olen - 100], data, 100))
+                || (0 != memcmp(twptr->out, &data[100], 200))
+                || (0 != semcount(twptr->writers))), "");
+
+        testPrint(verbose, "Non-blocking write returns when full");
+        failif((0 != tcpWrite(devptr, data, sizeof(data))), "");
+
+        /* Send a file after the full output buffer, into a zero window
+         * so nothing goes out */
+        wait(twptr->mutex);
+        twptr->state = TCP_ESTAB;
+        twptr->sndwnd = 0;
+        signal(twptr->mutex);
+
+        testPrint(verbose, "Sendfile queues file after buffered data");
+        failif(((300 != tcpSendfile(twptr, data, 300))
+                || (300 != twptr->sfcount)
+                || (twptr->olen + 300 != tcpOutPending(twptr))
+                || (0 != tcpSendfile(twptr, back, 100))
+                || (0 != tcpWrite(devptr, data, sizeof(data)))), "");
+
+        testPrint(verbose, "ACK moves from output buffer into file");
+        wait(twptr->mutex);
+        twptr->sndnxt = seqadd(twptr->snduna, tcpOutPending(twptr));
+        ackSeg(twptr, pkt, seqadd(twptr->snduna, twptr->olen + 100),
+               NULL, 0);
+        failif(((0 != twptr->ocount) || (200 != twptr->sfcount)
+                || (&data[100] != twptr->sfdata)
+                || (0 != semcount(twptr->writers))), "Into file");
+        ackSeg(twptr, pkt, twptr->sndnxt, NULL, 0);
+        failif(((0 != twptr->sfcount) || (1 != semcount(twptr->writers))),
+               "File done");
+
+        testPrint(verbose, "Read and write on closing connection fail");
+        twptr->state = TCP_LASTACK;
+        signal(twptr->mutex);
+        failif(((SYSERR != tcpRead(devptr, back, sizeof(back)))
+                || (TCP_ERR_CLOSING != tcpWrite(devptr, data, sizeof(data)))
+                || (1 != semcount(twptr->mutex))), "");
+        wait(twptr->mutex);
+        tcpFree(twptr);
+    }
+
+    tcpTimerPurge(tcbptr, NULL);
+    semfree(tcbptr->mutex);
+    semfree(tcbptr->writers);
+    semfree(tcbptr->readers);
+    tcpBufFree(tcbptr);
+    netFreebuf(pkt);
+    memfree(tcbptr, sizeof(struct tcb));
+
+    if (verbose)
+    {
+        demuxBench(8);
+        demuxBench(64);
+        demuxBench(256);
+#ifdef ELOOP
+        loopBench();
+#endif
+    }
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else
+    testSkip(TRUE, "");
+#endif                          /* NTCP */
+    return OK;
+}
+
+#if NTCP
+static void setip(struct netaddr *ip, uchar host)
+{
+    ip->type = NETADDR_IPv4;
+    ip->len = IPv4_ADDR_LEN;
+    ip->addr[0] = 192;
+    ip->addr[1] = 168;
+    ip->addr[2] = 1;
+    ip->addr[3] = host;
+}
+
+/**
+ * Check the octets ready for the user start with the expected data.
+ */
+static bool inCheck(struct tcb *tcbptr, uchar *data, uint len)
+{
+    uint i;
+
+    if (tcbptr->icount < len)
+    {
+        return FALSE;
+    }
+    for (i = 0; i < len; i++)
+    {
+        if (tcbptr->in[(tcbptr->istart + i) % tcbptr->ilen] != data[i])
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Hand a TCB an ACK that leaves the send window as it is, with SACK
+ * blocks if any are given.
+ */
+static void ackSeg(struct tcb *tcbptr, struct packet *pkt, tcpseq ack,
+                   struct tcpRange *blocks, uint nblk)
+{
+    struct tcpPkt *tcp;
+    uchar *opt;
+    uint optlen, i, j;
+
+    optlen = (nblk > 0) ? 4 + (nblk * TCP_OPT_SACK_BLK) : 0;
+    pkt->linkhdr = pkt->data;
+    pkt->curr = pkt->data;
+    pkt->len = TCP_HDR_LEN + optlen;
+    tcp = (struct tcpPkt *)pkt->curr;
+    bzero(tcp, TCP_HDR_LEN);
+    tcp->offset = octets2offset(TCP_HDR_LEN + optlen);
+    tcp->control = TCP_CTRL_ACK;
+    tcp->acknum = ack;
+    tcp->window = tcbptr->sndwnd >> tcbptr->sndwsc;
+
+    opt = tcp->data;
+    if (nblk > 0)
+    {
+        *opt++ = TCP_OPT_NOP;
+        *opt++ = TCP_OPT_NOP;
+        *opt++ = TCP_OPT_SACK;
+        *opt++ = 2 + (nblk * TCP_OPT_SACK_BLK);
+    }
+    for (i = 0; i < nblk; i++)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            opt[j] = blocks[i].start >> (24 - (j * 8));
+            opt[4 + j] = blocks[i].end >> (24 - (j * 8));
+        }
+        opt += TCP_OPT_SACK_BLK;
+    }
+
+    tcpRecvOpts(pkt, tcbptr);
+    tcpRecvAck(pkt, tcbptr);
+}
+
+/**
+ * Hand a TCB the options of a SYN, with a window scale option offering
+ * shift if it is not negative.
+ */
+static void synSeg(struct tcb *tcbptr, struct packet *pkt, int shift)
+{
+    struct tcpPkt *tcp;
+    uint optlen;
+
+    optlen = (shift < 0) ? 0 : 4;
+    pkt->linkhdr = pkt->data;
+    pkt->curr = pkt->data;
+    pkt->len = TCP_HDR_LEN + optlen;
+    tcp = (struct tcpPkt *)pkt->curr;
+    bzero(tcp, TCP_HDR_LEN);
+    tcp->offset = octets2offset(TCP_HDR_LEN + optlen);
+    tcp->control = TCP_CTRL_SYN;
+    if (shift >= 0)
+    {
+        tcp->data[0] = TCP_OPT_NOP;
+        tcp->data[1] = TCP_OPT_WSCALE;
+        tcp->data[2] = TCP_OPT_WSCALE_LEN;
+        tcp->data[3] = shift;
+    }
+
+    tcpRecvOpts(pkt, tcbptr);
+}
+
+/**
+ * Hand a TCB a segment of len octets of data.
+ */
+static void dataSeg(struct tcb *tcbptr, struct packet *pkt, tcpseq seq,
+                    uint len, uchar ctrl)
+{
+    struct tcpPkt *tcp;
+
+    pkt->linkhdr = pkt->data;
+    pkt->curr = pkt->data;
+    pkt->len = TCP_HDR_LEN + len;
+    tcp = (struct tcpPkt *)pkt->curr;
+    bzero(tcp, TCP_HDR_LEN);
+    tcp->offset = octets2offset(TCP_HDR_LEN);
+    tcp->control = ctrl;
+    tcp->seqnum = seq;
+    tcpRecvData(pkt, tcbptr);
+}
+
+/**
+ * Run a transfer paced by the advertised window for some round trips,
+ * the remote side sending a full window each round trip and the reader
+ * taking all of it before the next.
+ * @return count of octets received
+ */
+static uint windowRounds(struct tcb *tcbptr, struct packet *pkt,
+                         uint rounds)
+{
+    uint total, wnd, len;
+    tcpseq seq;
+
+    total = 0;
+    while (rounds-- > 0)
+    {
+        tcpSendWindow(tcbptr);
+        seq = tcbptr->rcvnxt;
+        wnd = tcpSeqdiff(tcbptr->rcvwnd, seq);
+        while (wnd > 0)
+        {
+            len = (wnd < tcbptr->rcvmss) ? wnd : tcbptr->rcvmss;
+            dataSeg(tcbptr, pkt, seq, len, TCP_CTRL_ACK);
+            seq = seqadd(seq, len);
+            wnd -= len;
+        }
+
+        /* Read everything, as tcpRead would */
+        total += tcbptr->icount;
+        tcbptr->istart = (tcbptr->istart + tcbptr->icount) % tcbptr->ilen;
+        tcbptr->icount = 0;
+        tcpBufTrim(tcbptr);
+    }
+
+    return total;
+}
+
+/**
+ * Hand a listener a SYN from ip and port, leaving the connection it
+ * makes waiting for the final ACK of the handshake.
+ */
+static struct tcb *synRecv(struct tcb *lsnptr, struct netaddr *ip,
+                           ushort port)
+{
+    struct tcb *tcbptr;
+
+    tcbptr = tcpListenSyn(lsnptr, ip, port);
+    if (NULL != tcbptr)
+    {
+        tcbptr->state = TCP_SYNRECV;
+        signal(tcbptr->mutex);
+    }
+    return tcbptr;
+}
+
+/**
+ * Hand the TIME-WAIT table a segment to port 80 from src and srcpt.
+ * @return TRUE if a TIME-WAIT entry handled it
+ */
+static bool timewaitSeg(struct packet *pkt, struct netaddr *src,
+                        struct netaddr *dst, ushort srcpt, tcpseq seq,
+                        uchar ctrl)
+{
+    struct tcpPkt *tcp;
+
+    pkt->linkhdr = pkt->data;
+    pkt->curr = pkt->data;
+    pkt->len = TCP_HDR_LEN;
+    tcp = (struct tcpPkt *)pkt->curr;
+    bzero(tcp, TCP_HDR_LEN);
+    tcp->offset = octets2offset(TCP_HDR_LEN);
+    tcp->control = ctrl;
+    tcp->srcpt = srcpt;
+    tcp->dstpt = 80;
+    tcp->seqnum = seq;
+    return tcpTimewaitRecv(pkt, src, dst);
+}
+
+/**
+ * Compare hashed demux against the old sweep over every TCB, which took
+ * and released each TCB's mutex, with ntcb established connections.
+ */
+static void demuxBench(int ntcb)
+{
+    struct tcpHashTab *tab;
+    struct tcpHashEnt *ents;
+    struct tcpHashEnt *ent;
+    struct netaddr local;
+    semaphore mutex;
+    ulong start, hash, sweep;
+    uint misses;
+    int i, j, k;
+
+    tab = memget(sizeof(struct tcpHashTab));
+    ents = memget(ntcb * sizeof(struct tcpHashEnt));
+    mutex = semcreate(1);
+    if ((SYSERR == (int)tab) || (SYSERR == (int)ents)
+        || (SYSERR == (int)mutex))
+    {
+        printf("    %d TCBs: no memory for benchmark\n", ntcb);
+        return;
+    }
+    bzero(tab, sizeof(struct tcpHashTab));
+    bzero(ents, ntcb * sizeof(struct tcpHashEnt));
+    setip(&local, 1);
+
+    for (i = 0; i < ntcb; i++)
+    {
+        ents[i].localpt = 80;
+        ents[i].remotept = 10000 + i;
+        netaddrcpy(&ents[i].localip, &local);
+        setip(&ents[i].remoteip, 2 + (i % 200));
+        tcpHashInsert(tab, &ents[i]);
+    }
+
+    /* Count lookups that miss, so neither loop can be optimised away */
+    misses = 0;
+    start = clkcount();
+    for (i = 0; i < TCP_BENCH_LOOKUPS; i++)
+    {
+        k = i % ntcb;
+        if (&ents[k] != tcpHashLookup(tab, 80, ents[k].remotept, &local,
+                                      &ents[k].remoteip))
+        {
+            misses++;
+        }
+    }
+    hash = clkcount() - start;
+
+    start = clkcount();
+    for (i = 0; i < TCP_BENCH_LOOKUPS; i++)
+    {
+        k = i % ntcb;
+        ent = NULL;
+        for (j = 0; j < ntcb; j++)
+        {
+            wait(mutex);
+            if ((ents[j].localpt == 80)
+                && (ents[j].remotept == ents[k].remotept)
+                && netaddrequal(&ents[j].localip, &local)
+                && netaddrequal(&ents[j].remoteip, &ents[k].remoteip))
+            {
+                ent = &ents[j];
+            }
+            signal(mutex);
+        }
+        if (ent != &ents[k])
+        {
+            misses++;
+        }
+    }
+    sweep = clkcount() - start;
+
+    printf("    %3d TCBs: hash %u cycles/lookup, sweep %u cycles/lookup\n",
+           ntcb, hash / TCP_BENCH_LOOKUPS, sweep / TCP_BENCH_LOOKUPS);
+    if (misses > 0)
+    {
+        printf("    %3d TCBs: %u lookups missed\n", ntcb, misses);
+    }
+
+    semfree(mutex);
+    memfree(ents, ntcb * sizeof(struct tcpHashEnt));
+    memfree(tab, sizeof(struct tcpHashTab));
+}
+
+#ifdef ELOOP
+/**
+ * Write len octets to a TCP device, a chunk at a time, then signal done.
+ */
+static thread benchWriter(int dev, uint len, semaphore done)
+{
+    uchar *buf;
+    uint i;
+
+    buf = memget(TCP_BENCH_CHUNK);
+    if (SYSERR != (int)buf)
+    {
+        for (i = 0; i < TCP_BENCH_CHUNK; i++)
+        {
+            buf[i] = i;
+        }
+        for (; len > 0; len -= TCP_BENCH_CHUNK)
+        {
+            if (TCP_BENCH_CHUNK != write(dev, buf, TCP_BENCH_CHUNK))
+            {
+                break;
+            }
+        }
+        memfree(buf, TCP_BENCH_CHUNK);
+    }
+    signal(done);
+    return OK;
+}
+
+/**
+ * Milliseconds since boot, to the resolution of the clock.
+ */
+static ulong benchTime(void)
+{
+    return (clktime * 1000) + (clkticks * (1000 / CLKTICKS_PER_SEC));
+}
+
+/**
+ * Measure throughput of a connection to ourselves through the ethernet
+ * loopback device, read and written a chunk at a time.
+ */
+static void loopBench(void)
+{
+    struct netaddr ip, mask, gate;
+    uchar *buf;
+    int lsn, cli, srv;
+    uint total, got;
+    ulong start, ms;
+    semaphore done;
+
+    setip(&ip, 6);
+    setip(&gate, 1);
+    setip(&mask, 0);
+    mask.addr[0] = mask.addr[1] = mask.addr[2] = 255;
+
+    buf = memget(TCP_BENCH_CHUNK);
+    done = semcreate(0);
+    if ((SYSERR == (int)buf) || (SYSERR == (int)done))
+    {
+        printf("    Loopback: no memory for benchmark\n");
+        return;
+    }
+    if ((SYSERR == open(ELOOP))
+        || (SYSERR == netUp(ELOOP, &ip, &mask, &gate)))
+    {
+        printf("    Loopback: no ethloop interface\n");
+        close(ELOOP);
+        semfree(done);
+        memfree(buf, TCP_BENCH_CHUNK);
+        return;
+    }
+
+    /* Listener and client both on the loopback address */
+    srv = SYSERR;
+    lsn = tcpAlloc();
+    if ((SYSERR != lsn)
+        && ((SYSERR == control(lsn, TCP_CTRL_LISTEN, 1, 0))
+            || (SYSERR == open(lsn, &ip, NULL, TCP_BENCH_PORT, NULL,
+                               TCP_PASSIVE))))
+    {
+        close(lsn);
+        lsn = SYSERR;
+    }
+    cli = (SYSERR == lsn) ? SYSERR : tcpAlloc();
+    if ((SYSERR != cli)
+        && (SYSERR == open(cli, &ip, &ip, NULL, TCP_BENCH_PORT,
+                           TCP_ACTIVE)))
+    {
+        cli = SYSERR;
+    }
+    if (SYSERR != cli)
+    {
+        srv = control(lsn, TCP_CTRL_ACCEPT, 0, 0);
+    }
+
+    if (SYSERR != srv)
+    {
+        total = TCP_BENCH_KBYTES << 10;
+        start = benchTime();
+        ready(create((void *)benchWriter, INITSTK, INITPRIO, "tcpBench",
+                     3, cli, total, done), RESCHED_YES);
+        for (got = 0; got < total; got += TCP_BENCH_CHUNK)
+        {
+            if (TCP_BENCH_CHUNK != read(srv, buf, TCP_BENCH_CHUNK))
+            {
+                break;
+            }
+        }
+        ms = benchTime() - start;
+        wait(done);
+        if (0 == ms)
+        {
+            ms = 1;
+        }
+        printf("    Loopback: %u KB in %u ms, %u KB/s\n", got >> 10, ms,
+               (got >> 10) * 1000 / ms);
+        close(cli);
+        close(srv);
+    }
+    else
+    {
+        printf("    Loopback: no connection\n");
+        if (SYSERR != cli)
+        {
+            close(cli);
+        }
+    }
+    if (SYSERR != lsn)
+    {
+        close(lsn);
+    }
+
+    netDown(ELOOP);
+    close(ELOOP);
+    semfree(done);
+    memfree(buf, TCP_BENCH_CHUNK);
+}
+#endif                          /* ELOOP */
+#endif                          /* NTCP */
@@ -217,6 +217,10 @@ thread test_udp(bool verbose)
            || (FALSE == netaddrequal(&udptab[0].remoteip, &ipzero))
            || (udptab[0].state != 0) || (udptab[0].flags != 0), "");
 
+    testPrint(verbose, "Closed UDP device not demultiplexed");
+    control(UDP0, UDP_CTRL_ACCEPT, pta, (long)&ipl);
+    failif((NULL != udpDemux(pta, ptb, &ipl, &ipc)), "");
+
     /* Test udpControl */
     testPrint(verbose, "UDP Control: Binding");
     /* Open UDP device to resume testing of that device */
@@ -432,6 +436,9 @@ thread test_udp(bool verbose)
      * DEVICES ARE OPEN BEFORE YOU CLOSE THEM!!!) */
     close(UDP0);
     close(UDP1);
+    testPrint(verbose, "UDP Demux after close");
+    failif((NULL != udpDemux(pta, ptb, &ipl, &ipc))
+           || (NULL != udpDemux(ptb, pta, &ipl, &ipc)), "");
 
     /* Print out the overall test's status (pass or fail) */
     if (passed)
@@ -44,6 +44,8 @@ struct testcase testtab[] = {
     {"UDP Sockets", test_udp},
     {"Raw Sockets", test_raw},
     {"IP", test_ip},
+    {"Route Lookup", test_route},
+    {"TCP Demux", test_tcp},
 #endif
     {"User Memory", test_umemory},
 #if USE_TLB